@@ -0,0 +1,71 @@
+/**
+ * bench_batch_invert.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <batch_invert.h>
+#include <jacobian_point.h>
+#include <modular_int.h>
+#include <named_curves.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Compare elementwise inversion against batch inversion, serial and parallel, over the P-256 field, and the
+// normalization of Jacobian points one at a time against all at once.
+int main() {
+    const auto &curve = curves::p256();
+    const auto &field = curve->get_field();
+
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    mpz_t r;
+    mpz_init(r);
+
+    for (const std::size_t n: {16, 256, 4096, 65536}) {
+        std::vector<ModularInt> elements;
+        elements.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            mpz_urandomm(r, state, static_cast<const mpz_t&>(field->modulus()));
+            elements.emplace_back(BigInt{r}, field);
+        }
+        const auto iterations = std::max<std::size_t>(1, 65536 / n);
+
+        const auto single = time_op(fmt::format("n={} invert", n), iterations, [&] {
+            for (const auto &m: elements)
+                do_not_optimize(m.invert());
+        });
+        const auto batch = time_op(fmt::format("n={} batch_invert", n), iterations, [&] {
+            auto copy = elements;
+            do_not_optimize(batch_invert(copy));
+        });
+        const auto parallel = time_op(fmt::format("n={} batch_invert_parallel", n), iterations, [&] {
+            auto copy = elements;
+            do_not_optimize(batch_invert_parallel(copy));
+        });
+        fmt::print("n={}: per element: invert {:.0f} ns, batch_invert {:.0f} ns, batch_invert_parallel {:.0f} ns\n",
+                   n, single / n, batch / n, parallel / n);
+    }
+    mpz_clear(r);
+    gmp_randclear(state);
+
+    std::vector<JacobianPoint> points{JacobianPoint{curve->generator()}};
+    for (std::size_t i = 1; i < 1024; ++i)
+        points.push_back(points.back() + curve->generator());
+    time_op("1024 points to_affine", 20, [&] {
+        for (const auto &p: points)
+            do_not_optimize(p.to_affine());
+    });
+    time_op("1024 points batch to_affine", 20, [&] { do_not_optimize(JacobianPoint::to_affine(points)); });
+    return report("bench_batch_invert");
+}
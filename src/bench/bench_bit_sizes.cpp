@@ -0,0 +1,109 @@
+/**
+ * bench_bit_sizes.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include <gmp.h>
+
+#include <big_int.h>
+#include <elliptic_curve.h>
+#include <jacobian_point.h>
+#include <modular_int.h>
+#include <point.h>
+#include <prime_field.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// The arithmetic behind everything else, with inputs from 64 to 4096 bits, so that regressions show up at the sizes
+// where they happen: the named curves only cover 256 to 521 bits.
+
+// A uniformly random number below the bound.
+static BigInt random_below(gmp_randstate_t state, const BigInt &bound) {
+    mpz_t value;
+    mpz_init(value);
+    mpz_urandomm(value, state, static_cast<const mpz_t&>(bound));
+    BigInt result{value};
+    mpz_clear(value);
+    return result;
+}
+
+// A random prime of exactly the given number of bits.
+static BigInt random_prime(gmp_randstate_t state, std::size_t bits) {
+    mpz_t value;
+    mpz_init(value);
+    do {
+        mpz_urandomb(value, state, bits);
+        mpz_setbit(value, bits - 1);
+        mpz_nextprime(value, value);
+    } while (mpz_sizeinbase(value, 2) != bits);
+    BigInt result{value};
+    mpz_clear(value);
+    return result;
+}
+
+static void bench_bits(gmp_randstate_t state, std::size_t bits) {
+    const auto p = random_prime(state, bits);
+    const auto field = PrimeField::get(p);
+    const auto x = random_below(state, p);
+    const auto y = random_below(state, p);
+
+    time_op("BigInt +", bits, scaled_iterations(1'000'000, bits, 1), [&] { do_not_optimize(x + y); });
+    time_op("BigInt *", bits, scaled_iterations(1'000'000, bits, 1), [&] { do_not_optimize(x * y); });
+    time_op("BigInt %", bits, scaled_iterations(1'000'000, bits, 1), [&] { do_not_optimize((x * y) % p); });
+
+    const ModularInt mx{x, field};
+    const ModularInt my{y, field};
+    const auto square = mx * mx;
+    const auto exponent = random_below(state, p);
+    time_op("ModularInt *", bits, scaled_iterations(1'000'000, bits, 1), [&] { do_not_optimize(mx * my); });
+    time_op("ModularInt pow", bits, scaled_iterations(100'000, bits, 3), [&] { do_not_optimize(mx.pow(exponent)); });
+    time_op("ModularInt invert", bits, scaled_iterations(200'000, bits, 2), [&] { do_not_optimize(mx.invert()); });
+    time_op("ModularInt legendre", bits, scaled_iterations(200'000, bits, 2), [&] { do_not_optimize(mx.legendre()); });
+    time_op("ModularInt sqrt", bits, scaled_iterations(50'000, bits, 3), [&] { do_not_optimize(square.sqrt()); });
+
+    // A random curve over the field, and a point on it found by trying x coordinates until the right hand side of
+    // the curve equation is a square.
+    std::optional<std::shared_ptr<const EllipticCurve>> curve;
+    while (!curve.has_value()) {
+        try {
+            curve = EllipticCurve::create(random_below(state, p), random_below(state, p), p);
+        } catch (const std::domain_error&) {
+            // Singular: try again.
+        }
+    }
+    std::optional<Point> q;
+    while (!q.has_value()) {
+        const ModularInt px{random_below(state, p), field};
+        if (const auto py = (*curve)->rhs(px).sqrt(); py.has_value())
+            q = (*curve)->point(px.get_value(), py->get_value());
+    }
+    const auto r = q->doubled();
+    const JacobianPoint jq{*q};
+    const JacobianPoint jr{r};
+    const auto k = random_below(state, p);
+    time_op("Point +", bits, scaled_iterations(100'000, bits, 2), [&] { do_not_optimize(*q + r); });
+    time_op("Point doubled", bits, scaled_iterations(100'000, bits, 2), [&] { do_not_optimize(q->doubled()); });
+    time_op("JacobianPoint +", bits, scaled_iterations(100'000, bits, 2), [&] { do_not_optimize(jq + jr); });
+    time_op("JacobianPoint + Point", bits, scaled_iterations(100'000, bits, 2), [&] { do_not_optimize(jq + r); });
+    time_op("JacobianPoint doubled", bits, scaled_iterations(100'000, bits, 2), [&] { do_not_optimize(jq.doubled()); });
+    time_op("JacobianPoint *", bits, scaled_iterations(5'000, bits, 3), [&] { do_not_optimize(jq * k); });
+}
+
+int main() {
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    for (const auto bits: bit_sizes)
+        bench_bits(state, bits);
+    gmp_randclear(state);
+    return report("bench_bit_sizes");
+}
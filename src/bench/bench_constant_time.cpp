@@ -0,0 +1,107 @@
+/**
+ * bench_constant_time.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <big_int.h>
+#include <constant_time.h>
+#include <ecdsa.h>
+#include <elliptic_curve.h>
+#include <fixed_base_table.h>
+#include <modular_int.h>
+#include <named_curves.h>
+#include <point.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// The constant-time operations of ecc::ct against their variable-time counterparts, and ECDSA signing in each mode,
+// to show what the constant-time mode costs.
+static void bench_curve(const std::string &name, const std::shared_ptr<const EllipticCurve> &curve,
+                        gmp_randstate_t state) {
+    const auto &field = curve->get_field();
+    const auto &order = *curve->order();
+    const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(order), 2);
+    mpz_t r;
+    mpz_init(r);
+    const auto random_below = [&](const BigInt &bound) {
+        mpz_urandomm(r, state, static_cast<const mpz_t&>(bound));
+        return BigInt{r};
+    };
+
+    const ModularInt x{random_below(field->modulus()), field};
+    const ModularInt y{random_below(field->modulus()), field};
+    const auto e = random_below(field->modulus());
+    const auto k = random_below(order);
+    const auto p = curve->generator() * random_below(order);
+
+    const auto mul = time_op(fmt::format("{} ModularInt *", name), 100000, [&] { do_not_optimize(x * y); });
+    const auto ct_mul = time_op(fmt::format("{} ct::mul", name), 100000, [&] { do_not_optimize(ct::mul(x, y)); });
+    compare(fmt::format("{} ct::mul vs *", name), 0, ct_mul, mul);
+
+    const auto invert = time_op(fmt::format("{} ModularInt::invert", name), 10000, [&] {
+        do_not_optimize(x.invert());
+    });
+    const auto ct_invert = time_op(fmt::format("{} ct::invert", name), 10000, [&] { do_not_optimize(ct::invert(x)); });
+    compare(fmt::format("{} ct::invert vs invert", name), 0, ct_invert, invert);
+
+    const auto pow = time_op(fmt::format("{} ModularInt::pow", name), 2000, [&] { do_not_optimize(x.pow(e)); });
+    const auto ct_pow = time_op(fmt::format("{} ct::pow", name), 2000, [&] {
+        do_not_optimize(ct::pow(x, e, mpz_sizeinbase(static_cast<const mpz_t&>(field->modulus()), 2)));
+    });
+    compare(fmt::format("{} ct::pow vs pow", name), 0, ct_pow, pow);
+
+    const auto multiply = time_op(fmt::format("{} Point *", name), 200, [&] { do_not_optimize(p * k); });
+    const auto ct_multiply = time_op(fmt::format("{} ct::multiply", name), 200, [&] {
+        do_not_optimize(ct::multiply(p, k, bits));
+    });
+    compare(fmt::format("{} ct::multiply vs *", name), 0, ct_multiply, multiply);
+
+    // Multiplication of the generator, with the tables of each kind.
+    (void)curve->precompute_generator(FixedBaseTable::default_width);
+    const auto fixed = time_op(fmt::format("{} multiply_generator", name), 1000, [&] {
+        do_not_optimize(curve->multiply_generator(k));
+    });
+    for (const unsigned width: {4u, 5u, ct::FixedBaseTable::default_width}) {
+        const ct::FixedBaseTable table{curve->generator(), bits, width};
+        const auto ct_fixed = time_op(fmt::format("{} ct::FixedBaseTable (w={}, {} points)", name, width, table.size()),
+                                      1000, [&] { do_not_optimize(table.multiply(k)); });
+        compare(fmt::format("{} ct::FixedBaseTable (w={}) vs multiply_generator", name, width), 0, ct_fixed, fixed);
+    }
+
+    // Signing in each mode, with the tables built.
+    (void)curve->precompute_generator_constant_time(ct::FixedBaseTable::default_width);
+    const auto d = random_below(order - BigInt{1}) + BigInt{1};
+    std::vector<std::uint8_t> digest(32);
+    for (std::size_t i = 0; i < digest.size(); ++i)
+        digest[i] = static_cast<std::uint8_t>(31 * i + 7);
+    const auto sign = time_op(fmt::format("{} sign", name), 500, [&] {
+        do_not_optimize(ecdsa::sign(curve, d, digest));
+    });
+    const auto ct_sign = time_op(fmt::format("{} sign (constant time)", name), 200, [&] {
+        do_not_optimize(ecdsa::sign(curve, d, digest, ecdsa::Mode::CONSTANT_TIME));
+    });
+    compare(fmt::format("{} constant-time sign vs sign", name), 0, ct_sign, sign);
+    mpz_clear(r);
+}
+
+int main() {
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    bench_curve("secp256k1", curves::secp256k1(), state);
+    bench_curve("P-256", curves::p256(), state);
+    gmp_randclear(state);
+    return report("bench_constant_time");
+}
@@ -0,0 +1,108 @@
+/**
+ * bench_ecdsa.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <ecdsa.h>
+#include <elliptic_curve.h>
+#include <fixed_base_table.h>
+#include <named_curves.h>
+#include <thread_pool.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Single-threaded signing and verification throughput, i.e. operations per second per core.
+static void bench_curve(const std::string &name, const std::shared_ptr<const EllipticCurve> &curve) {
+    constexpr std::size_t iterations = 500;
+
+    // Build the generator table up front, as a service would at startup.
+    (void)curve->precompute_generator(FixedBaseTable::default_width);
+
+    const auto [d, q] = ecdsa::generate_key(curve);
+    std::vector<std::uint8_t> digest(32);
+    for (std::size_t i = 0; i < digest.size(); ++i)
+        digest[i] = static_cast<std::uint8_t>(31 * i + 7);
+    const auto signature = ecdsa::sign(curve, d, digest);
+
+    const auto sign_ns = time_op(fmt::format("{} sign", name), iterations,
+                                 [&] { do_not_optimize(ecdsa::sign(curve, d, digest)); });
+    const auto verify_ns = time_op(fmt::format("{} verify", name), iterations,
+                                   [&] { do_not_optimize(ecdsa::verify(q, digest, signature)); });
+    fmt::print("{}: {:.0f} signatures/s, {:.0f} verifications/s per core\n", name, 1e9 / sign_ns, 1e9 / verify_ns);
+
+    // Batch verification of distinct keys and digests, amortized per signature.
+    for (const std::size_t n: {4, 64, 1024}) {
+        std::vector<std::vector<std::uint8_t>> digests;
+        digests.reserve(n);
+        std::vector<ecdsa::BatchEntry> entries;
+        entries.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto key = ecdsa::generate_key(curve);
+            const auto &batch_digest = digests.emplace_back(digest);
+            digests.back()[0] = static_cast<std::uint8_t>(i);
+            entries.push_back(ecdsa::BatchEntry{batch_digest, ecdsa::sign(curve, key.private_key, batch_digest),
+                                                key.public_key});
+        }
+        const auto batch_ns = time_op(fmt::format("{} verify_batch n={}", name, n), std::max<std::size_t>(1, 64 / n),
+                                      [&] { do_not_optimize(ecdsa::verify_batch(entries)); });
+        fmt::print("{}: batch of {}: {:.0f} verifications/s per core, {:.2f}x single verification\n",
+                   name, n, 1e9 * n / batch_ns, verify_ns * n / batch_ns);
+
+        // As read from the wire, without the parity of R, when they are verified one by one.
+        for (auto &entry: entries)
+            entry.signature.odd_y.reset();
+        const auto wire_ns = time_op(fmt::format("{} verify_batch n={} without parity", name, n),
+                                     std::max<std::size_t>(1, 64 / n),
+                                     [&] { do_not_optimize(ecdsa::verify_batch(entries)); });
+        fmt::print("{}: batch of {} without parity: {:.2f}x single verification\n",
+                   name, n, verify_ns * n / wire_ns);
+    }
+}
+
+// Parallel batch verification on pools of increasing size, to show how it scales with the number of cores.
+static void bench_scaling(const std::string &name, const std::shared_ptr<const EllipticCurve> &curve) {
+    constexpr std::size_t n = 8192;
+    const auto keys = ecdsa::generate_keys(curve, n);
+    std::vector<std::vector<std::uint8_t>> digests;
+    digests.reserve(n);
+    std::vector<ecdsa::BatchEntry> entries;
+    entries.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto &digest = digests.emplace_back(32, static_cast<std::uint8_t>(i));
+        digests.back()[1] = static_cast<std::uint8_t>(i >> 8);
+        entries.push_back(ecdsa::BatchEntry{digest, ecdsa::sign(curve, keys[i].private_key, digest),
+                                            keys[i].public_key});
+    }
+
+    double base_ns = 0;
+    const auto max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        ThreadPool pool{threads};
+        const auto ns = time_op(fmt::format("{} verify_batch_parallel n={} threads={}", name, n, threads), 1,
+                                [&] { do_not_optimize(ecdsa::verify_batch_parallel(entries, pool)); });
+        if (threads == 1)
+            base_ns = ns;
+        fmt::print("{}: {} threads: {:.0f} verifications/s, {:.2f}x one thread\n",
+                   name, threads, 1e9 * n / ns, base_ns / ns);
+    }
+}
+
+int main() {
+    bench_curve("secp256k1", curves::secp256k1());
+    bench_curve("P-256", curves::p256());
+    bench_scaling("secp256k1", curves::secp256k1());
+    return report("bench_ecdsa");
+}
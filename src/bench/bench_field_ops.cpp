@@ -0,0 +1,90 @@
+/**
+ * bench_field_ops.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <big_int.h>
+#include <expression.h>
+#include <modular_int.h>
+#include <prime_field.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+int main() {
+    constexpr std::size_t iterations = 1'000'000;
+
+    // The P-256 prime and two arbitrary elements.
+    const BigInt p256{"115792089210356248762697446949407573530086143415290314195533631308867097853951"};
+    const BigInt x{"48439561293906451759052585252797914202762949526041747995844080717082404635286"};
+    const BigInt y{"36134250956749795798585127919587881956611106672985015071877198253568414405109"};
+
+    time_op("BigInt +", iterations, [&] { do_not_optimize(x + y); });
+    time_op("BigInt -", iterations, [&] { do_not_optimize(x - y); });
+    time_op("BigInt *", iterations, [&] { do_not_optimize(x * y); });
+    time_op("BigInt %", iterations, [&] { do_not_optimize((x * y) % p256); });
+
+    const ModularInt mx{x, p256};
+    const ModularInt my{y, p256};
+    time_op("ModularInt +", iterations, [&] { do_not_optimize(mx + my); });
+    time_op("ModularInt -", iterations, [&] { do_not_optimize(mx - my); });
+    time_op("ModularInt *", iterations, [&] { do_not_optimize(mx * my); });
+
+    auto acc = mx;
+    time_op("ModularInt +=", iterations, [&] { acc += my; });
+    time_op("ModularInt -=", iterations, [&] { acc -= my; });
+    time_op("ModularInt *=", iterations, [&] { acc *= my; });
+    do_not_optimize(acc);
+
+    // The shape of the curve formulas, e.g. y3 = lambda (x1 - x3) - y1, with an operator per step, and as one
+    // expression that is reduced once.
+    using expr::lazy;
+    time_op("ModularInt x (y - x) - y", iterations, [&] { do_not_optimize(mx * (my - mx) - my); });
+    time_op("ModularInt x (y - x) - y, lazy", iterations, [&] {
+        do_not_optimize(expr::evaluate(lazy(mx) * (lazy(my) - mx) - my));
+    });
+    const ModularInt three{3, p256};
+    time_op("ModularInt x y y 3 - x", iterations, [&] { do_not_optimize(mx * my * my * three - mx); });
+    time_op("ModularInt x y y 3 - x, lazy", iterations, [&] {
+        do_not_optimize(expr::evaluate(lazy(mx) * my * my * 3 - mx));
+    });
+    time_op("ModularInt x (y - x) - y, lazy, in place", iterations, [&] {
+        expr::assign(acc, lazy(mx) * (lazy(my) - mx) - my);
+    });
+    do_not_optimize(acc);
+
+    // Serialization: the decimal strings that the string constructors parse, against fixed-length binary and hex.
+    const auto decimal = x.to_string();
+    const auto hex = x.to_hex();
+    std::vector<std::uint8_t> bytes(mx.get_field()->bytes());
+    time_op("BigInt to_string", iterations, [&] { do_not_optimize(x.to_string()); });
+    time_op("BigInt from string", iterations, [&] { do_not_optimize(BigInt{decimal}); });
+    time_op("BigInt to_hex", iterations, [&] { do_not_optimize(x.to_hex()); });
+    time_op("BigInt from_hex", iterations, [&] { do_not_optimize(BigInt::from_hex(hex)); });
+    time_op("ModularInt to_bytes", iterations, [&] { mx.to_bytes(bytes); do_not_optimize(bytes); });
+    time_op("ModularInt from_bytes", iterations,
+            [&] { do_not_optimize(ModularInt::from_bytes(bytes, mx.get_field())); });
+
+    // Square roots modulo primes of each shape that sqrt handles differently: P-256's p ≡ 3 (mod 4), 2^255 - 19
+    // with p ≡ 5 (mod 8), and P-224's p = 2^224 - 2^96 + 1, where 2^96 divides p - 1.
+    const BigInt sqrt_primes[] = {
+        p256,
+        BigInt{"57896044618658097711785492504343953926634992332820282019728792003956564819949"},
+        BigInt{"26959946667150639794667015087019630673557916260026308143510066298881"}
+    };
+    for (const auto &p: sqrt_primes) {
+        const auto square = ModularInt{x, p} * ModularInt{x, p};
+        time_op(fmt::format("ModularInt sqrt, p - 1 = q 2^{}", square.get_field()->tonelli_shanks().e), 2000,
+                [&] { do_not_optimize(square.sqrt()); });
+    }
+
+    return report("bench_field_ops");
+}
@@ -0,0 +1,92 @@
+/**
+ * bench_fixed_base_pow.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <big_int.h>
+#include <fixed_base_pow.h>
+#include <modular_int.h>
+#include <montgomery.h>
+#include <multi_pow.h>
+#include <named_curves.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Exponentiation of a fixed base with a precomputed table, and products of powers with multi_pow, against pow, over
+// the P-256 field and a 2048-bit prime field of the size used for finite field Diffie-Hellman. The exponents are the
+// size of the modulus. Also time a Montgomery squaring against a multiplication, for multi_pow's cost model.
+int main() {
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    mpz_t r;
+    mpz_init(r);
+
+    mpz_urandomb(r, state, 2048);
+    mpz_setbit(r, 2047);
+    mpz_nextprime(r, r);
+    const ModularInt large{1, BigInt{r}};
+
+    for (const auto &field: {curves::p256()->get_field(), large.get_field()}) {
+        const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(field->modulus()), 2);
+        const auto random = [&] {
+            mpz_urandomm(r, state, static_cast<const mpz_t&>(field->modulus()));
+            return BigInt{r};
+        };
+        const std::size_t iterations = bits > 1024 ? 50 : 2000;
+
+        std::vector<ModularInt> bases;
+        std::vector<BigInt> exponents;
+        for (std::size_t i = 0; i < 16; ++i) {
+            bases.emplace_back(random(), field);
+            exponents.push_back(random());
+        }
+
+        const auto &engine = field->montgomery();
+        std::vector<mp_limb_t> a(engine.limbs());
+        engine.to_montgomery(a.data(), bases[0].get_value());
+        const auto mul = time_op("Montgomery mul", bits, 100000, [&] { engine.mul(a.data(), a.data(), a.data()); });
+        const auto sqr = time_op("Montgomery sqr", bits, 100000, [&] { engine.sqr(a.data(), a.data()); });
+        compare("Montgomery sqr vs mul", bits, sqr, mul);
+
+        const auto pow = time_op("pow", bits, iterations, [&] { do_not_optimize(bases[0].pow(exponents[0])); });
+        time_op("FixedBasePow build", bits, iterations / 10 + 1, [&] {
+            do_not_optimize(FixedBasePow{bases[0], bits});
+        });
+        for (const unsigned width: {4u, FixedBasePow::default_width, 8u}) {
+            const FixedBasePow table{bases[0], bits, width};
+            const auto fixed = time_op(fmt::format("FixedBasePow pow (w={}, {} elements)", width, table.size()), bits,
+                                       iterations, [&] { do_not_optimize(table.pow(exponents[0])); });
+            compare(fmt::format("FixedBasePow pow (w={}) vs pow", width), bits, fixed, pow);
+        }
+
+        for (const std::size_t n: {2, 4, 16}) {
+            const std::span<const ModularInt> bs{bases.data(), n};
+            const std::span<const BigInt> es{exponents.data(), n};
+            const auto separate = time_op(fmt::format("n={} product of pows", n), bits, iterations / n + 1, [&] {
+                auto result = bs[0].pow(es[0]);
+                for (std::size_t i = 1; i < n; ++i)
+                    result *= bs[i].pow(es[i]);
+                do_not_optimize(result);
+            });
+            const auto multi = time_op(fmt::format("n={} multi_pow", n), bits, iterations / n + 1, [&] {
+                do_not_optimize(multi_pow(bs, es));
+            });
+            compare(fmt::format("n={} multi_pow vs product of pows", n), bits, multi, separate);
+        }
+    }
+
+    mpz_clear(r);
+    gmp_randclear(state);
+    return report("bench_fixed_base_pow");
+}
@@ -0,0 +1,95 @@
+/**
+ * bench_gmp_allocator.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <batch_invert.h>
+#include <gmp_allocator.h>
+#include <modular_int.h>
+#include <named_curves.h>
+#include <thread_pool.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Field arithmetic over P-256 on one thread and on every thread at once, with GMP's limbs in the pools of
+// install_gmp_allocator, or with GMP's default malloc if run with the argument "system". The allocator can only be
+// chosen once per process, so compare the output of the two runs.
+static constexpr std::size_t workload_size = 4096;
+
+int main(int argc, char *argv[]) {
+    const bool system = argc > 1 && std::string_view{argv[1]} == "system";
+    if (!system)
+        install_gmp_allocator();
+    const std::string mode = system ? "system" : "pools";
+
+    const auto &field = curves::p256()->get_field();
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    mpz_t r;
+    mpz_init(r);
+    std::vector<ModularInt> elements;
+    elements.reserve(workload_size);
+    for (std::size_t i = 0; i < workload_size; ++i) {
+        do {
+            mpz_urandomm(r, state, static_cast<const mpz_t&>(field->modulus()));
+        } while (mpz_sgn(r) == 0);
+        elements.emplace_back(BigInt{r}, field);
+    }
+    mpz_clear(r);
+    gmp_randclear(state);
+
+    // A chain of multiply-adds, each making two temporaries.
+    const auto chain = [&](std::size_t begin, std::size_t end) {
+        auto acc = elements[begin];
+        for (auto i = begin + 1; i < end; ++i)
+            acc = acc * elements[i] + elements[i - 1];
+        do_not_optimize(acc);
+    };
+
+    time_op(fmt::format("ModularInt * + ({})", mode), 200, [&] { chain(0, workload_size); });
+    if (!system) {
+        const auto before = allocation_stats();
+        chain(0, workload_size);
+        const auto used = allocation_stats() - before;
+        fmt::print("per multiply-add: {:.2f} allocations, {:.2f} reallocations, {:.4f} from the system\n",
+                   static_cast<double>(used.allocations) / (workload_size - 1),
+                   static_cast<double>(used.reallocations) / (workload_size - 1),
+                   static_cast<double>(used.system_allocations) / (workload_size - 1));
+    }
+
+    auto &pool = ThreadPool::global();
+    time_op(fmt::format("ModularInt * + on {} threads ({})", pool.size(), mode), 200, [&] {
+        pool.parallel_for(workload_size, 64, chain);
+    });
+
+    time_op(fmt::format("batch_invert ({})", mode), 200, [&] {
+        auto copy = elements;
+        do_not_optimize(batch_invert(copy));
+    });
+    if (!system)
+        time_op("batch_invert in an ArenaScope", 200, [&] {
+            std::vector<std::uint8_t> first(field->bytes());
+            {
+                ArenaScope arena;
+                auto copy = elements;
+                do_not_optimize(batch_invert(copy));
+                copy.front().to_bytes(first);
+            }
+            do_not_optimize(first);
+        });
+
+    return report("bench_gmp_allocator");
+}
@@ -0,0 +1,196 @@
+/**
+ * bench_gmp_overhead.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include <big_int.h>
+#include <modular_int.h>
+#include <prime_field.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// The same randomized workloads through BigInt and ModularInt, through mpz_class, and through the mpz functions
+// writing into a preallocated mpz_t, checking that all three agree, and reporting the cost of the library relative
+// to each. mpz_class allocates its results as BigInt does, so the first ratio is the cost of the abstraction itself,
+// and the second includes the cost of returning values rather than reusing storage.
+
+// The number of operand sets per size, cycled through so that no one input stays in cache.
+static constexpr std::size_t workload_size = 256;
+
+namespace {
+    struct Workload {
+        BigInt p;
+        std::shared_ptr<const PrimeField> field;
+        std::vector<BigInt> xs, ys, es;
+        std::vector<ModularInt> mxs, mys;
+        mpz_class zp;
+        std::vector<mpz_class> zxs, zys, zes;
+
+        Workload(gmp_randstate_t state, std::size_t bits) {
+            mpz_class value;
+            do {
+                mpz_urandomb(value.get_mpz_t(), state, bits);
+                mpz_setbit(value.get_mpz_t(), bits - 1);
+                mpz_nextprime(value.get_mpz_t(), value.get_mpz_t());
+            } while (mpz_sizeinbase(value.get_mpz_t(), 2) != bits);
+            zp = value;
+            p = BigInt{zp.get_str()};
+            field = PrimeField::get(p);
+
+            // Nonzero residues, so that every one has an inverse.
+            for (std::size_t i = 0; i < workload_size; ++i) {
+                for (auto *zs: {&zxs, &zys, &zes}) {
+                    do {
+                        mpz_urandomm(value.get_mpz_t(), state, zp.get_mpz_t());
+                    } while (value == 0);
+                    zs->push_back(value);
+                }
+                xs.emplace_back(zxs.back().get_str());
+                ys.emplace_back(zys.back().get_str());
+                es.emplace_back(zes.back().get_str());
+                mxs.emplace_back(xs.back(), field);
+                mys.emplace_back(ys.back(), field);
+            }
+        }
+    };
+
+    // The value of each kind of result, for the comparison.
+    mpz_srcptr value_of(const BigInt &b) {
+        return static_cast<const mpz_t&>(b);
+    }
+    mpz_srcptr value_of(const ModularInt &m) {
+        return value_of(m.get_value());
+    }
+    mpz_srcptr value_of(const std::optional<ModularInt> &m) {
+        return value_of(m->get_value());
+    }
+    mpz_srcptr value_of(const mpz_class &z) {
+        return z.get_mpz_t();
+    }
+}
+
+// Check that the three agree on every operand set, and then time and compare them.
+// Returns false if they disagree.
+template <typename Library, typename Class, typename Raw>
+static bool compare_op(const std::string &name, std::size_t bits, std::size_t iterations,
+                       Library &&library, Class &&cls, Raw &&raw) {
+    mpz_t out;
+    mpz_init(out);
+    for (std::size_t i = 0; i < workload_size; ++i) {
+        raw(out, i);
+        if (mpz_cmp(value_of(library(i)), out) != 0 || mpz_cmp(value_of(cls(i)), out) != 0) {
+            std::cerr << name << " (" << bits << " bits): results differ from GMP for operand set " << i << '\n';
+            mpz_clear(out);
+            return false;
+        }
+    }
+
+    std::size_t i = 0;
+    const auto library_ns = time_op(name, bits, iterations,
+                                    [&] { do_not_optimize(library(i++ % workload_size)); });
+    const auto class_ns = time_op(fmt::format("{} mpz_class", name), bits, iterations,
+                                  [&] { do_not_optimize(cls(i++ % workload_size)); });
+    const auto raw_ns = time_op(fmt::format("{} mpz_t", name), bits, iterations,
+                                [&] { raw(out, i++ % workload_size); do_not_optimize(out); });
+    compare(fmt::format("{} / mpz_class", name), bits, library_ns, class_ns);
+    compare(fmt::format("{} / mpz_t", name), bits, library_ns, raw_ns);
+    mpz_clear(out);
+    return true;
+}
+
+static bool bench_bits(gmp_randstate_t state, std::size_t bits) {
+    const Workload w{state, bits};
+    const auto p = w.zp.get_mpz_t();
+    const auto cheap = scaled_iterations(1'000'000, bits, 1);
+    const auto quadratic = scaled_iterations(200'000, bits, 2);
+    const auto cubic = scaled_iterations(100'000, bits, 3);
+
+    bool ok = true;
+    ok &= compare_op("BigInt +", bits, cheap,
+                     [&](std::size_t i) { return w.xs[i] + w.ys[i]; },
+                     [&](std::size_t i) { return mpz_class{w.zxs[i] + w.zys[i]}; },
+                     [&](mpz_t out, std::size_t i) { mpz_add(out, w.zxs[i].get_mpz_t(), w.zys[i].get_mpz_t()); });
+    ok &= compare_op("BigInt -", bits, cheap,
+                     [&](std::size_t i) { return w.xs[i] - w.ys[i]; },
+                     [&](std::size_t i) { return mpz_class{w.zxs[i] - w.zys[i]}; },
+                     [&](mpz_t out, std::size_t i) { mpz_sub(out, w.zxs[i].get_mpz_t(), w.zys[i].get_mpz_t()); });
+    ok &= compare_op("BigInt *", bits, cheap,
+                     [&](std::size_t i) { return w.xs[i] * w.ys[i]; },
+                     [&](std::size_t i) { return mpz_class{w.zxs[i] * w.zys[i]}; },
+                     [&](mpz_t out, std::size_t i) { mpz_mul(out, w.zxs[i].get_mpz_t(), w.zys[i].get_mpz_t()); });
+    ok &= compare_op("BigInt %", bits, cheap,
+                     [&](std::size_t i) { return (w.xs[i] * w.es[i]) % w.ys[i]; },
+                     [&](std::size_t i) { return mpz_class{(w.zxs[i] * w.zes[i]) % w.zys[i]}; },
+                     [&](mpz_t out, std::size_t i) {
+                         mpz_mul(out, w.zxs[i].get_mpz_t(), w.zes[i].get_mpz_t());
+                         mpz_tdiv_r(out, out, w.zys[i].get_mpz_t());
+                     });
+
+    ok &= compare_op("ModularInt +", bits, cheap,
+                     [&](std::size_t i) { return w.mxs[i] + w.mys[i]; },
+                     [&](std::size_t i) {
+                         mpz_class r{w.zxs[i] + w.zys[i]};
+                         if (r >= w.zp)
+                             r -= w.zp;
+                         return r;
+                     },
+                     [&](mpz_t out, std::size_t i) {
+                         mpz_add(out, w.zxs[i].get_mpz_t(), w.zys[i].get_mpz_t());
+                         if (mpz_cmp(out, p) >= 0)
+                             mpz_sub(out, out, p);
+                     });
+    ok &= compare_op("ModularInt *", bits, cheap,
+                     [&](std::size_t i) { return w.mxs[i] * w.mys[i]; },
+                     [&](std::size_t i) { return mpz_class{(w.zxs[i] * w.zys[i]) % w.zp}; },
+                     [&](mpz_t out, std::size_t i) {
+                         mpz_mul(out, w.zxs[i].get_mpz_t(), w.zys[i].get_mpz_t());
+                         mpz_mod(out, out, p);
+                     });
+    ok &= compare_op("ModularInt pow", bits, cubic,
+                     [&](std::size_t i) { return w.mxs[i].pow(w.es[i]); },
+                     [&](std::size_t i) {
+                         mpz_class r;
+                         mpz_powm(r.get_mpz_t(), w.zxs[i].get_mpz_t(), w.zes[i].get_mpz_t(), p);
+                         return r;
+                     },
+                     [&](mpz_t out, std::size_t i) {
+                         mpz_powm(out, w.zxs[i].get_mpz_t(), w.zes[i].get_mpz_t(), p);
+                     });
+    ok &= compare_op("ModularInt invert", bits, quadratic,
+                     [&](std::size_t i) { return w.mxs[i].invert(); },
+                     [&](std::size_t i) {
+                         mpz_class r;
+                         mpz_invert(r.get_mpz_t(), w.zxs[i].get_mpz_t(), p);
+                         return r;
+                     },
+                     [&](mpz_t out, std::size_t i) { mpz_invert(out, w.zxs[i].get_mpz_t(), p); });
+    return ok;
+}
+
+int main() {
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    bool ok = true;
+    for (const auto bits: bit_sizes)
+        ok &= bench_bits(state, bits);
+    gmp_randclear(state);
+
+    if (!ok)
+        return EXIT_FAILURE;
+    return report("bench_gmp_overhead");
+}
@@ -0,0 +1,80 @@
+/**
+ * bench_key_store.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <big_int.h>
+#include <elliptic_curve.h>
+#include <jacobian_point.h>
+#include <key_store.h>
+#include <named_curves.h>
+#include <point.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Loading a million public keys from decimal text, which is parsed and checked point by point, against mapping the
+// same keys from a KeyStore.
+int main() {
+    constexpr std::size_t keys = 1'000'000;
+    constexpr std::size_t batch = 4096;
+    const auto &curve = curves::p256();
+
+    // G, 2G, 3G, ..., normalized to affine a batch at a time.
+    std::vector<Point> points;
+    points.reserve(keys);
+    std::vector<JacobianPoint> jacobian;
+    auto running = JacobianPoint::infinity(curve);
+    while (points.size() < keys) {
+        jacobian.clear();
+        for (std::size_t i = 0; i < batch && points.size() + jacobian.size() < keys; ++i)
+            jacobian.push_back(running += curve->generator());
+        const auto affine = JacobianPoint::to_affine(jacobian);
+        points.insert(points.end(), affine.begin(), affine.end());
+    }
+
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto text_path = directory / "bench_key_store.txt";
+    const auto store_path = directory / "bench_key_store.bin";
+    {
+        std::ofstream text{text_path};
+        for (const auto &p: points)
+            text << p.x().get_value().to_string() << ' ' << p.y().get_value().to_string() << '\n';
+    }
+    KeyStore::write(store_path, curve, points);
+    fmt::print("{} keys: {} bytes as text, {} bytes as a KeyStore\n", keys,
+               std::filesystem::file_size(text_path), std::filesystem::file_size(store_path));
+
+    time_op("parse decimal text", 1, [&] {
+        std::ifstream text{text_path};
+        std::vector<Point> loaded;
+        loaded.reserve(keys);
+        std::string x, y;
+        while (text >> x >> y)
+            loaded.push_back(curve->point(BigInt{x}, BigInt{y}));
+        do_not_optimize(loaded);
+    });
+    time_op("KeyStore open", 100, [&] { do_not_optimize(KeyStore::open(store_path, curve)); });
+
+    // A key that is not there, so that the scan touches every record.
+    const auto store = KeyStore::open(store_path, curve);
+    const auto missing = -points.back();
+    time_op("KeyStore find, full scan", 10, [&] { do_not_optimize(store.find(missing)); });
+    time_op("KeyStore point", keys, [&, i = std::size_t{0}]() mutable {
+        do_not_optimize(store.point(i++ % keys));
+    });
+
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(store_path);
+    return report("bench_key_store");
+}
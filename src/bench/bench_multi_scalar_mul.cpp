@@ -0,0 +1,77 @@
+/**
+ * bench_multi_scalar_mul.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <big_int.h>
+#include <multi_scalar_mul.h>
+#include <named_curves.h>
+#include <point.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Sweep the number of terms n = 2, 4, ..., 2^max_log_n on secp256k1, comparing Straus, Pippenger, and the automatic
+// choice, to show where the crossover lies. The largest sizes take a while: pass a smaller max_log_n to skip them.
+int main(int argc, char **argv) {
+    const auto max_log_n = argc > 1 ? std::atoi(argv[1]) : 20;
+
+    // Straus's tables grow with n, and it is far behind Pippenger long before here.
+    constexpr std::size_t max_straus_n = std::size_t{1} << 12;
+
+    const auto &curve = curves::secp256k1();
+    const auto &order = *curve->order();
+    const auto max_n = std::size_t{1} << max_log_n;
+
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+
+    // The points are consecutive multiples of G, which are as good as random here and much cheaper to make.
+    std::vector<BigInt> scalars;
+    std::vector<Point> points;
+    scalars.reserve(max_n);
+    points.reserve(max_n);
+    mpz_t k;
+    mpz_init(k);
+    auto p = curve->generator();
+    for (std::size_t i = 0; i < max_n; ++i) {
+        mpz_urandomm(k, state, static_cast<const mpz_t&>(order));
+        scalars.emplace_back(k);
+        points.push_back(p);
+        p += curve->generator();
+    }
+    mpz_clear(k);
+    gmp_randclear(state);
+
+    for (std::size_t n = 2; n <= max_n; n <<= 1) {
+        const std::span<const BigInt> ks{scalars.data(), n};
+        const std::span<const Point> ps{points.data(), n};
+        const auto iterations = std::max<std::size_t>(1, 1024 / n);
+        const auto width = msm::straus_width(n, 256);
+        const auto window = msm::pippenger_window(n, 256);
+
+        double straus = 0;
+        if (n <= max_straus_n)
+            straus = time_op(fmt::format("n={} Straus w={}", n, width), iterations,
+                             [&] { do_not_optimize(msm::straus(ks, ps, width)); });
+        const auto pippenger = time_op(fmt::format("n={} Pippenger c={}", n, window), iterations,
+                                       [&] { do_not_optimize(msm::pippenger(ks, ps, window)); });
+        const auto automatic = time_op(fmt::format("n={} multi_scalar_mul", n), iterations,
+                                       [&] { do_not_optimize(multi_scalar_mul(ks, ps)); });
+        fmt::print("n={}: per term: Straus {:.1f} us, Pippenger {:.1f} us, multi_scalar_mul {:.1f} us\n",
+                   n, straus / 1000 / n, pippenger / 1000 / n, automatic / 1000 / n);
+    }
+    return report("bench_multi_scalar_mul");
+}
@@ -0,0 +1,58 @@
+/**
+ * bench_point_encoding.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <ecdsa.h>
+#include <elliptic_curve.h>
+#include <named_curves.h>
+#include <point.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// SEC 1 encoding and decoding of single points, and batch decompression of a large set of keys.
+static void bench_curve(const std::string &name, const std::shared_ptr<const EllipticCurve> &curve) {
+    constexpr std::size_t keys = 4096;
+    const auto pairs = ecdsa::generate_keys(curve, keys);
+    const auto &q = pairs.front().public_key;
+    const auto compressed = q.encode();
+    const auto uncompressed = q.encode(false);
+
+    time_op(fmt::format("{} encode compressed", name), 10000, [&] { do_not_optimize(q.encode()); });
+    time_op(fmt::format("{} encode uncompressed", name), 10000, [&] { do_not_optimize(q.encode(false)); });
+    time_op(fmt::format("{} decode compressed", name), 2000,
+            [&] { do_not_optimize(Point::decode(curve, compressed)); });
+    time_op(fmt::format("{} decode uncompressed", name), 2000,
+            [&] { do_not_optimize(Point::decode(curve, uncompressed)); });
+
+    std::vector<std::uint8_t> batch;
+    for (const auto &pair: pairs) {
+        const auto encoding = pair.public_key.encode();
+        batch.insert(batch.end(), encoding.begin(), encoding.end());
+    }
+    const auto size = compressed.size();
+    time_op(fmt::format("{} decode n={}", name, keys), 5, [&] {
+        for (std::size_t i = 0; i < keys; ++i)
+            do_not_optimize(Point::decode(curve, std::span{batch}.subspan(i * size, size)));
+    });
+    const auto ns = time_op(fmt::format("{} decompress_batch n={}", name, keys), 5,
+                            [&] { do_not_optimize(Point::decompress_batch(curve, batch)); });
+    fmt::print("{}: {:.0f} keys/s decompressed in a batch\n", name, 1e9 * keys / ns);
+}
+
+int main() {
+    bench_curve("secp256k1", curves::secp256k1());
+    bench_curve("P-256", curves::p256());
+    return report("bench_point_encoding");
+}
@@ -0,0 +1,68 @@
+/**
+ * bench_scalar_mul.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <big_int.h>
+#include <elliptic_curve.h>
+#include <fixed_base_table.h>
+#include <jacobian_point.h>
+#include <named_curves.h>
+#include <point.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// Compare plain double-and-add against wNAF at each window width, for a full-size scalar on the curve,
+// and then against fixed-base tables for the generator.
+static void bench_curve(const std::string &name, const std::shared_ptr<const EllipticCurve> &curve) {
+    constexpr std::size_t iterations = 200;
+
+    const JacobianPoint g{curve->generator()};
+    const auto k = *curve->order() - BigInt{"12345678901234567890123456789"};
+
+    time_op(fmt::format("{} double-and-add", name), iterations, [&] {
+        const auto &kv = static_cast<const mpz_t&>(k);
+        auto result = JacobianPoint::infinity(curve);
+        for (auto bit = mpz_sizeinbase(kv, 2); bit-- > 0;) {
+            result = result.doubled();
+            if (mpz_tstbit(kv, bit))
+                result += g;
+        }
+        do_not_optimize(result);
+    });
+
+    for (unsigned width = 2; width <= 8; ++width)
+        time_op(fmt::format("{} wNAF w={}", name, width), iterations, [&] { do_not_optimize(g.multiply(k, width)); });
+
+    time_op(fmt::format("{} operator*", name), iterations, [&] { do_not_optimize(g * k); });
+
+    // Multiplication of the generator by fixed-base tables of each width.
+    const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(*curve->order()), 2);
+    for (unsigned width = 4; width <= 10; width += 2) {
+        const auto start = std::chrono::steady_clock::now();
+        const FixedBaseTable table{curve->generator(), bits, width};
+        const auto build = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        fmt::print("{} fixed-base w={}: {} points, built in {:.1f} ms\n", name, width, table.size(), build.count());
+        time_op(fmt::format("{} fixed-base w={}", name, width), iterations * 10,
+                [&] { do_not_optimize(table.multiply(k)); });
+    }
+    time_op(fmt::format("{} multiply_generator", name), iterations * 10,
+            [&] { do_not_optimize(curve->multiply_generator(k)); });
+}
+
+int main() {
+    bench_curve("secp256k1", curves::secp256k1());
+    bench_curve("P-256", curves::p256());
+    return report("bench_scalar_mul");
+}
@@ -0,0 +1,158 @@
+/**
+ * bench_util.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <gmp.h>
+
+namespace ecc::bench {
+    // Keep the optimizer from discarding a result.
+    template <typename T>
+    inline void do_not_optimize(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // The input sizes for benchmarks parameterized by the number of bits.
+    inline constexpr std::size_t bit_sizes[] = {64, 128, 256, 512, 1024, 2048, 4096};
+
+    // Scale an iteration count at 64 bits down for an operation whose cost grows like bits^degree.
+    inline std::size_t scaled_iterations(std::size_t iterations, std::size_t bits, unsigned degree) {
+        auto count = static_cast<double>(iterations);
+        for (unsigned i = 0; i < degree; ++i)
+            count *= 64.0 / static_cast<double>(bits);
+        return std::max<std::size_t>(3, static_cast<std::size_t>(count));
+    }
+
+    // A timing from time_op, with the size of the inputs in bits, or 0 if the operation was not parameterized by one.
+    struct Result {
+        std::string name;
+        std::size_t bits;
+        std::size_t iterations;
+        double ns_per_op;
+    };
+
+    // Every timing taken by this process, in order.
+    inline std::vector<Result> &results() {
+        static std::vector<Result> all;
+        return all;
+    }
+
+    // Run f the given number of times, and print, record, and return the mean time per call in nanoseconds.
+    template <typename F>
+    double time_op(std::string_view name, std::size_t bits, std::size_t iterations, F &&f) {
+        // Warm up caches and the allocator.
+        for (std::size_t i = 0; i < iterations / 10 + 1; ++i)
+            f();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+            f();
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto ns = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+        std::cout << name;
+        if (bits != 0)
+            std::cout << " (" << bits << " bits)";
+        std::cout << ": " << ns << " ns/op\n";
+        results().push_back({std::string{name}, bits, iterations, ns});
+        return ns;
+    }
+
+    template <typename F>
+    double time_op(std::string_view name, std::size_t iterations, F &&f) {
+        return time_op(name, 0, iterations, std::forward<F>(f));
+    }
+
+    // The cost of an operation through the library relative to the same operation in bare GMP.
+    struct Comparison {
+        std::string name;
+        std::size_t bits;
+        double ratio;
+    };
+
+    // Every comparison made by this process, in order.
+    inline std::vector<Comparison> &comparisons() {
+        static std::vector<Comparison> all;
+        return all;
+    }
+
+    // Print and record the ratio of two timings from time_op.
+    inline double compare(std::string_view name, std::size_t bits, double ns, double baseline_ns) {
+        const auto ratio = ns / baseline_ns;
+        std::cout << name;
+        if (bits != 0)
+            std::cout << " (" << bits << " bits)";
+        std::cout << ": " << ratio << "x\n";
+        comparisons().push_back({std::string{name}, bits, ratio});
+        return ratio;
+    }
+
+    // A JSON string literal.
+    inline std::string json_string(std::string_view s) {
+        std::string quoted{"\""};
+        for (const auto c: s) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+                quoted += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof escape, "\\u%04x", c);
+                quoted += escape;
+            } else {
+                quoted += c;
+            }
+        }
+        return quoted + '"';
+    }
+
+    // If the environment variable ECC_BENCH_JSON names a file, write the results to it as JSON, so that runs can be
+    // compared across releases. The bench build target sets it for each benchmark. Returns the exit status for main.
+    inline int report(std::string_view benchmark) {
+        const auto path = std::getenv("ECC_BENCH_JSON");
+        if (path == nullptr || *path == '\0')
+            return EXIT_SUCCESS;
+
+        std::ofstream out{path};
+        out.precision(17);
+        out << "{\n  \"benchmark\": " << json_string(benchmark)
+            << ",\n  \"gmp_version\": " << json_string(gmp_version)
+            << ",\n  \"results\": [";
+        const auto &all = results();
+        for (std::size_t i = 0; i < all.size(); ++i)
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << json_string(all[i].name)
+                << ", \"bits\": " << all[i].bits
+                << ", \"iterations\": " << all[i].iterations
+                << ", \"ns_per_op\": " << all[i].ns_per_op << '}';
+        out << "\n  ]";
+
+        if (const auto &ratios = comparisons(); !ratios.empty()) {
+            out << ",\n  \"comparisons\": [";
+            for (std::size_t i = 0; i < ratios.size(); ++i)
+                out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << json_string(ratios[i].name)
+                    << ", \"bits\": " << ratios[i].bits
+                    << ", \"ratio\": " << ratios[i].ratio << '}';
+            out << "\n  ]";
+        }
+        out << "\n}\n";
+
+        if (!out) {
+            std::cerr << "Could not write benchmark results to " << path << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+}
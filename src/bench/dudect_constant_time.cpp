@@ -0,0 +1,189 @@
+/**
+ * dudect_constant_time.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gmp.h>
+
+#include <big_int.h>
+#include <constant_time.h>
+#include <modular_int.h>
+#include <named_curves.h>
+#include <point.h>
+
+#include "bench_util.h"
+
+using namespace ecc;
+using namespace ecc::bench;
+
+// A timing leakage test in the style of dudect (Reparaz, Balasch, and Verbauwhede, "Dude, is my code constant time?").
+// Each operation is timed many times on inputs from two classes, a fixed value and random values, in random order,
+// and Welch's t-test decides whether the two distributions of times differ. The test is repeated on the times below
+// several percentiles, as in dudect, to take out the long tail of interruptions.
+//
+// The constant-time operations of ecc::ct must show no leak, and the exit status is nonzero if one does. Their
+// variable-time counterparts are tested too, as a check that the test can see a leak. Pass a factor to scale the
+// number of measurements, e.g. 10 for a more sensitive run.
+
+// |t| above this is a leak beyond reasonable doubt.
+static constexpr double leak_threshold = 10.0;
+
+// dudect's threshold for a possible leak, which a longer run should settle.
+static constexpr double possible_leak_threshold = 4.5;
+
+static constexpr double percentiles[] = {0.5, 0.75, 0.9, 0.95, 0.99, 1.0};
+
+namespace {
+    // Welch's t-test, with the means and variances kept by Welford's method.
+    class TTest final {
+    public:
+        void add(int cls, double x) noexcept {
+            auto &s = stats[cls];
+            ++s.n;
+            const auto delta = x - s.mean;
+            s.mean += delta / s.n;
+            s.m2 += delta * (x - s.mean);
+        }
+
+        [[nodiscard]] double t() const noexcept {
+            const auto &[a, b] = stats;
+            if (a.n < 2 || b.n < 2)
+                return 0;
+            const auto variance = a.m2 / (a.n - 1) / a.n + b.m2 / (b.n - 1) / b.n;
+            return variance == 0 ? 0 : (a.mean - b.mean) / std::sqrt(variance);
+        }
+
+    private:
+        struct Stats {
+            double n = 0;
+            double mean = 0;
+            double m2 = 0;
+        };
+        Stats stats[2];
+    };
+}
+
+// Time op on measurements inputs from make(0), the fixed class, and make(1), the random class, and return the largest
+// |t| over the percentile crops.
+template <typename Make, typename Op>
+static double max_t(std::string_view name, std::size_t measurements, std::mt19937_64 &rng, Make &&make, Op &&op) {
+    std::vector<int> classes(measurements);
+    std::vector<decltype(make(0))> inputs;
+    inputs.reserve(measurements);
+    std::bernoulli_distribution coin;
+    for (auto &cls: classes) {
+        cls = coin(rng) ? 1 : 0;
+        inputs.push_back(make(cls));
+    }
+
+    // Warm up caches and the allocator on inputs of both classes.
+    for (std::size_t i = 0; i < std::min<std::size_t>(measurements, 32); ++i)
+        do_not_optimize(op(inputs[i]));
+
+    std::vector<double> times(measurements);
+    for (std::size_t i = 0; i < measurements; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        do_not_optimize(op(inputs[i]));
+        const auto end = std::chrono::steady_clock::now();
+        times[i] = std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    auto sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    double result = 0;
+    for (const auto percentile: percentiles) {
+        const auto cutoff = sorted[static_cast<std::size_t>(percentile * static_cast<double>(measurements - 1))];
+        TTest test;
+        for (std::size_t i = 0; i < measurements; ++i)
+            if (times[i] <= cutoff)
+                test.add(classes[i], times[i]);
+        result = std::max(result, std::abs(test.t()));
+    }
+
+    const auto verdict = result > leak_threshold ? "leak"
+        : result > possible_leak_threshold ? "possible leak" : "no leak detected";
+    fmt::print("{}: {} measurements, max |t| = {:.2f}: {}\n", name, measurements, result, verdict);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const auto scale = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
+    std::mt19937_64 rng{0x5eed};
+
+    const auto &curve = curves::p256();
+    const auto &field = curve->get_field();
+    const auto &order = *curve->order();
+    const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(order), 2);
+
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 0x5eed);
+    mpz_t r;
+    mpz_init(r);
+    const auto random_below = [&](const BigInt &bound) {
+        mpz_urandomm(r, state, static_cast<const mpz_t&>(bound));
+        return BigInt{r};
+    };
+
+    // The fixed classes are the values most likely to show a leak: p - 1 for the field operations, which makes
+    // every conditional correction happen, and 1 for exponents and scalars, which are as short and sparse as can be.
+    const auto p_minus_1 = field->modulus() - BigInt{1};
+    const auto fixed_element = [&](int cls) {
+        return ModularInt{cls == 0 ? p_minus_1 : random_below(field->modulus()), field};
+    };
+    const auto fixed_scalar = [&](int cls) {
+        return cls == 0 ? BigInt{1} : random_below(order);
+    };
+    const auto y = ModularInt{random_below(field->modulus()), field};
+    const auto g = curve->generator();
+
+    const auto field_measurements = 100000 * static_cast<std::size_t>(scale);
+    const auto pow_measurements = 5000 * static_cast<std::size_t>(scale);
+    const auto point_measurements = 500 * static_cast<std::size_t>(scale);
+
+    bool leaked = false;
+    const auto check = [&leaked](double t) {
+        leaked = leaked || t > leak_threshold;
+    };
+
+    check(max_t("ct::add", field_measurements, rng, fixed_element, [&](const ModularInt &x) {
+        return ct::add(x, y);
+    }));
+    check(max_t("ct::mul", field_measurements, rng, fixed_element, [&](const ModularInt &x) {
+        return ct::mul(x, y);
+    }));
+    check(max_t("ct::invert", pow_measurements, rng, fixed_element, [](const ModularInt &x) {
+        return ct::invert(x);
+    }));
+    check(max_t("ct::pow", pow_measurements, rng, fixed_scalar, [&](const BigInt &e) {
+        return ct::pow(y, e, bits);
+    }));
+    check(max_t("ct::multiply", point_measurements, rng, fixed_scalar, [&](const BigInt &k) {
+        return ct::multiply(g, k);
+    }));
+
+    fmt::print("\nThe variable-time counterparts, which are expected to leak:\n");
+    (void)max_t("ModularInt::invert", pow_measurements, rng, fixed_element, [](const ModularInt &x) {
+        return x.invert();
+    });
+    (void)max_t("ModularInt::pow", pow_measurements, rng, fixed_scalar, [&](const BigInt &e) {
+        return y.pow(e);
+    });
+    (void)max_t("Point::operator*", point_measurements, rng, fixed_scalar, [&](const BigInt &k) {
+        return g * k;
+    });
+
+    mpz_clear(r);
+    gmp_randclear(state);
+    return leaked ? EXIT_FAILURE : EXIT_SUCCESS;
+}
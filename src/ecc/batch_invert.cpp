@@ -0,0 +1,124 @@
+/**
+ * batch_invert.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <mutex>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+#include "formatters/modular_int_formatter.h"
+#include "batch_invert.h"
+
+namespace ecc {
+    // Below this many elements per chunk, the extra inversions cost more than the parallelism saves.
+    static constexpr std::size_t min_chunk_size = 1024;
+
+    static void check_same_field(std::span<const ModularInt> elements) {
+        if (elements.empty())
+            return;
+        const auto &field = elements.front().get_field();
+        for (const auto &m: elements)
+            if (m.get_field() != field)
+                throw std::domain_error(fmt::format("batch_invert given incompatible moduli: {} and {}.",
+                                                    elements.front(), m));
+    }
+
+    // Invert every element of the span, which must all be invertible, or return false if they are not, in which case
+    // the span is unchanged.
+    static bool invert_all(std::span<ModularInt> elements, std::vector<ModularInt> &prefix) {
+        if (elements.empty())
+            return true;
+
+        // prefix[i] = a_0 a_1 ... a_i.
+        prefix.clear();
+        prefix.reserve(elements.size());
+        prefix.push_back(elements.front());
+        for (std::size_t i = 1; i < elements.size(); ++i)
+            prefix.push_back(prefix.back() * elements[i]);
+
+        auto inverse = prefix.back().invert();
+        if (!inverse.has_value())
+            return false;
+
+        // Now inverse = (a_0 ... a_i)^-1, so a_i^-1 = inverse * prefix[i - 1], and stripping a_i from inverse
+        // leaves (a_0 ... a_(i-1))^-1.
+        for (auto i = elements.size() - 1; i > 0; --i) {
+            auto element_inverse = *inverse * prefix[i - 1];
+            *inverse *= elements[i];
+            elements[i] = std::move(element_inverse);
+        }
+        elements.front() = std::move(*inverse);
+        return true;
+    }
+
+    // Invert a span whose field has already been checked.
+    static std::vector<std::size_t> invert_checked(std::span<ModularInt> elements) {
+        // Zeros are the only non-invertible elements modulo a prime, so set them aside first.
+        std::vector<std::size_t> failures;
+        for (std::size_t i = 0; i < elements.size(); ++i)
+            if (elements[i].get_value().zero())
+                failures.push_back(i);
+
+        std::vector<ModularInt> prefix;
+        if (failures.empty()) {
+            if (invert_all(elements, prefix))
+                return failures;
+        } else {
+            std::vector<std::size_t> indices;
+            std::vector<ModularInt> invertible;
+            indices.reserve(elements.size() - failures.size());
+            invertible.reserve(elements.size() - failures.size());
+            for (std::size_t i = 0; i < elements.size(); ++i) {
+                if (!elements[i].get_value().zero()) {
+                    indices.push_back(i);
+                    invertible.push_back(elements[i]);
+                }
+            }
+            if (invert_all(invertible, prefix)) {
+                for (std::size_t j = 0; j < indices.size(); ++j)
+                    elements[indices[j]] = std::move(invertible[j]);
+                return failures;
+            }
+        }
+
+        // With a composite modulus, some nonzero element shares a factor with it: find out which one at a time.
+        // invert_all only writes to the span once it has succeeded, so the elements are still as they were.
+        for (std::size_t i = 0; i < elements.size(); ++i) {
+            if (elements[i].get_value().zero())
+                continue;
+            if (auto inverse = elements[i].invert(); inverse.has_value())
+                elements[i] = std::move(*inverse);
+            else
+                failures.push_back(i);
+        }
+        std::sort(failures.begin(), failures.end());
+        return failures;
+    }
+
+    std::vector<std::size_t> batch_invert(std::span<ModularInt> elements) {
+        check_same_field(elements);
+        return invert_checked(elements);
+    }
+
+    std::vector<std::size_t> batch_invert_parallel(std::span<ModularInt> elements, ThreadPool &pool) {
+        check_same_field(elements);
+
+        std::mutex failures_mutex;
+        std::vector<std::size_t> failures;
+        pool.parallel_for(elements.size(), min_chunk_size, [&](std::size_t begin, std::size_t end) {
+            const auto chunk_failures = invert_checked(elements.subspan(begin, end - begin));
+            std::lock_guard lock{failures_mutex};
+            for (const auto i: chunk_failures)
+                failures.push_back(begin + i);
+        });
+        std::sort(failures.begin(), failures.end());
+        return failures;
+    }
+}
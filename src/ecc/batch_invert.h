@@ -0,0 +1,26 @@
+/**
+ * batch_invert.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "modular_int.h"
+#include "thread_pool.h"
+
+namespace ecc {
+    // Replace each element of the span by its inverse, using Montgomery's trick: one real inversion and 3(n - 1)
+    // multiplications, rather than n inversions.
+    // Elements without an inverse are left as they are, and their indices are returned in increasing order, so a
+    // zero in the batch does not spoil the rest of it.
+    // If the elements do not all have the same modulus, std::domain_error is thrown and the span is unchanged.
+    std::vector<std::size_t> batch_invert(std::span<ModularInt>);
+
+    // As above, but split into chunks that are inverted concurrently on the pool, each with its own inversion.
+    // Small spans are not split.
+    std::vector<std::size_t> batch_invert_parallel(std::span<ModularInt>, ThreadPool &pool = ThreadPool::global());
+}
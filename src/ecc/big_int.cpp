@@ -7,9 +7,17 @@
 #include <iostream>
 #endif
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <fmt/core.h>
 #include <fmt/format.h>
@@ -22,6 +30,26 @@ namespace ecc {
     static const std::string div_error{"Division by zero."};
     static const std::string mod_error{"Modulus by zero."};
 
+    template <auto F>
+    BigInt BigInt::op() const {
+        BigInt result;
+        F(result.value, value);
+        return result;
+    }
+
+    template <auto F>
+    BigInt BigInt::op(const BigInt &other) const {
+        BigInt result;
+        F(result.value, value, other.value);
+        return result;
+    }
+
+    template <auto F>
+    BigInt &BigInt::op_set(const BigInt &other) {
+        F(value, value, other.value);
+        return *this;
+    }
+
     BigInt::BigInt() {
         mpz_init(value);
 #ifdef DEBUG
@@ -92,52 +120,67 @@ namespace ecc {
         return *this;
     }
 
+    BigInt BigInt::with_capacity(mp_bitcnt_t bits) {
+        BigInt result;
+        result.reserve(bits);
+        return result;
+    }
+
+    mp_bitcnt_t BigInt::capacity() const noexcept {
+        return static_cast<mp_bitcnt_t>(value->_mp_alloc) * GMP_NUMB_BITS;
+    }
+
+    void BigInt::reserve(mp_bitcnt_t bits) {
+        if (capacity() < bits)
+            mpz_realloc2(value, bits);
+    }
+
     BigInt BigInt::operator-() const {
-        return op(mpz_neg);
+        return op<mpz_neg>();
     }
 
     BigInt BigInt::operator+(const BigInt &other) const {
-        return op(mpz_add, other);
+        return op<mpz_add>(other);
     }
 
     BigInt BigInt::operator-(const BigInt &other) const {
-        return op(mpz_sub, other);
+        return op<mpz_sub>(other);
     }
 
     BigInt BigInt::operator*(const BigInt &other) const {
-        return op(mpz_mul, other);
+        return op<mpz_mul>(other);
     }
 
     BigInt BigInt::operator/(const BigInt &other) const {
         other.check(div_error);
-        return op(mpz_div, other);
+        return op<mpz_div>(other);
     }
 
     BigInt BigInt::operator%(const BigInt &other) const {
         other.check(mod_error);
-        return op(mpz_mod, other);
+        return op<mpz_mod>(other);
     }
 
     BigInt &BigInt::operator+=(const BigInt &other) {
-        return op_set(mpz_add, other);
+        return op_set<mpz_add>(other);
     }
 
     BigInt &BigInt::operator-=(const BigInt &other) {
-        return op_set(mpz_sub, other);
+        return op_set<mpz_sub>(other);
     }
 
     BigInt &BigInt::operator*=(const BigInt &other) {
-        return op_set(mpz_mul, other);
+        return op_set<mpz_mul>(other);
     }
 
     BigInt &BigInt::operator/=(const BigInt &other) {
         other.check(div_error);
-        return op_set(mpz_div, other);
+        return op_set<mpz_div>(other);
     }
 
     BigInt &BigInt::operator%=(const BigInt &other) {
         other.check(mod_error);
-        return op_set(mpz_mod, other);
+        return op_set<mpz_mod>(other);
     }
 
     BigInt &BigInt::operator++() {
@@ -204,6 +247,75 @@ namespace ecc {
         return mpz_tstbit(value, pos);
     }
 
+    std::vector<std::int8_t> BigInt::wnaf(unsigned width) const {
+        if (width < 2 || width > 8)
+            throw std::domain_error(fmt::format("wNAF width must be between 2 and 8: {}", width));
+
+        const long modulus = 1L << width;
+        const long half = modulus >> 1;
+        const int sign = mpz_sgn(value) < 0 ? -1 : 1;
+
+        // Recode |k|, and negate the digits at the end if k < 0.
+        BigInt k;
+        mpz_abs(k.value, value);
+
+        std::vector<std::int8_t> digits;
+        digits.reserve(mpz_sizeinbase(k.value, 2) + 1);
+        while (mpz_sgn(k.value) != 0) {
+            long digit = 0;
+            if (mpz_odd_p(k.value)) {
+                // The signed residue of k mod 2^w: subtracting it leaves k divisible by 2^w.
+                digit = static_cast<long>(mpz_getlimbn(k.value, 0) & static_cast<mp_limb_t>(modulus - 1));
+                if (digit >= half)
+                    digit -= modulus;
+                if (digit > 0)
+                    mpz_sub_ui(k.value, k.value, static_cast<unsigned long>(digit));
+                else
+                    mpz_add_ui(k.value, k.value, static_cast<unsigned long>(-digit));
+            }
+            digits.push_back(static_cast<std::int8_t>(sign * digit));
+            mpz_fdiv_q_2exp(k.value, k.value, 1);
+        }
+        return digits;
+    }
+
+    std::vector<std::array<std::int8_t, 2>> BigInt::joint_sparse_form(const BigInt &k0, const BigInt &k1) {
+        // Solinas's algorithm, on |k0| and |k1|, with the signs restored at the end.
+        const int signs[2] = {mpz_sgn(k0.value) < 0 ? -1 : 1, mpz_sgn(k1.value) < 0 ? -1 : 1};
+        BigInt k[2];
+        mpz_abs(k[0].value, k0.value);
+        mpz_abs(k[1].value, k1.value);
+
+        // d[i] is the pending carry into k[i], and l[i] = (k[i] + d[i]) mod 8.
+        int d[2] = {0, 0};
+        std::vector<std::array<std::int8_t, 2>> digits;
+        digits.reserve(std::max(mpz_sizeinbase(k[0].value, 2), mpz_sizeinbase(k[1].value, 2)) + 1);
+        while (mpz_sgn(k[0].value) != 0 || mpz_sgn(k[1].value) != 0 || d[0] != 0 || d[1] != 0) {
+            int l[2];
+            for (int i = 0; i < 2; ++i)
+                l[i] = static_cast<int>((mpz_getlimbn(k[i].value, 0) + static_cast<mp_limb_t>(d[i])) & 7);
+
+            int u[2];
+            for (int i = 0; i < 2; ++i) {
+                if (l[i] % 2 == 0) {
+                    u[i] = 0;
+                } else {
+                    u[i] = 2 - l[i] % 4;
+                    if ((l[i] == 3 || l[i] == 5) && l[1 - i] % 4 == 2)
+                        u[i] = -u[i];
+                }
+            }
+
+            for (int i = 0; i < 2; ++i) {
+                if (2 * d[i] == 1 + u[i])
+                    d[i] = 1 - d[i];
+                mpz_fdiv_q_2exp(k[i].value, k[i].value, 1);
+            }
+            digits.push_back({static_cast<std::int8_t>(signs[0] * u[0]), static_cast<std::int8_t>(signs[1] * u[1])});
+        }
+        return digits;
+    }
+
     bool BigInt::is_probably_prime(int tries) const {
         if (tries <= 0) {
             std::ostringstream str;
@@ -213,36 +325,84 @@ namespace ecc {
         return mpz_probab_prime_p(value, tries);
     }
 
-    std::string BigInt::to_string() const noexcept {
-        const auto char_array = mpz_get_str(nullptr, 10, value);
-        std::string str{char_array};
-        free(char_array);
-        return str;
+    std::size_t BigInt::byte_size() const noexcept {
+        if (mpz_sgn(value) == 0)
+            return 0;
+        return (mpz_sizeinbase(value, 2) + 7) / 8;
     }
 
-    BigInt::operator const mpz_t&() const {
-        return value;
-    }
+    void BigInt::to_bytes(std::span<std::uint8_t> out, Endian endian) const {
+        if (mpz_sgn(value) < 0)
+            throw std::domain_error(fmt::format("Cannot encode a negative number as bytes: {}", *this));
+        const auto size = byte_size();
+        if (size > out.size())
+            throw std::domain_error(fmt::format("{} needs {} bytes, but only {} are available.",
+                                                *this, size, out.size()));
 
-    void BigInt::check(const std::string &err_msg) const {
-        if (zero())
-            throw std::domain_error(err_msg);
+        // Work limb by limb: mpz_export and mpz_import with one-byte words go a byte at a time through a general loop.
+        const auto limbs = mpz_limbs_read(value);
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            const auto byte = i < size
+                ? static_cast<std::uint8_t>(limbs[i / sizeof(mp_limb_t)] >> (8 * (i % sizeof(mp_limb_t))))
+                : std::uint8_t{0};
+            out[endian == Endian::BIG ? out.size() - 1 - i : i] = byte;
+        }
     }
 
-    BigInt BigInt::op(const gmp_func1 &f) const {
+    BigInt BigInt::from_bytes(std::span<const std::uint8_t> in, Endian endian) {
         BigInt result;
-        f(result.value, value);
+        if (in.empty())
+            return result;
+
+        const auto count = (in.size() + sizeof(mp_limb_t) - 1) / sizeof(mp_limb_t);
+        const auto limbs = mpz_limbs_write(result.value, static_cast<mp_size_t>(count));
+        std::fill_n(limbs, count, mp_limb_t{0});
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            const mp_limb_t byte = in[endian == Endian::BIG ? in.size() - 1 - i : i];
+            limbs[i / sizeof(mp_limb_t)] |= byte << (8 * (i % sizeof(mp_limb_t)));
+        }
+
+        // mpz_limbs_finish strips the leading zero limbs.
+        mpz_limbs_finish(result.value, static_cast<mp_size_t>(count));
         return result;
     }
 
-    BigInt BigInt::op(const gmp_func2 &f, const BigInt &other) const {
+    std::string BigInt::to_hex() const {
+        return to_string(16);
+    }
+
+    BigInt BigInt::from_hex(std::string_view input_view) {
+        // mpz_set_str accepts whitespace, and needs a null-terminated string.
+        const auto digits = input_view.substr(!input_view.empty() && input_view.front() == '-' ? 1 : 0);
+        // std::isxdigit is undefined for negative values, which bytes of 0x80 and up are as a char.
+        const auto is_hex_digit = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+        if (digits.empty() || !std::all_of(digits.begin(), digits.end(), is_hex_digit))
+            throw std::domain_error(fmt::format("Not a valid hexadecimal number: {}", input_view));
+
+        const std::string str{input_view};
         BigInt result;
-        f(result.value, value, other.value);
+        mpz_set_str(result.value, str.c_str(), 16);
         return result;
     }
 
-    BigInt &BigInt::op_set(const gmp_func2 &f, const BigInt &other) {
-        f(value, value, other.value);
-        return *this;
+    std::string BigInt::to_string() const {
+        return to_string(10);
+    }
+
+    std::string BigInt::to_string(int base) const {
+        // mpz_sizeinbase may overestimate by one, and the sign needs a character, as does the terminator.
+        std::string str(mpz_sizeinbase(value, base) + 2, '\0');
+        mpz_get_str(str.data(), base, value);
+        str.resize(std::char_traits<char>::length(str.data()));
+        return str;
+    }
+
+    BigInt::operator const mpz_t&() const {
+        return value;
+    }
+
+    void BigInt::check(const std::string &err_msg) const {
+        if (zero())
+            throw std::domain_error(err_msg);
     }
 }
@@ -5,17 +5,34 @@
 
 #pragma once
 
-#include <functional>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include <gmp.h>
 
 namespace ecc {
     class ModularInt;
+    class PrimeField;
+    namespace expr {
+        struct Access;
+    }
 
     class BigInt {
         friend ModularInt;
+        friend PrimeField;
+        friend expr::Access;
     public:
+        // The byte order of a binary encoding.
+        enum class Endian {
+            BIG,
+            LITTLE,
+        };
+
         BigInt();
         BigInt(long);
         BigInt(const std::string_view&);
@@ -27,6 +44,16 @@ namespace ecc {
         BigInt &operator=(const BigInt&);
         BigInt &operator=(BigInt&&) noexcept;
 
+        // Zero, with room for values of up to the given number of bits, so that results up to that size are written
+        // without reallocating. Values otherwise grow as needed, one reallocation at a time.
+        [[nodiscard]] static BigInt with_capacity(mp_bitcnt_t);
+
+        // The number of bits that fit without reallocating.
+        [[nodiscard]] mp_bitcnt_t capacity() const noexcept;
+
+        // Make room for values of up to the given number of bits, keeping the value. This never shrinks.
+        void reserve(mp_bitcnt_t);
+
         [[nodiscard]] BigInt operator-() const;
         [[nodiscard]] BigInt operator+(const BigInt&) const;
         [[nodiscard]] BigInt operator-(const BigInt&) const;
@@ -67,20 +94,52 @@ namespace ecc {
         // Check the bit at position pos. If it is 0, return 0, and if 1, return 1.
         [[nodiscard]] int check_bit(int) const noexcept;
 
-        [[nodiscard]] std::string to_string() const noexcept;
+        // The width-w non-adjacent form of this number, least significant digit first. Every nonzero digit is odd
+        // with absolute value less than 2^(w-1), and of any w consecutive digits, at most one is nonzero.
+        // If the width is not between 2 and 8, std::domain_error is thrown.
+        [[nodiscard]] std::vector<std::int8_t> wnaf(unsigned width) const;
+
+        // The joint sparse form of a pair of numbers, least significant digit pair first. Each digit is -1, 0, or 1,
+        // and at most half of the digit pairs are nonzero on average, which makes it the best recoding for
+        // computing k0 P + k1 Q in one pass.
+        [[nodiscard]] static std::vector<std::array<std::int8_t, 2>> joint_sparse_form(const BigInt&, const BigInt&);
+
+        // The number of bytes needed to encode the absolute value of this number, which is 0 for zero.
+        [[nodiscard]] std::size_t byte_size() const noexcept;
+
+        // Write this number into the whole of the buffer as a fixed-length unsigned integer, padded with zeros.
+        // If the number is negative or does not fit, std::domain_error is thrown and the buffer is unchanged.
+        void to_bytes(std::span<std::uint8_t>, Endian = Endian::BIG) const;
+
+        // Read an unsigned integer from the bytes.
+        [[nodiscard]] static BigInt from_bytes(std::span<const std::uint8_t>, Endian = Endian::BIG);
+
+        // Lower case hexadecimal, with no prefix, and a leading '-' if negative.
+        [[nodiscard]] std::string to_hex() const;
+
+        // Parse hexadecimal in either case, with an optional leading '-' and no prefix.
+        // If the input is not a valid hexadecimal number, std::domain_error is thrown.
+        [[nodiscard]] static BigInt from_hex(std::string_view);
+
+        [[nodiscard]] std::string to_string() const;
         [[nodiscard]] explicit operator const mpz_t&() const;
 
     private:
         mpz_t value;
 
-        using gmp_func1 = std::function<void(mpz_ptr, mpz_srcptr)>;
-        using gmp_func2 = std::function<void(mpz_ptr, mpz_srcptr, mpz_srcptr)>;
+        // Format in the given base directly into a string, rather than copying out of a buffer from mpz_get_str.
+        [[nodiscard]] std::string to_string(int base) const;
 
         // Raises a domain_error if this is zero for div and _mod operations.
         void check(const std::string&) const;
 
-        [[nodiscard]] BigInt op(const gmp_func1&) const;
-        [[nodiscard]] BigInt op(const gmp_func2&, const BigInt&) const;
-        [[nodiscard]] BigInt &op_set(const gmp_func2&, const BigInt&);
+        // The GMP function is a template parameter rather than a runtime argument so that the call is direct
+        // and can be inlined. These are only instantiated in big_int.cpp.
+        template <auto F>
+        [[nodiscard]] BigInt op() const;
+        template <auto F>
+        [[nodiscard]] BigInt op(const BigInt&) const;
+        template <auto F>
+        BigInt &op_set(const BigInt&);
     };
 }
@@ -0,0 +1,377 @@
+/**
+ * constant_time.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "formatters/modular_int_formatter.h"
+#include "constant_time.h"
+#include "elliptic_curve.h"
+#include "expression.h"
+#include "jacobian_point.h"
+#include "montgomery.h"
+#include "prime_field.h"
+
+namespace ecc::ct {
+    // The value of a, which must fit, in exactly n limbs, padded with zeros.
+    static std::vector<mp_limb_t> limbs_of(const BigInt &a, std::size_t n) {
+        const auto &value = static_cast<const mpz_t&>(a);
+        const auto size = mpz_size(value);
+        std::vector<mp_limb_t> limbs(n);
+        mpn_copyi(limbs.data(), mpz_limbs_read(value), static_cast<mp_size_t>(size));
+        return limbs;
+    }
+
+    // The element of the field held in n limbs, which is already reduced.
+    static ModularInt element_of(const mp_limb_t *limbs, std::size_t n, std::shared_ptr<const PrimeField> field) {
+        auto result = expr::Access::element(std::move(field));
+        const auto value = expr::Access::value(result);
+        mpn_copyi(mpz_limbs_write(value, static_cast<mp_size_t>(n)), limbs, static_cast<mp_size_t>(n));
+        mpz_limbs_finish(value, static_cast<mp_size_t>(n));
+        return result;
+    }
+
+    static void check_same_field(const ModularInt &a, const ModularInt &b) {
+        if (a.get_field() != b.get_field())
+            throw std::domain_error(fmt::format("Computation attempted with incompatible ModularInts: {} and {}.",
+                                                a, b));
+    }
+
+    // Invert the n limbs of a, which are destroyed, into rp. This takes the same time for every a, including those
+    // that have no inverse.
+    static bool invert_limbs(mp_limb_t *rp, mp_limb_t *ap, const Montgomery &engine) {
+        const auto n = static_cast<mp_size_t>(engine.limbs());
+        std::vector<mp_limb_t> scratch(static_cast<std::size_t>(mpn_sec_invert_itch(n)));
+        return mpn_sec_invert(rp, ap, engine.modulus(), n, 2 * engine.limbs() * GMP_NUMB_BITS, scratch.data()) != 0;
+    }
+
+    ModularInt element(const BigInt &a, std::shared_ptr<const PrimeField> field) {
+        const auto &engine = field->montgomery();
+        const auto n = engine.limbs();
+        const auto &value = static_cast<const mpz_t&>(a);
+        if (mpz_sgn(value) < 0 || mpz_size(value) > n)
+            throw std::domain_error(fmt::format("Constant-time element is out of range modulo {}.", field->modulus()));
+
+        // a < p iff a - p borrows.
+        const auto limbs = limbs_of(a, n);
+        std::vector<mp_limb_t> difference(n);
+        if (mpn_sub_n(difference.data(), limbs.data(), engine.modulus(), static_cast<mp_size_t>(n)) == 0)
+            throw std::domain_error(fmt::format("Constant-time element is out of range modulo {}.", field->modulus()));
+        return element_of(limbs.data(), n, std::move(field));
+    }
+
+    ModularInt pow(const ModularInt &a, const BigInt &e, std::size_t bits) {
+        const auto &field = a.get_field();
+        const auto &engine = field->montgomery();
+        const auto &ev = static_cast<const mpz_t&>(e);
+        if (mpz_sgn(ev) < 0 || (mpz_sgn(ev) > 0 && mpz_sizeinbase(ev, 2) > bits))
+            throw std::domain_error(fmt::format("Constant-time pow for {}-bit exponents cannot raise to {}", bits, e));
+
+        // mpn_sec_powm needs at least one bit of exponent.
+        const auto n = engine.limbs();
+        const auto exponent_bits = std::max<std::size_t>(bits, 1);
+        const auto base = limbs_of(a.get_value(), n);
+        const auto exponent = limbs_of(e, (exponent_bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+        std::vector<mp_limb_t> result(n);
+        std::vector<mp_limb_t> scratch(static_cast<std::size_t>(
+            mpn_sec_powm_itch(static_cast<mp_size_t>(n), exponent_bits, static_cast<mp_size_t>(n))));
+        mpn_sec_powm(result.data(), base.data(), static_cast<mp_size_t>(n), exponent.data(), exponent_bits,
+                     engine.modulus(), static_cast<mp_size_t>(n), scratch.data());
+        return element_of(result.data(), n, field);
+    }
+
+    std::optional<ModularInt> invert(const ModularInt &a) {
+        const auto &field = a.get_field();
+        const auto &engine = field->montgomery();
+        const auto n = engine.limbs();
+        auto value = limbs_of(a.get_value(), n);
+        std::vector<mp_limb_t> result(n);
+        if (!invert_limbs(result.data(), value.data(), engine))
+            return std::nullopt;
+        return element_of(result.data(), n, field);
+    }
+
+    ModularInt add(const ModularInt &a, const ModularInt &b) {
+        check_same_field(a, b);
+        const auto &field = a.get_field();
+        const auto &engine = field->montgomery();
+        const auto n = engine.limbs();
+        auto result = limbs_of(a.get_value(), n);
+        engine.sec_add(result.data(), result.data(), limbs_of(b.get_value(), n).data());
+        return element_of(result.data(), n, field);
+    }
+
+    ModularInt mul(const ModularInt &a, const ModularInt &b) {
+        check_same_field(a, b);
+        const auto &field = a.get_field();
+        const auto &engine = field->montgomery();
+        const auto n = engine.limbs();
+
+        // aR b R^{-1} = ab, so only one of the two needs to be converted.
+        std::vector<mp_limb_t> result(n);
+        std::vector<mp_limb_t> scratch(engine.sec_itch());
+        engine.sec_to_montgomery(result.data(), limbs_of(a.get_value(), n).data(), scratch.data());
+        engine.sec_mul(result.data(), result.data(), limbs_of(b.get_value(), n).data(), scratch.data());
+        return element_of(result.data(), n, field);
+    }
+
+    namespace {
+        // The complete formulas for y^2 = x^3 + ax + b in projective coordinates (X : Y : Z), for x = X / Z and
+        // y = Y / Z, from Renes, Costello, and Batina, "Complete addition formulas for prime order elliptic curves",
+        // algorithms 1 and 3. A point is held as X, Y, Z in 3n contiguous limbs in Montgomery form, so that two
+        // points can be swapped with a single mpn_cnd_swap. The formulas hold all the space their arithmetic needs,
+        // so that a scalar multiplication allocates nothing after setting them up.
+        class CompleteFormulas final {
+        public:
+            CompleteFormulas(const Montgomery &engine, const EllipticCurve &curve):
+                engine{engine}, n{engine.limbs()}, a(n), b3(n), work(9 * n), scratch(engine.sec_itch()) {
+                engine.sec_to_montgomery(a.data(), limbs_of(curve.a().get_value(), n).data(), scratch.data());
+                std::vector<mp_limb_t> b(n);
+                engine.sec_to_montgomery(b.data(), limbs_of(curve.b().get_value(), n).data(), scratch.data());
+                engine.sec_add(b3.data(), b.data(), b.data());
+                engine.sec_add(b3.data(), b3.data(), b.data());
+            }
+
+            // R = (x : y : 1) for the affine point (x, y).
+            void from_affine(mp_limb_t *r, const ModularInt &x, const ModularInt &y) {
+                engine.sec_to_montgomery(r, limbs_of(x.get_value(), n).data(), scratch.data());
+                engine.sec_to_montgomery(r + n, limbs_of(y.get_value(), n).data(), scratch.data());
+                mpn_copyi(r + 2 * n, engine.one(), static_cast<mp_size_t>(n));
+            }
+
+            // R = P + Q, where R may be P or Q.
+            void add(mp_limb_t *r, const mp_limb_t *p, const mp_limb_t *q) {
+                const auto x1 = p, y1 = p + n, z1 = p + 2 * n;
+                const auto x2 = q, y2 = q + n, z2 = q + 2 * n;
+                const auto [t0, t1, t2, t3, t4, t5, x3, y3, z3] = temporaries();
+
+                mul(t0, x1, x2); mul(t1, y1, y2); mul(t2, z1, z2);
+                plus(t3, x1, y1); plus(t4, x2, y2); mul(t3, t3, t4);
+                plus(t4, t0, t1); minus(t3, t3, t4); plus(t4, x1, z1);
+                plus(t5, x2, z2); mul(t4, t4, t5); plus(t5, t0, t2);
+                minus(t4, t4, t5); plus(t5, y1, z1); plus(x3, y2, z2);
+                mul(t5, t5, x3); plus(x3, t1, t2); minus(t5, t5, x3);
+                mul(z3, a.data(), t4); mul(x3, b3.data(), t2); plus(z3, x3, z3);
+                minus(x3, t1, z3); plus(z3, t1, z3); mul(y3, x3, z3);
+                plus(t1, t0, t0); plus(t1, t1, t0); mul(t2, a.data(), t2);
+                mul(t4, b3.data(), t4); plus(t1, t1, t2); minus(t2, t0, t2);
+                mul(t2, a.data(), t2); plus(t4, t4, t2); mul(t0, t1, t4);
+                plus(y3, y3, t0); mul(t0, t5, t4); mul(x3, t3, x3);
+                minus(x3, x3, t0); mul(t0, t3, t1); mul(z3, t5, z3);
+                plus(z3, z3, t0);
+
+                mpn_copyi(r, x3, static_cast<mp_size_t>(3 * n));
+            }
+
+            // R = 2P, where R may be P.
+            void dbl(mp_limb_t *r, const mp_limb_t *p) {
+                const auto x = p, y = p + n, z = p + 2 * n;
+                const auto [t0, t1, t2, t3, unused, t5, x3, y3, z3] = temporaries();
+
+                sqr(t0, x); sqr(t1, y); sqr(t2, z);
+                mul(t3, x, y); plus(t3, t3, t3); mul(z3, x, z);
+                plus(z3, z3, z3); mul(x3, a.data(), z3); mul(y3, b3.data(), t2);
+                plus(y3, x3, y3); minus(x3, t1, y3); plus(y3, t1, y3);
+                mul(y3, x3, y3); mul(x3, t3, x3); mul(z3, b3.data(), z3);
+                mul(t2, a.data(), t2); minus(t3, t0, t2); mul(t3, a.data(), t3);
+                plus(t3, t3, z3); plus(z3, t0, t0); plus(t0, z3, t0);
+                plus(t0, t0, t2); mul(t0, t0, t3); plus(y3, y3, t0);
+                mul(t2, y, z); plus(t2, t2, t2); mul(t0, t2, t3);
+                minus(x3, x3, t0); mul(z3, t2, t1); plus(z3, z3, z3);
+                plus(z3, z3, z3);
+
+                mpn_copyi(r, x3, static_cast<mp_size_t>(3 * n));
+            }
+
+            // The affine point for P. Only the result can be the point at infinity, so that is branched on.
+            [[nodiscard]] Point to_point(const std::shared_ptr<const EllipticCurve> &curve, const mp_limb_t *p) {
+                const auto [z, z_inverse, x, y, t4, t5, t6, t7, t8] = temporaries();
+                engine.sec_from_montgomery(z, p + 2 * n);
+                if (!invert_limbs(z_inverse, z, engine))
+                    return curve->infinity();
+
+                // XR z^{-1} R^{-1} = x.
+                mul(x, p, z_inverse);
+                mul(y, p + n, z_inverse);
+                const auto &field = curve->get_field();
+                return Point{curve, element_of(x, n, field), element_of(y, n, field)};
+            }
+
+        private:
+            const Montgomery &engine;
+            const std::size_t n;
+            std::vector<mp_limb_t> a;
+            std::vector<mp_limb_t> b3;
+
+            // t0, ..., t5, X3, Y3, and Z3, with X3, Y3, and Z3 last and contiguous, to be copied out as a point.
+            std::vector<mp_limb_t> work;
+
+            // The scratch for the products.
+            std::vector<mp_limb_t> scratch;
+
+            [[nodiscard]] std::array<mp_limb_t*, 9> temporaries() noexcept {
+                std::array<mp_limb_t*, 9> t;
+                for (std::size_t i = 0; i < t.size(); ++i)
+                    t[i] = work.data() + i * n;
+                return t;
+            }
+
+            void mul(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) noexcept {
+                engine.sec_mul(rp, ap, bp, scratch.data());
+            }
+
+            void sqr(mp_limb_t *rp, const mp_limb_t *ap) noexcept {
+                engine.sec_sqr(rp, ap, scratch.data());
+            }
+
+            void plus(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+                engine.sec_add(rp, ap, bp);
+            }
+
+            void minus(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+                engine.sec_sub(rp, ap, bp);
+            }
+        };
+    }
+
+    // The complete formulas need a curve with no point of order 2.
+    static void check_curve(const EllipticCurve &curve) {
+        if (!curve.order().has_value() || !curve.cofactor().has_value()
+                || !(*curve.order() * *curve.cofactor()).check_bit(0))
+            throw std::domain_error(fmt::format("Constant-time multiplication requires a curve of known odd order: {}",
+                                                curve.to_string()));
+    }
+
+    static void check_scalar(const BigInt &k, std::size_t bits) {
+        const auto &kv = static_cast<const mpz_t&>(k);
+        if (mpz_sgn(kv) < 0 || (mpz_sgn(kv) > 0 && mpz_sizeinbase(kv, 2) > bits))
+            throw std::domain_error(fmt::format("Constant-time multiplication for {}-bit scalars cannot multiply by {}",
+                                                bits, k));
+    }
+
+    Point multiply(const Point &p, const BigInt &k, std::size_t bits) {
+        const auto &curve = p.curve();
+        check_curve(*curve);
+        check_scalar(k, bits);
+        if (p.is_infinity())
+            return p;
+
+        const auto &engine = curve->get_field()->montgomery();
+        const auto n = engine.limbs();
+        CompleteFormulas formulas{engine, *curve};
+
+        // R0 = O = (0 : 1 : 0), and R1 = P = (x : y : 1).
+        std::vector<mp_limb_t> r0(3 * n);
+        std::vector<mp_limb_t> r1(3 * n);
+        mpn_copyi(r0.data() + n, engine.one(), static_cast<mp_size_t>(n));
+        formulas.from_affine(r1.data(), p.x(), p.y());
+
+        // The ladder keeps R1 - R0 = P. For each bit, swap so that R0 is the point to be doubled, take R1 = R0 + R1
+        // and R0 = 2 R0, and leave the swap to be undone by the next bit's. The bits are read from the limbs rather
+        // than with mpz_tstbit, which branches on the size of k.
+        const auto scalar = limbs_of(k, (bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+        mp_limb_t swap = 0;
+        for (auto i = bits; i-- > 0;) {
+            const auto bit = (scalar[i / GMP_NUMB_BITS] >> (i % GMP_NUMB_BITS)) & 1;
+            mpn_cnd_swap(swap ^ bit, r0.data(), r1.data(), static_cast<mp_size_t>(3 * n));
+            swap = bit;
+            formulas.add(r1.data(), r0.data(), r1.data());
+            formulas.dbl(r0.data(), r0.data());
+        }
+        mpn_cnd_swap(swap, r0.data(), r1.data(), static_cast<mp_size_t>(3 * n));
+        return formulas.to_point(curve, r0.data());
+    }
+
+    Point multiply(const Point &p, const BigInt &k) {
+        check_curve(*p.curve());
+        return multiply(p, k, mpz_sizeinbase(static_cast<const mpz_t&>(*p.curve()->order()), 2));
+    }
+
+    static unsigned check_width(unsigned width) {
+        if (width < FixedBaseTable::min_width || width > FixedBaseTable::max_width)
+            throw std::domain_error(fmt::format("Constant-time FixedBaseTable width must be between {} and {}: {}",
+                                                FixedBaseTable::min_width, FixedBaseTable::max_width, width));
+        return width;
+    }
+
+    FixedBaseTable::FixedBaseTable(const Point &base, std::size_t bits, unsigned width):
+        _curve{base.curve()}, _bits{bits}, _width{check_width(width)},
+        _limbs{base.curve()->get_field()->montgomery().limbs()} {
+        const auto &curve = base.curve();
+        check_curve(*curve);
+        if (base.is_infinity())
+            throw std::domain_error("Constant-time FixedBaseTable cannot be built for the point at infinity.");
+
+        // The base is public, so the table is built with the usual arithmetic, and normalized all at once.
+        const std::size_t row_size = std::size_t{1} << _width;
+        const auto rows = (bits + _width - 1) / _width;
+        std::vector<JacobianPoint> multiples;
+        multiples.reserve(rows * row_size);
+        JacobianPoint row_base{base};
+        for (std::size_t row = 0; row < rows; ++row) {
+            auto multiple = JacobianPoint::infinity(curve);
+            for (std::size_t d = 0; d < row_size; ++d) {
+                multiples.push_back(multiple);
+                multiple += row_base;
+            }
+            row_base = multiple;
+        }
+
+        const auto &engine = curve->get_field()->montgomery();
+        _table.resize(multiples.size() * 3 * _limbs);
+        auto entry = _table.data();
+        for (const auto &multiple: JacobianPoint::to_affine(multiples)) {
+            if (multiple.is_infinity())
+                mpn_copyi(entry + _limbs, engine.one(), static_cast<mp_size_t>(_limbs));
+            else {
+                engine.to_montgomery(entry, multiple.x().get_value());
+                engine.to_montgomery(entry + _limbs, multiple.y().get_value());
+                mpn_copyi(entry + 2 * _limbs, engine.one(), static_cast<mp_size_t>(_limbs));
+            }
+            entry += 3 * _limbs;
+        }
+    }
+
+    Point FixedBaseTable::multiply(const BigInt &k) const {
+        check_scalar(k, _bits);
+        const auto curve = _curve.lock();
+        if (curve == nullptr)
+            throw std::domain_error("Constant-time FixedBaseTable cannot be used once its curve is destroyed.");
+        const auto &engine = curve->get_field()->montgomery();
+        CompleteFormulas formulas{engine, *curve};
+        const auto point_limbs = 3 * _limbs;
+        const std::size_t row_size = std::size_t{1} << _width;
+        const auto rows = _table.size() / (row_size * point_limbs);
+
+        // The sum starts at the point at infinity, (0 : 1 : 0).
+        std::vector<mp_limb_t> sum(point_limbs);
+        std::vector<mp_limb_t> entry(point_limbs);
+        mpn_copyi(sum.data() + _limbs, engine.one(), static_cast<mp_size_t>(_limbs));
+
+        const auto scalar = limbs_of(k, (rows * _width + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+        for (std::size_t row = 0; row < rows; ++row) {
+            mp_limb_t digit = 0;
+            for (unsigned bit = 0; bit < _width; ++bit) {
+                const auto i = row * _width + bit;
+                digit |= ((scalar[i / GMP_NUMB_BITS] >> (i % GMP_NUMB_BITS)) & 1) << bit;
+            }
+            mpn_sec_tabselect(entry.data(), _table.data() + row * row_size * point_limbs,
+                              static_cast<mp_size_t>(point_limbs), static_cast<mp_size_t>(row_size),
+                              static_cast<mp_size_t>(digit));
+            formulas.add(sum.data(), sum.data(), entry.data());
+        }
+        return formulas.to_point(curve, sum.data());
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * constant_time.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <gmp.h>
+
+#include "big_int.h"
+#include "elliptic_curve.h"
+#include "modular_int.h"
+#include "point.h"
+#include "prime_field.h"
+
+// Constant-time arithmetic, for operations on secrets such as private keys and nonces. The rest of the library is
+// built on mpz, whose running time depends on the values: mpz_powm and mpz_invert branch on the bits of their
+// operands, and scalar multiplication skips the zero digits of the scalar.
+//
+// Here, values are held in a fixed number of limbs, the size of the modulus, and the arithmetic uses GMP's mpn_sec_
+// functions, the constant-time kernel of Montgomery, and conditional swaps in place of branches, so that the running
+// time and memory accesses depend only on the sizes of the modulus and of the exponent or scalar, which are public.
+// Values are still taken in and given back as BigInt and ModularInt, whose mpz storage shows the number of limbs that
+// a value occupies, but nothing more. Results are already reduced, so they are copied into their ModularInts as they
+// are, rather than reduced again with mpz_mod, whose running time depends on the value.
+//
+// The modulus must be odd, or std::domain_error is thrown.
+namespace ecc::ct {
+    // The element a of the field, for 0 <= a < p, taken as it is rather than reduced like ModularInt's constructor
+    // does, so that secrets that are already in range, such as private keys and nonces, never pass through mpz_mod.
+    // The range is checked with a constant-time subtraction. If a is out of range, std::domain_error is thrown.
+    [[nodiscard]] ModularInt element(const BigInt&, std::shared_ptr<const PrimeField>);
+
+    // a^e for 0 <= e < 2^bits, using mpn_sec_powm. If e is out of range, std::domain_error is thrown.
+    [[nodiscard]] ModularInt pow(const ModularInt&, const BigInt &e, std::size_t bits);
+
+    // The inverse, using mpn_sec_invert, or std::nullopt if there is none.
+    [[nodiscard]] std::optional<ModularInt> invert(const ModularInt&);
+
+    // The sum and product. If the ModularInts are over different fields, std::domain_error is thrown.
+    [[nodiscard]] ModularInt add(const ModularInt&, const ModularInt&);
+    [[nodiscard]] ModularInt mul(const ModularInt&, const ModularInt&);
+
+    // kP for 0 <= k < 2^bits, with a Montgomery ladder: each bit of k conditionally swaps the two running points,
+    // which are then added and doubled with the complete projective formulas of Renes, Costello, and Batina, which
+    // have no exceptional cases to branch on. These are only complete on curves with no point of order 2, so the
+    // order and cofactor of the curve must be known, and their product odd, which holds for every named curve.
+    // If the curve does not qualify, or k is out of range, std::domain_error is thrown.
+    [[nodiscard]] Point multiply(const Point&, const BigInt &k, std::size_t bits);
+
+    // As above, with bits the size of the order of the curve.
+    [[nodiscard]] Point multiply(const Point&, const BigInt &k);
+
+    // A precomputed table of multiples of a fixed point B for constant-time multiplication, the counterpart of
+    // ecc::FixedBaseTable. The scalar is split into unsigned w-bit digits d_i, so that kB is the sum of the
+    // d_i 2^(wi) B. Each row holds d 2^(wi) B for every d, including the point at infinity for d = 0, which the
+    // complete formulas add like any other point, and the entry for a digit is read with mpn_sec_tabselect, which
+    // reads the whole row. For n-bit scalars, this is n / w complete additions, against a table of (n / w) 2^w points.
+    // The curve must qualify as for multiply. Once built, a table is never modified, so it may be shared freely
+    // between threads.
+    class FixedBaseTable final {
+    public:
+        // The smallest and largest window widths, and the width used for curve generators by default.
+        static constexpr unsigned min_width = 1;
+        static constexpr unsigned max_width = 8;
+        static constexpr unsigned default_width = 6;
+
+        // Build a table for scalars 0 <= k < 2^bits. If the base point is the point at infinity, the curve does not
+        // qualify, or the width is out of range, std::domain_error is thrown.
+        FixedBaseTable(const Point &base, std::size_t bits, unsigned width = default_width);
+
+        FixedBaseTable(const FixedBaseTable&) = delete;
+        FixedBaseTable(FixedBaseTable&&) noexcept = default;
+        ~FixedBaseTable() = default;
+
+        FixedBaseTable &operator=(const FixedBaseTable&) = delete;
+        FixedBaseTable &operator=(FixedBaseTable&&) noexcept = default;
+
+        [[nodiscard]] inline unsigned width() const noexcept {
+            return _width;
+        }
+
+        [[nodiscard]] inline std::size_t bits() const noexcept {
+            return _bits;
+        }
+
+        // The number of points held in the table.
+        [[nodiscard]] inline std::size_t size() const noexcept {
+            return _table.size() / (3 * _limbs);
+        }
+
+        // kB. If k is negative or has more than bits() bits, or the curve of B no longer exists, std::domain_error is
+        // thrown.
+        [[nodiscard]] Point multiply(const BigInt&) const;
+
+    private:
+        // Only a weak reference, so that a table held by a curve does not keep the curve alive.
+        std::weak_ptr<const EllipticCurve> _curve;
+        std::size_t _bits;
+        unsigned _width;
+        std::size_t _limbs;
+
+        // Row i holds d 2^(wi) B for d = 0, ..., 2^w - 1, each as X, Y, and Z in Montgomery form.
+        std::vector<mp_limb_t> _table;
+    };
+}
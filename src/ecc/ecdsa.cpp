@@ -0,0 +1,339 @@
+/**
+ * ecdsa.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "batch_invert.h"
+#include "constant_time.h"
+#include "ecdsa.h"
+#include "gmp_allocator.h"
+#include "gmp_rng.h"
+#include "jacobian_point.h"
+#include "modular_int.h"
+#include "multi_scalar_mul.h"
+#include "prime_field.h"
+
+namespace ecc::ecdsa {
+    // The order n of the generator of the curve, which ECDSA requires.
+    static const BigInt &generator_order(const std::shared_ptr<const EllipticCurve> &curve) {
+        if (!curve->has_generator())
+            throw std::domain_error(fmt::format("ECDSA requires a curve with a generator: {}", curve->to_string()));
+        return *curve->order();
+    }
+
+    // Determine if 1 <= k < n.
+    static bool in_range(const BigInt &k, const BigInt &n) {
+        return BigInt{0} < k && k < n;
+    }
+
+    static void check_private_key(const BigInt &d, const BigInt &n) {
+        if (!in_range(d, n))
+            throw std::domain_error("ECDSA private key out of range.");
+    }
+
+    // A uniformly random integer in [1, n - 1].
+    static BigInt random_scalar(const BigInt &n) {
+        return gmp::gmp_rng::local().random_mod(n - BigInt{1}) + BigInt{1};
+    }
+
+    // count uniformly random integers in [1, n - 1], drawn in bulk.
+    static std::vector<BigInt> random_scalars(const BigInt &n, std::size_t count) {
+        auto scalars = gmp::gmp_rng::local().random_mod(n - BigInt{1}, count);
+        for (auto &k: scalars)
+            ++k;
+        return scalars;
+    }
+
+    // The random coefficients of a batch need only be 128 bits to make a forgery pass with probability 2^-128.
+    // This is made on first use rather than during static initialization, before install_gmp_allocator can run, and
+    // that use may be in an ArenaScope, so the arena is suspended for it.
+    static const BigInt &batch_coefficient_bound() {
+        const ArenaSuspension suspension;
+        static const BigInt bound{"340282366920938463463374607431768211456"};
+        return bound;
+    }
+
+    // Key generation is one fixed-base multiplication per key, so it only needs a few keys per task to pay for it.
+    static constexpr std::size_t min_key_chunk_size = 16;
+
+    // Below this many signatures, a sub-batch saves too little over single verification to be worth splitting off.
+    static constexpr std::size_t min_batch_chunk_size = 128;
+
+    // dG, in either mode.
+    static Point multiply_generator(const std::shared_ptr<const EllipticCurve> &curve, const BigInt &d, Mode mode) {
+        if (mode == Mode::CONSTANT_TIME)
+            return curve->multiply_generator_constant_time(d);
+        return curve->multiply_generator(d);
+    }
+
+    KeyPair generate_key(const std::shared_ptr<const EllipticCurve> &curve, Mode mode) {
+        auto d = random_scalar(generator_order(curve));
+        auto q = multiply_generator(curve, d, mode);
+        return KeyPair{std::move(d), std::move(q)};
+    }
+
+    std::vector<KeyPair> generate_keys(const std::shared_ptr<const EllipticCurve> &curve, std::size_t count,
+                                       ThreadPool &pool) {
+        const auto &n = generator_order(curve);
+
+        // KeyPair has no default, so the slots start out empty.
+        std::vector<std::optional<KeyPair>> keys(count);
+        pool.parallel_for(count, min_key_chunk_size, [&](std::size_t begin, std::size_t end) {
+            auto private_keys = random_scalars(n, end - begin);
+            for (auto i = begin; i < end; ++i) {
+                auto &d = private_keys[i - begin];
+                auto q = curve->multiply_generator(d);
+                keys[i].emplace(KeyPair{std::move(d), std::move(q)});
+            }
+        });
+
+        std::vector<KeyPair> result;
+        result.reserve(count);
+        for (auto &key: keys)
+            result.push_back(std::move(*key));
+        return result;
+    }
+
+    Point public_key(const std::shared_ptr<const EllipticCurve> &curve, const BigInt &private_key, Mode mode) {
+        check_private_key(private_key, generator_order(curve));
+        return multiply_generator(curve, private_key, mode);
+    }
+
+    BigInt digest_to_integer(std::span<const std::uint8_t> digest, const BigInt &order) {
+        mpz_t e;
+        mpz_init(e);
+        mpz_import(e, digest.size(), 1, 1, 1, 0, digest.data());
+
+        // Keep only the leftmost bitlen(n) bits of the digest.
+        const auto digest_bits = 8 * digest.size();
+        const auto order_bits = mpz_sizeinbase(static_cast<const mpz_t&>(order), 2);
+        if (digest_bits > order_bits)
+            mpz_fdiv_q_2exp(e, e, digest_bits - order_bits);
+
+        BigInt result{e};
+        mpz_clear(e);
+        return result;
+    }
+
+    // Sign with a nonce and key already checked to be in [1, n - 1], or give std::nullopt if the nonce yields r = 0
+    // or s = 0, so that the random-nonce sign can retry without catching errors that no other nonce would fix.
+    static std::optional<Signature> try_sign(const std::shared_ptr<const EllipticCurve> &curve, const BigInt &n,
+                                             const BigInt &private_key, std::span<const std::uint8_t> digest,
+                                             const BigInt &nonce, Mode mode) {
+        const auto scalar_field = PrimeField::get(n);
+        const auto big_r = multiply_generator(curve, nonce, mode);
+        const ModularInt r{big_r.x().get_value(), scalar_field};
+        if (r.get_value().zero())
+            return std::nullopt;
+
+        // s = k^-1 (e + rd) mod n. In constant time, the nonce and key, which are in range, are taken as they are
+        // rather than reduced, and k^-1 is k^(n - 2), as n is prime, since mpn_sec_powm is quicker than mpn_sec_invert
+        // at these sizes.
+        const ModularInt e{digest_to_integer(digest, n), scalar_field};
+        const auto s = mode == Mode::CONSTANT_TIME
+            ? ct::mul(ct::pow(ct::element(nonce, scalar_field), n - BigInt{2},
+                              mpz_sizeinbase(static_cast<const mpz_t&>(n), 2)),
+                      ct::add(e, ct::mul(r, ct::element(private_key, scalar_field))))
+            : *ModularInt{nonce, scalar_field}.invert() * (e + r * ModularInt{private_key, scalar_field});
+        if (s.get_value().zero())
+            return std::nullopt;
+        return Signature{r.get_value(), s.get_value(), big_r.y().get_value().check_bit(0) != 0};
+    }
+
+    Signature sign(const std::shared_ptr<const EllipticCurve> &curve, const BigInt &private_key,
+                   std::span<const std::uint8_t> digest, Mode mode) {
+        const auto &n = generator_order(curve);
+        check_private_key(private_key, n);
+
+        // A curve that does not qualify for constant-time multiplication would fail with every nonce, so it is
+        // rejected once here, by building the generator's table.
+        if (mode == Mode::CONSTANT_TIME)
+            (void)curve->precompute_generator_constant_time(ct::FixedBaseTable::default_width);
+
+        // A nonce gives r = 0 or s = 0 with probability about 2/n, in which case we try another.
+        for (;;)
+            if (auto signature = try_sign(curve, n, private_key, digest, random_scalar(n), mode); signature.has_value())
+                return std::move(*signature);
+    }
+
+    Signature sign(const std::shared_ptr<const EllipticCurve> &curve, const BigInt &private_key,
+                   std::span<const std::uint8_t> digest, const BigInt &nonce, Mode mode) {
+        const auto &n = generator_order(curve);
+        check_private_key(private_key, n);
+        if (!in_range(nonce, n))
+            throw std::domain_error("ECDSA nonce out of range.");
+
+        auto signature = try_sign(curve, n, private_key, digest, nonce, mode);
+        if (!signature.has_value())
+            throw std::domain_error("ECDSA nonce gives r = 0 or s = 0.");
+        return std::move(*signature);
+    }
+
+    bool verify(const Point &public_key, std::span<const std::uint8_t> digest, const Signature &signature) {
+        if (public_key.is_infinity())
+            throw std::domain_error("ECDSA public key is the point at infinity.");
+        const auto &curve = public_key.curve();
+        const auto &n = generator_order(curve);
+        if (!in_range(signature.r, n) || !in_range(signature.s, n))
+            return false;
+
+        // u1 = e s^-1 and u2 = r s^-1, and the signature is valid if r = x(u1 G + u2 Q) mod n.
+        const auto scalar_field = PrimeField::get(n);
+        const auto w = *ModularInt{signature.s, scalar_field}.invert();
+        const auto u1 = ModularInt{digest_to_integer(digest, n), scalar_field} * w;
+        const auto u2 = ModularInt{signature.r, scalar_field} * w;
+
+        const auto x = msm::shamir(u1.get_value(), curve->generator(), u2.get_value(), public_key).to_affine();
+        if (x.is_infinity())
+            return false;
+        return ModularInt{x.x().get_value(), scalar_field}.get_value() == signature.r;
+    }
+
+    // A batch entry that passed the range checks, with everything the batch equation needs.
+    struct PreparedEntry {
+        std::size_t index;
+        ModularInt u1;
+        ModularInt u2;
+        Point r_point;
+    };
+
+    // Check a group of prepared entries with one multi-scalar multiplication.
+    static bool batch_holds(std::span<const BatchEntry> entries, std::span<const PreparedEntry> prepared,
+                            const std::shared_ptr<const EllipticCurve> &curve,
+                            const std::shared_ptr<const PrimeField> &scalar_field) {
+        std::vector<BigInt> scalars;
+        std::vector<Point> points;
+        scalars.reserve(2 * prepared.size() + 1);
+        points.reserve(2 * prepared.size() + 1);
+
+        // The first coefficient may as well be 1: it is only the ratios between them that matter.
+        const auto coefficients = random_scalars(batch_coefficient_bound(), prepared.size() - 1);
+        ModularInt g_coefficient{0, scalar_field};
+        scalars.emplace_back(0);
+        points.push_back(curve->generator());
+        for (std::size_t i = 0; i < prepared.size(); ++i) {
+            const auto &entry = prepared[i];
+            const ModularInt a{i == 0 ? BigInt{1} : coefficients[i - 1], scalar_field};
+            g_coefficient += a * entry.u1;
+            scalars.push_back((a * entry.u2).get_value());
+            points.push_back(entries[entry.index].public_key);
+            scalars.push_back((-a).get_value());
+            points.push_back(entry.r_point);
+        }
+        scalars.front() = g_coefficient.get_value();
+        return multi_scalar_mul(scalars, points).is_infinity();
+    }
+
+    // Find the invalid entries of a group that failed, by splitting it in half until each entry is on its own.
+    static void find_invalid(std::span<const BatchEntry> entries, std::span<const PreparedEntry> prepared,
+                             const std::shared_ptr<const EllipticCurve> &curve,
+                             const std::shared_ptr<const PrimeField> &scalar_field,
+                             std::vector<std::size_t> &invalid) {
+        if (prepared.size() == 1) {
+            const auto &entry = entries[prepared.front().index];
+            if (!verify(entry.public_key, entry.digest, entry.signature))
+                invalid.push_back(prepared.front().index);
+            return;
+        }
+
+        const auto half = prepared.size() / 2;
+        for (const auto group: {prepared.first(half), prepared.subspan(half)})
+            if (!batch_holds(entries, group, curve, scalar_field))
+                find_invalid(entries, group, curve, scalar_field, invalid);
+    }
+
+    std::vector<std::size_t> verify_batch(std::span<const BatchEntry> entries) {
+        std::vector<std::size_t> invalid;
+        if (entries.empty())
+            return invalid;
+
+        const auto &curve = entries.front().public_key.curve();
+        const auto &n = generator_order(curve);
+        for (const auto &entry: entries) {
+            if (entry.public_key.is_infinity())
+                throw std::domain_error("ECDSA public key is the point at infinity.");
+            if (!(*entry.public_key.curve() == *curve))
+                throw std::domain_error("ECDSA batch verification attempted with keys on different curves.");
+        }
+
+        // Entries with r or s out of range are invalid outright, and those without the parity of R are verified on
+        // their own, as trying both R in the batch would fail it half the time. The rest need s^-1, which we find all
+        // at once.
+        const auto scalar_field = PrimeField::get(n);
+        std::vector<std::size_t> candidates;
+        std::vector<ModularInt> w;
+        candidates.reserve(entries.size());
+        w.reserve(entries.size());
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const auto &[digest, signature, public_key] = entries[i];
+            if (!signature.odd_y.has_value()) {
+                if (!verify(public_key, digest, signature))
+                    invalid.push_back(i);
+            } else if (in_range(signature.r, n) && in_range(signature.s, n)) {
+                candidates.push_back(i);
+                w.emplace_back(signature.s, scalar_field);
+            } else {
+                invalid.push_back(i);
+            }
+        }
+        (void)batch_invert(w);
+
+        // Recover R from r: if x = r is not the x coordinate of a point, the signature cannot be valid.
+        // If the parity is wrong, R is wrong, and the batch fallback finds that the signature is valid after all.
+        std::vector<PreparedEntry> prepared;
+        prepared.reserve(candidates.size());
+        for (std::size_t j = 0; j < candidates.size(); ++j) {
+            const auto i = candidates[j];
+            const auto &[digest, signature, public_key] = entries[i];
+            const ModularInt x{signature.r, curve->get_field()};
+            auto y = curve->rhs(x).sqrt();
+            if (!y.has_value()) {
+                if (!verify(public_key, digest, signature))
+                    invalid.push_back(i);
+                continue;
+            }
+            if ((y->get_value().check_bit(0) != 0) != *signature.odd_y)
+                y = -*y;
+            prepared.push_back(PreparedEntry{
+                i,
+                ModularInt{digest_to_integer(digest, n), scalar_field} * w[j],
+                ModularInt{signature.r, scalar_field} * w[j],
+                Point{curve, x, *y}
+            });
+        }
+
+        if (!prepared.empty() && !batch_holds(entries, prepared, curve, scalar_field))
+            find_invalid(entries, prepared, curve, scalar_field, invalid);
+        std::sort(invalid.begin(), invalid.end());
+        return invalid;
+    }
+
+    std::vector<std::size_t> verify_batch_parallel(std::span<const BatchEntry> entries, ThreadPool &pool) {
+        std::mutex invalid_mutex;
+        std::vector<std::size_t> invalid;
+        pool.parallel_for(entries.size(), min_batch_chunk_size, [&](std::size_t begin, std::size_t end) {
+            const auto chunk_invalid = verify_batch(entries.subspan(begin, end - begin));
+            std::lock_guard lock{invalid_mutex};
+            for (const auto i: chunk_invalid)
+                invalid.push_back(begin + i);
+        });
+        std::sort(invalid.begin(), invalid.end());
+        return invalid;
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * ecdsa.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "big_int.h"
+#include "elliptic_curve.h"
+#include "point.h"
+#include "thread_pool.h"
+
+// ECDSA as specified in SEC 1 v2, section 4.1, over curves with a generator of prime order n.
+// Hashing is left to the caller: messages are given by their digests.
+namespace ecc::ecdsa {
+    struct Signature {
+        BigInt r;
+        BigInt s;
+
+        // The parity of the y coordinate of R = kG, which sign fills in. It is not part of the signature proper, so it
+        // is not compared: only batch verification uses it, to recover R from r. A signature without it, e.g. one read
+        // as (r, s), is verified on its own with verify, and one with the wrong parity still verifies in a batch, but
+        // only through the slower per-signature fallback.
+        std::optional<bool> odd_y = std::nullopt;
+
+        [[nodiscard]] inline bool operator==(const Signature &other) const {
+            return r == other.r && s == other.s;
+        }
+    };
+
+    // A digest, its signature, and the public key it should verify against, for batch verification.
+    struct BatchEntry {
+        std::span<const std::uint8_t> digest;
+        Signature signature;
+        Point public_key;
+    };
+
+    struct KeyPair {
+        BigInt private_key;
+        Point public_key;
+    };
+
+    // How the operations on a private key or nonce are computed. VARIABLE_TIME uses the fastest methods, such as
+    // the generator's fixed-base table, whose running time depends on the secrets. CONSTANT_TIME uses the
+    // constant-time arithmetic of ecc::ct instead, for keys that must not leak through timing, at some cost in speed.
+    // Both give the same results.
+    enum class Mode {
+        VARIABLE_TIME,
+        CONSTANT_TIME,
+    };
+
+    // Generate a random key pair. If the curve has no generator, std::domain_error is thrown.
+    [[nodiscard]] KeyPair generate_key(const std::shared_ptr<const EllipticCurve>&, Mode mode = Mode::VARIABLE_TIME);
+
+    // Generate count random key pairs concurrently on the pool.
+    [[nodiscard]] std::vector<KeyPair> generate_keys(const std::shared_ptr<const EllipticCurve>&, std::size_t count,
+                                                     ThreadPool &pool = ThreadPool::global());
+
+    // The public key dG for the private key d.
+    // If the curve has no generator, or d is not in [1, n - 1], std::domain_error is thrown.
+    [[nodiscard]] Point public_key(const std::shared_ptr<const EllipticCurve>&, const BigInt &private_key,
+                                   Mode mode = Mode::VARIABLE_TIME);
+
+    // The integer e for a message digest: its leftmost bitlen(n) bits, read as a big-endian integer.
+    [[nodiscard]] BigInt digest_to_integer(std::span<const std::uint8_t> digest, const BigInt &order);
+
+    // Sign a digest with a random nonce, with kG computed from one of the curve's fixed-base generator tables.
+    // If the curve has no generator, or d is not in [1, n - 1], or in constant time the curve does not qualify for
+    // ct::multiply, std::domain_error is thrown.
+    [[nodiscard]] Signature sign(const std::shared_ptr<const EllipticCurve>&, const BigInt &private_key,
+                                 std::span<const std::uint8_t> digest, Mode mode = Mode::VARIABLE_TIME);
+
+    // Sign a digest with the given nonce k, e.g. one derived as in RFC 6979.
+    // In addition to the above, if k is not in [1, n - 1], or if it yields r = 0 or s = 0, std::domain_error is thrown:
+    // the caller must then pick another nonce.
+    [[nodiscard]] Signature sign(const std::shared_ptr<const EllipticCurve>&, const BigInt &private_key,
+                                 std::span<const std::uint8_t> digest, const BigInt &nonce,
+                                 Mode mode = Mode::VARIABLE_TIME);
+
+    // Verify a signature, computing u1 G + u2 Q in a single pass with Shamir's trick.
+    // Returns false for any invalid signature, including ones with r or s out of range. If the public key is the
+    // point at infinity, or its curve has no generator, std::domain_error is thrown.
+    [[nodiscard]] bool verify(const Point &public_key, std::span<const std::uint8_t> digest, const Signature&);
+
+    // Verify a batch of signatures, returning the indices of the invalid ones in increasing order.
+    // Each signature gives s R = e G + r Q, where R is recovered from r and the parity of its y coordinate. The batch
+    // is checked all at once with the random linear combination
+    //     (sum a_i e_i / s_i) G + sum (a_i r_i / s_i) Q_i - sum a_i R_i = O
+    // which is a single multi-scalar multiplication. If it fails, the batch is split in half and each half is
+    // checked in the same way, down to single signatures, which are verified with verify. Signatures without the
+    // parity cannot be recovered cheaply, so they are verified with verify from the start.
+    // If the public keys are not all on the same curve, or a public key is the point at infinity, or the curve
+    // has no generator, std::domain_error is thrown.
+    [[nodiscard]] std::vector<std::size_t> verify_batch(std::span<const BatchEntry>);
+
+    // As verify_batch, but with the batch split into sub-batches that are verified concurrently on the pool.
+    // Each sub-batch has its own multi-scalar multiplication, so a bad signature only sends its own sub-batch
+    // down the fallback. Small batches are not split.
+    [[nodiscard]] std::vector<std::size_t> verify_batch_parallel(std::span<const BatchEntry>,
+                                                                 ThreadPool &pool = ThreadPool::global());
+}
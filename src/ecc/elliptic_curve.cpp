@@ -0,0 +1,149 @@
+/**
+ * elliptic_curve.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+#include "formatters/big_int_formatter.h"
+#include "formatters/modular_int_formatter.h"
+#include "constant_time.h"
+#include "elliptic_curve.h"
+#include "fixed_base_table.h"
+#include "gmp_allocator.h"
+#include "point.h"
+
+namespace ecc {
+    // The number of Miller-Rabin rounds used to check the modulus of a curve.
+    static constexpr int prime_tries = 25;
+
+    std::shared_ptr<const EllipticCurve> EllipticCurve::create(const BigInt &a,
+                                                               const BigInt &b,
+                                                               const BigInt &p,
+                                                               std::optional<BigInt> order,
+                                                               std::optional<BigInt> cofactor) {
+        if (p < BigInt{5} || !p.is_probably_prime(prime_tries))
+            throw std::domain_error(fmt::format("EllipticCurve requires a prime modulus greater than 3: {}", p));
+
+        const auto field = PrimeField::get(p);
+        ModularInt ma{a, field};
+        ModularInt mb{b, field};
+
+        // The curve is singular iff the discriminant 4a^3 + 27b^2 vanishes.
+        const auto discriminant = ModularInt{4, field} * ma.pow(3) + ModularInt{27, field} * mb.pow(2);
+        if (discriminant.get_value().zero())
+            throw std::domain_error(fmt::format("EllipticCurve is singular: a = {}, b = {}", ma, mb));
+
+        // The constructor is private, so we cannot use std::make_shared.
+        return std::shared_ptr<const EllipticCurve>{
+            new EllipticCurve{std::move(ma), std::move(mb), std::move(order), std::move(cofactor)}
+        };
+    }
+
+    std::shared_ptr<const EllipticCurve> EllipticCurve::create(const BigInt &a,
+                                                               const BigInt &b,
+                                                               const BigInt &p,
+                                                               const BigInt &gx,
+                                                               const BigInt &gy,
+                                                               BigInt order,
+                                                               BigInt cofactor) {
+        auto curve = create(a, b, p, std::move(order), std::move(cofactor));
+        const auto &field = curve->get_field();
+        ModularInt x{gx, field};
+        ModularInt y{gy, field};
+        if (!curve->contains(x, y))
+            throw std::domain_error(fmt::format("Generator ({},{}) is not on the curve {}.", x, y, curve->to_string()));
+
+        // The curve has not been shared yet, so this is the only place it can be modified.
+        std::const_pointer_cast<EllipticCurve>(curve)->_generator.emplace(std::move(x), std::move(y));
+        return curve;
+    }
+
+    EllipticCurve::EllipticCurve(ModularInt a, ModularInt b, std::optional<BigInt> order,
+                                 std::optional<BigInt> cofactor):
+        _a{std::move(a)}, _b{std::move(b)}, _order{std::move(order)}, _cofactor{std::move(cofactor)} {
+        if (_a.get_value().zero())
+            _a_type = CoefficientA::ZERO;
+        else if (_a == ModularInt{-3, get_field()})
+            _a_type = CoefficientA::MINUS_THREE;
+        else
+            _a_type = CoefficientA::GENERIC;
+    }
+
+    EllipticCurve::~EllipticCurve() = default;
+
+    Point EllipticCurve::generator() const {
+        if (!_generator.has_value())
+            throw std::domain_error(fmt::format("The curve {} has no generator.", to_string()));
+        return Point{shared_from_this(), _generator->first, _generator->second};
+    }
+
+    const FixedBaseTable &EllipticCurve::precompute_generator(unsigned width) const {
+        if (!_generator.has_value())
+            throw std::domain_error(fmt::format("The curve {} has no generator.", to_string()));
+        std::call_once(_generator_table_flag, [this, width] {
+            const ArenaSuspension suspension;
+            const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(*_order), 2);
+            _generator_table = std::make_unique<const FixedBaseTable>(generator(), bits, width);
+        });
+        return *_generator_table;
+    }
+
+    Point EllipticCurve::multiply_generator(const BigInt &k) const {
+        // If the table was already built, the width is ignored.
+        const auto &table = precompute_generator(FixedBaseTable::default_width);
+        return table.multiply(k % *_order).to_affine();
+    }
+
+    const ct::FixedBaseTable &EllipticCurve::precompute_generator_constant_time(unsigned width) const {
+        if (!_generator.has_value())
+            throw std::domain_error(fmt::format("The curve {} has no generator.", to_string()));
+        std::call_once(_constant_time_table_flag, [this, width] {
+            const ArenaSuspension suspension;
+            const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(*_order), 2);
+            _constant_time_table = std::make_unique<const ct::FixedBaseTable>(generator(), bits, width);
+        });
+        return *_constant_time_table;
+    }
+
+    Point EllipticCurve::multiply_generator_constant_time(const BigInt &k) const {
+        // If the table was already built, the width is ignored.
+        return precompute_generator_constant_time(ct::FixedBaseTable::default_width).multiply(k);
+    }
+
+    bool EllipticCurve::operator==(const EllipticCurve &other) const {
+        return this == &other
+            || (get_field() == other.get_field() && _a == other._a && _b == other._b);
+    }
+
+    ModularInt EllipticCurve::rhs(const ModularInt &x) const {
+        auto result = x * x;
+        result += _a;
+        result *= x;
+        result += _b;
+        return result;
+    }
+
+    bool EllipticCurve::contains(const ModularInt &x, const ModularInt &y) const {
+        return x.get_field() == get_field() && y.get_field() == get_field() && y * y == rhs(x);
+    }
+
+    Point EllipticCurve::point(const BigInt &x, const BigInt &y) const {
+        return Point{shared_from_this(), ModularInt{x, get_field()}, ModularInt{y, get_field()}};
+    }
+
+    Point EllipticCurve::infinity() const {
+        return Point::infinity(shared_from_this());
+    }
+
+    std::string EllipticCurve::to_string() const {
+        return fmt::format("y^2 = x^3 + {}x + {} (mod {})", _a.get_value(), _b.get_value(), get_mod());
+    }
+}
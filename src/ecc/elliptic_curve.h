@@ -0,0 +1,147 @@
+/**
+ * elliptic_curve.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "big_int.h"
+#include "modular_int.h"
+#include "prime_field.h"
+
+namespace ecc {
+    class FixedBaseTable;
+    class Point;
+
+    namespace ct {
+        class FixedBaseTable;
+    }
+
+    // An elliptic curve in short Weierstrass form, y^2 = x^3 + ax + b, over a prime field F_p with p > 3.
+    // Curves are always held by std::shared_ptr so that the points on them can refer back to them.
+    class EllipticCurve final : public std::enable_shared_from_this<EllipticCurve> {
+    public:
+        // Curves with a = 0 or a = -3 admit faster doubling formulas in Jacobian coordinates.
+        enum class CoefficientA {
+            ZERO,
+            MINUS_THREE,
+            GENERIC,
+        };
+
+        // Create a curve. The order of the group of points and the cofactor are optional.
+        // If p is not a prime greater than 3, or the curve is singular, i.e. 4a^3 + 27b^2 ≡ 0 (mod p),
+        // std::domain_error is thrown.
+        [[nodiscard]] static std::shared_ptr<const EllipticCurve> create(const BigInt &a,
+                                                                         const BigInt &b,
+                                                                         const BigInt &p,
+                                                                         std::optional<BigInt> order = std::nullopt,
+                                                                         std::optional<BigInt> cofactor = std::nullopt);
+
+        // Create a curve with a distinguished generator (gx, gy) of a subgroup of the given order.
+        // In addition to the above, if the generator is not on the curve, std::domain_error is thrown.
+        [[nodiscard]] static std::shared_ptr<const EllipticCurve> create(const BigInt &a,
+                                                                         const BigInt &b,
+                                                                         const BigInt &p,
+                                                                         const BigInt &gx,
+                                                                         const BigInt &gy,
+                                                                         BigInt order,
+                                                                         BigInt cofactor);
+
+        EllipticCurve(const EllipticCurve&) = delete;
+        EllipticCurve(EllipticCurve&&) = delete;
+        ~EllipticCurve();
+
+        EllipticCurve &operator=(const EllipticCurve&) = delete;
+        EllipticCurve &operator=(EllipticCurve&&) = delete;
+
+        [[nodiscard]] inline const ModularInt &a() const noexcept {
+            return _a;
+        }
+
+        [[nodiscard]] inline const ModularInt &b() const noexcept {
+            return _b;
+        }
+
+        [[nodiscard]] inline CoefficientA a_type() const noexcept {
+            return _a_type;
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<const PrimeField> &get_field() const noexcept {
+            return _a.get_field();
+        }
+
+        [[nodiscard]] inline const BigInt &get_mod() const noexcept {
+            return _a.get_mod();
+        }
+
+        [[nodiscard]] inline const std::optional<BigInt> &order() const noexcept {
+            return _order;
+        }
+
+        [[nodiscard]] inline const std::optional<BigInt> &cofactor() const noexcept {
+            return _cofactor;
+        }
+
+        [[nodiscard]] inline bool has_generator() const noexcept {
+            return _generator.has_value();
+        }
+
+        // The generator of the curve. If the curve has none, std::domain_error is thrown.
+        [[nodiscard]] Point generator() const;
+
+        // The fixed-base table for the generator, built by the first call, which is thread-safe: later calls return
+        // the same table regardless of the width requested. Services should call this once at startup so that
+        // the first multiplication by the generator does not pay for it.
+        // If the curve has no generator, std::domain_error is thrown.
+        const FixedBaseTable &precompute_generator(unsigned width) const;
+
+        // kG for the generator G, with k reduced modulo the order, using the fixed-base table.
+        // If the curve has no generator, std::domain_error is thrown.
+        [[nodiscard]] Point multiply_generator(const BigInt&) const;
+
+        // The constant-time counterparts of the above, with their own table, which is built and cached in the same
+        // way. Here k is not reduced, as that would not be constant-time: it must be in [0, 2^bitlen(n)) for the order
+        // n. If the curve has no generator, or it does not qualify for ct::multiply, or k is out of range,
+        // std::domain_error is thrown.
+        const ct::FixedBaseTable &precompute_generator_constant_time(unsigned width) const;
+        [[nodiscard]] Point multiply_generator_constant_time(const BigInt&) const;
+
+        // Two curves are equal if they have the same parameters.
+        [[nodiscard]] bool operator==(const EllipticCurve&) const;
+
+        // x^3 + ax + b, the right hand side of the curve equation.
+        [[nodiscard]] ModularInt rhs(const ModularInt&) const;
+
+        // Determine if (x, y) satisfies the curve equation.
+        [[nodiscard]] bool contains(const ModularInt&, const ModularInt&) const;
+
+        // Create a point on this curve. If it does not lie on the curve, std::domain_error is thrown.
+        [[nodiscard]] Point point(const BigInt&, const BigInt&) const;
+
+        // The point at infinity, i.e. the identity of the group.
+        [[nodiscard]] Point infinity() const;
+
+        [[nodiscard]] std::string to_string() const;
+
+    private:
+        ModularInt _a;
+        ModularInt _b;
+        CoefficientA _a_type;
+        std::optional<BigInt> _order;
+        std::optional<BigInt> _cofactor;
+        std::optional<std::pair<ModularInt, ModularInt>> _generator;
+
+        mutable std::once_flag _generator_table_flag;
+        mutable std::unique_ptr<const FixedBaseTable> _generator_table;
+        mutable std::once_flag _constant_time_table_flag;
+        mutable std::unique_ptr<const ct::FixedBaseTable> _constant_time_table;
+
+        EllipticCurve(ModularInt, ModularInt, std::optional<BigInt>, std::optional<BigInt>);
+    };
+}
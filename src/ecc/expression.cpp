@@ -0,0 +1,54 @@
+/**
+ * expression.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "formatters/modular_int_formatter.h"
+#include "expression.h"
+#include "gmp_allocator.h"
+
+namespace ecc::expr::detail {
+    namespace {
+        struct Slots {
+            mpz_t values[max_slots];
+
+            Slots() {
+                for (auto &value: values)
+                    mpz_init(value);
+            }
+
+            ~Slots() {
+                for (auto &value: values)
+                    mpz_clear(value);
+            }
+        };
+    }
+
+    mpz_t *slots(std::size_t count, mp_bitcnt_t bits) {
+        static thread_local Slots slots;
+        // The slots live as long as the thread, so they must not grow into an ArenaScope that is open at the time.
+        // Each is given at least a limb here, as GMP's first allocation for a value would otherwise come from the
+        // evaluation, and would be taken from the arena. Once the slots have blocks from the pools, GMP's growth of
+        // them during an evaluation stays in the pools.
+        const auto needed = std::max<mp_bitcnt_t>(bits, GMP_NUMB_BITS);
+        for (std::size_t i = 0; i < count; ++i)
+            if (static_cast<mp_bitcnt_t>(slots.values[i]->_mp_alloc) * GMP_NUMB_BITS < needed) {
+                const ArenaSuspension suspension;
+                mpz_realloc2(slots.values[i], needed);
+            }
+        return slots.values;
+    }
+
+    void incompatible(const ModularInt &m, const PrimeField &field) {
+        throw std::domain_error(fmt::format("Expression mixes fields: {} is not modulo {}.", m, field.modulus()));
+    }
+}
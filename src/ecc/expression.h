@@ -0,0 +1,316 @@
+/**
+ * expression.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include <gmp.h>
+
+#include "big_int.h"
+#include "modular_int.h"
+#include "prime_field.h"
+
+// Expression templates for BigInt and ModularInt. lazy(a) * b - c describes the expression rather than computing it,
+// and the whole of it is evaluated when it is converted to a value or assigned into one, with its intermediate results
+// in the calling thread's scratch slots rather than in new values.
+//
+// Over a field, reduction is lazy: sums, differences, negations, and small multiples are left unreduced, and a
+// product is only reduced when it is multiplied again, so that it does not keep doubling in size. The result is
+// reduced once at the end. This is exact, as reduction mod p commutes with the ring operations, so each division
+// that is skipped is one saved. All the ModularInts of an expression must be over the same field, or
+// std::domain_error is thrown.
+//
+// An expression refers to its operands rather than copying them, so it must be evaluated in the statement that builds
+// it: it must not be kept, e.g. in an auto variable.
+namespace ecc::expr {
+    // The access to the internals of BigInt and ModularInt that evaluation needs, which the constant-time arithmetic
+    // also uses to write results that are already reduced.
+    struct Access final {
+        [[nodiscard]] static inline mpz_ptr value(BigInt &b) noexcept {
+            return b.value;
+        }
+        [[nodiscard]] static inline mpz_srcptr value(const BigInt &b) noexcept {
+            return b.value;
+        }
+        [[nodiscard]] static inline mpz_ptr value(ModularInt &m) noexcept {
+            return m._value.value;
+        }
+        [[nodiscard]] static inline mpz_srcptr value(const ModularInt &m) noexcept {
+            return m._value.value;
+        }
+        [[nodiscard]] static inline ModularInt element(std::shared_ptr<const PrimeField> field) {
+            return ModularInt{std::move(field)};
+        }
+        static inline void set_field(ModularInt &m, const std::shared_ptr<const PrimeField> &field) {
+            m._field = field;
+        }
+    };
+
+    namespace detail {
+        // The deepest an expression can nest its intermediate results.
+        inline constexpr std::size_t max_slots = 16;
+
+        // The slots for the intermediate results of an evaluation, and for a ModularInt expression, the field.
+        struct Context {
+            mpz_t *slots;
+            const PrimeField *field;
+            mpz_srcptr modulus;
+        };
+
+        // The calling thread's slots, of which the first count are made to have room for the given number of bits.
+        // They keep their storage from one evaluation to the next.
+        [[nodiscard]] mpz_t *slots(std::size_t count, mp_bitcnt_t bits);
+
+        // Thrown when an operand of an expression is not over the field of the others.
+        [[noreturn]] void incompatible(const ModularInt&, const PrimeField&);
+
+        struct NodeBase {};
+    }
+
+    template <typename T>
+    concept Value = std::same_as<T, BigInt> || std::same_as<T, ModularInt>;
+
+    template <typename T>
+    concept Node = std::derived_from<T, detail::NodeBase>;
+
+    template <Node E>
+    void assign(typename E::value_type&, const E&);
+
+    template <Node E>
+    [[nodiscard]] typename E::value_type evaluate(const E&);
+
+    // Every node can be converted to its value, which evaluates it.
+    //
+    // Each node writes its result into the slot at the level it is evaluated at, and evaluates its right operand one
+    // level deeper, so that the right operand cannot overwrite the left. slots is the number of levels that a node
+    // uses, and wide is whether its unreduced value may have grown to the size of a product.
+    template <typename Derived>
+    struct Expression: detail::NodeBase {
+        template <Value T>
+        requires std::same_as<T, typename Derived::value_type>
+        operator T() const {
+            return evaluate(static_cast<const Derived&>(*this));
+        }
+    };
+
+    // An operand of an expression.
+    template <Value T>
+    struct Leaf final: Expression<Leaf<T>> {
+        using value_type = T;
+        static constexpr std::size_t slots = 0;
+        static constexpr bool wide = false;
+
+        const T &operand;
+
+        explicit Leaf(const T &operand): operand{operand} {}
+
+        [[nodiscard]] mpz_srcptr evaluate(const detail::Context &context, std::size_t) const {
+            if constexpr (std::same_as<T, ModularInt>) {
+                if (operand.get_field().get() != context.field)
+                    detail::incompatible(operand, *context.field);
+            }
+            return Access::value(operand);
+        }
+
+        [[nodiscard]] const std::shared_ptr<const PrimeField> &field() const requires std::same_as<T, ModularInt> {
+            return operand.get_field();
+        }
+    };
+
+    // The sum or difference of the operands, for F mpz_add or mpz_sub, which is not reduced.
+    template <Node L, Node R, auto F>
+    struct Sum final: Expression<Sum<L, R, F>> {
+        using value_type = typename L::value_type;
+        static constexpr std::size_t slots = std::max({std::size_t{1}, L::slots, R::slots + 1});
+        static constexpr bool wide = L::wide || R::wide;
+
+        L left;
+        R right;
+
+        Sum(L left, R right): left{std::move(left)}, right{std::move(right)} {}
+
+        [[nodiscard]] mpz_srcptr evaluate(const detail::Context &context, std::size_t level) const {
+            const auto a = left.evaluate(context, level);
+            const auto b = right.evaluate(context, level + 1);
+            F(context.slots[level], a, b);
+            return context.slots[level];
+        }
+
+        [[nodiscard]] decltype(auto) field() const {
+            return left.field();
+        }
+    };
+
+    template <Node L, Node R>
+    struct Product final: Expression<Product<L, R>> {
+        using value_type = typename L::value_type;
+        static constexpr std::size_t slots = std::max({std::size_t{1}, L::slots, R::slots + 1});
+        static constexpr bool wide = true;
+
+        L left;
+        R right;
+
+        Product(L left, R right): left{std::move(left)}, right{std::move(right)} {}
+
+        [[nodiscard]] mpz_srcptr evaluate(const detail::Context &context, std::size_t level) const {
+            auto a = left.evaluate(context, level);
+            auto b = right.evaluate(context, level + 1);
+            if constexpr (std::same_as<value_type, ModularInt>) {
+                // A wide operand is always in its own slot, as leaves are reduced.
+                if constexpr (L::wide) {
+                    mpz_mod(context.slots[level], a, context.modulus);
+                    a = context.slots[level];
+                }
+                if constexpr (R::wide) {
+                    mpz_mod(context.slots[level + 1], b, context.modulus);
+                    b = context.slots[level + 1];
+                }
+            }
+            mpz_mul(context.slots[level], a, b);
+            return context.slots[level];
+        }
+
+        [[nodiscard]] decltype(auto) field() const {
+            return left.field();
+        }
+    };
+
+    template <Node E>
+    struct Negation final: Expression<Negation<E>> {
+        using value_type = typename E::value_type;
+        static constexpr std::size_t slots = std::max(std::size_t{1}, E::slots);
+        static constexpr bool wide = E::wide;
+
+        E operand;
+
+        explicit Negation(E operand): operand{std::move(operand)} {}
+
+        [[nodiscard]] mpz_srcptr evaluate(const detail::Context &context, std::size_t level) const {
+            mpz_neg(context.slots[level], operand.evaluate(context, level));
+            return context.slots[level];
+        }
+
+        [[nodiscard]] decltype(auto) field() const {
+            return operand.field();
+        }
+    };
+
+    // A multiple of the operand by a small integer, as in the doublings and triplings of the curve formulas.
+    template <Node E>
+    struct Multiple final: Expression<Multiple<E>> {
+        using value_type = typename E::value_type;
+        static constexpr std::size_t slots = std::max(std::size_t{1}, E::slots);
+        static constexpr bool wide = E::wide;
+
+        E operand;
+        long factor;
+
+        Multiple(E operand, long factor): operand{std::move(operand)}, factor{factor} {}
+
+        [[nodiscard]] mpz_srcptr evaluate(const detail::Context &context, std::size_t level) const {
+            mpz_mul_si(context.slots[level], operand.evaluate(context, level), factor);
+            return context.slots[level];
+        }
+
+        [[nodiscard]] decltype(auto) field() const {
+            return operand.field();
+        }
+    };
+
+    // Start an expression with a value.
+    template <Value T>
+    [[nodiscard]] Leaf<T> lazy(const T &value) {
+        return Leaf<T>{value};
+    }
+
+    namespace detail {
+        template <typename T>
+        [[nodiscard]] auto node(const T &t) {
+            if constexpr (Node<T>)
+                return t;
+            else
+                return Leaf<T>{t};
+        }
+
+        template <typename T>
+        using node_t = decltype(node(std::declval<const T&>()));
+    }
+
+    // The operators apply when at least one side is already an expression, so that the operators of BigInt and
+    // ModularInt themselves are unchanged.
+    template <typename L, typename R>
+    concept Operands = (Node<L> || Value<L>) && (Node<R> || Value<R>) && (Node<L> || Node<R>)
+                       && std::same_as<typename detail::node_t<L>::value_type, typename detail::node_t<R>::value_type>;
+
+    template <typename L, typename R>
+    requires Operands<L, R>
+    [[nodiscard]] auto operator+(const L &l, const R &r) {
+        return Sum<detail::node_t<L>, detail::node_t<R>, mpz_add>{detail::node(l), detail::node(r)};
+    }
+
+    template <typename L, typename R>
+    requires Operands<L, R>
+    [[nodiscard]] auto operator-(const L &l, const R &r) {
+        return Sum<detail::node_t<L>, detail::node_t<R>, mpz_sub>{detail::node(l), detail::node(r)};
+    }
+
+    template <typename L, typename R>
+    requires Operands<L, R>
+    [[nodiscard]] auto operator*(const L &l, const R &r) {
+        return Product<detail::node_t<L>, detail::node_t<R>>{detail::node(l), detail::node(r)};
+    }
+
+    template <Node E>
+    [[nodiscard]] auto operator-(const E &e) {
+        return Negation<E>{e};
+    }
+
+    template <Node E>
+    [[nodiscard]] auto operator*(const E &e, long factor) {
+        return Multiple<E>{e, factor};
+    }
+
+    template <Node E>
+    [[nodiscard]] auto operator*(long factor, const E &e) {
+        return Multiple<E>{e, factor};
+    }
+
+    // Evaluate the expression into the destination, which may be one of its operands, as it is only written once the
+    // expression has been evaluated. A ModularInt destination takes the field of the expression.
+    template <Node E>
+    void assign(typename E::value_type &destination, const E &e) {
+        static_assert(E::slots <= detail::max_slots, "The expression is nested too deeply.");
+        if constexpr (std::same_as<typename E::value_type, ModularInt>) {
+            const auto &field = e.field();
+            const auto modulus = Access::value(field->modulus());
+            const detail::Context context{detail::slots(E::slots, 2 * field->element_capacity()), field.get(), modulus};
+            const auto result = e.evaluate(context, 0);
+            if (destination.get_field() != field)
+                Access::set_field(destination, field);
+            mpz_mod(Access::value(destination), result, modulus);
+        } else {
+            const detail::Context context{detail::slots(E::slots, 0), nullptr, nullptr};
+            mpz_set(Access::value(destination), e.evaluate(context, 0));
+        }
+    }
+
+    template <Node E>
+    typename E::value_type evaluate(const E &e) {
+        if constexpr (std::same_as<typename E::value_type, ModularInt>) {
+            auto result = Access::element(e.field());
+            assign(result, e);
+            return result;
+        } else {
+            BigInt result;
+            assign(result, e);
+            return result;
+        }
+    }
+}
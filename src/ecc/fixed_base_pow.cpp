@@ -0,0 +1,77 @@
+/**
+ * fixed_base_pow.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "fixed_base_pow.h"
+#include "montgomery.h"
+
+namespace ecc {
+    static unsigned check_width(unsigned width) {
+        if (width < FixedBasePow::min_width || width > FixedBasePow::max_width)
+            throw std::domain_error(fmt::format("FixedBasePow width must be between {} and {}: {}",
+                                                FixedBasePow::min_width, FixedBasePow::max_width, width));
+        return width;
+    }
+
+    FixedBasePow::FixedBasePow(const ModularInt &base, std::size_t bits, unsigned width):
+        _field{base.get_field()}, _bits{bits}, _width{check_width(width)}, _limbs{_field->montgomery().limbs()},
+        _row_size{(std::size_t{1} << _width) - 1} {
+        const auto &engine = _field->montgomery();
+        const auto rows = (bits + _width - 1) / _width;
+        _table.resize(rows * _row_size * _limbs);
+
+        // Each entry is the one before it times the row's base, and the next row's base is the last entry times it.
+        std::vector<mp_limb_t> row_base(_limbs);
+        engine.to_montgomery(row_base.data(), base.get_value());
+        for (std::size_t row = 0; row < rows; ++row) {
+            auto entry = _table.data() + row * _row_size * _limbs;
+            mpn_copyi(entry, row_base.data(), static_cast<mp_size_t>(_limbs));
+            for (std::size_t d = 2; d <= _row_size; ++d, entry += _limbs)
+                engine.mul(entry + _limbs, entry, row_base.data());
+            engine.mul(row_base.data(), entry, row_base.data());
+        }
+    }
+
+    ModularInt FixedBasePow::pow(const BigInt &e) const {
+        const auto &ev = static_cast<const mpz_t&>(e);
+        // mpz_sizeinbase gives 1 for 0, which a table for 0-bit exponents must still accept.
+        if (mpz_sgn(ev) < 0 || (mpz_sgn(ev) > 0 && mpz_sizeinbase(ev, 2) > _bits))
+            throw std::domain_error(fmt::format("FixedBasePow for {}-bit exponents cannot raise to {}", _bits, e));
+
+        const auto &engine = _field->montgomery();
+        const auto rows = _table.size() / (_row_size * _limbs);
+
+        // The first nonzero digit is copied rather than multiplied into 1.
+        std::vector<mp_limb_t> result(_limbs);
+        bool started = false;
+        for (std::size_t row = 0; row < rows; ++row) {
+            std::size_t digit = 0;
+            const auto start = row * _width;
+            for (unsigned bit = 0; bit < _width; ++bit)
+                digit |= static_cast<std::size_t>(mpz_tstbit(ev, start + bit)) << bit;
+            if (digit == 0)
+                continue;
+
+            const auto entry = _table.data() + (row * _row_size + digit - 1) * _limbs;
+            if (started)
+                engine.mul(result.data(), result.data(), entry);
+            else
+                mpn_copyi(result.data(), entry, static_cast<mp_size_t>(_limbs));
+            started = true;
+        }
+
+        if (!started)
+            return ModularInt{1, _field};
+        return ModularInt{engine.from_montgomery(result.data()), _field};
+    }
+}
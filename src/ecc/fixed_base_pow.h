@@ -0,0 +1,69 @@
+/**
+ * fixed_base_pow.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <gmp.h>
+
+#include "big_int.h"
+#include "modular_int.h"
+#include "prime_field.h"
+
+namespace ecc {
+    // A precomputed table of powers of a fixed base b, used to compute b^e with no squarings: the multiplicative
+    // analogue of FixedBaseTable. The exponent is split into w-bit digits d_i in [0, 2^w), so that b^e is the product
+    // of the b^(d_i 2^(wi)). The digits are unsigned, as inverses are not free here as negation is for points.
+    // The table holds each b^(d 2^(wi)) in Montgomery form, so for n-bit exponents this is about n / w Montgomery
+    // multiplications, against a table of (n / w) (2^w - 1) elements.
+    // Once built, a table is never modified, so it may be shared freely between threads.
+    class FixedBasePow final {
+    public:
+        // The smallest and largest window widths, and the width used by default.
+        static constexpr unsigned min_width = 1;
+        static constexpr unsigned max_width = 12;
+        static constexpr unsigned default_width = 6;
+
+        // Build a table for exponents 0 <= e < 2^bits. If the modulus is even or less than 3, or if the width is out
+        // of range, std::domain_error is thrown.
+        FixedBasePow(const ModularInt &base, std::size_t bits, unsigned width = default_width);
+
+        FixedBasePow(const FixedBasePow&) = delete;
+        FixedBasePow(FixedBasePow&&) noexcept = default;
+        ~FixedBasePow() = default;
+
+        FixedBasePow &operator=(const FixedBasePow&) = delete;
+        FixedBasePow &operator=(FixedBasePow&&) noexcept = default;
+
+        [[nodiscard]] inline unsigned width() const noexcept {
+            return _width;
+        }
+
+        [[nodiscard]] inline std::size_t bits() const noexcept {
+            return _bits;
+        }
+
+        // The number of elements held in the table.
+        [[nodiscard]] inline std::size_t size() const noexcept {
+            return _table.size() / _limbs;
+        }
+
+        // b^e. If e is negative or has more than bits() bits, std::domain_error is thrown.
+        [[nodiscard]] ModularInt pow(const BigInt&) const;
+
+    private:
+        std::shared_ptr<const PrimeField> _field;
+        std::size_t _bits;
+        unsigned _width;
+        std::size_t _limbs;
+
+        // Row i holds b^(d 2^(wi)) for d = 1, ..., 2^w - 1, each as _limbs limbs in Montgomery form.
+        std::size_t _row_size;
+        std::vector<mp_limb_t> _table;
+    };
+}
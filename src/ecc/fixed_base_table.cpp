@@ -0,0 +1,88 @@
+/**
+ * fixed_base_table.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "fixed_base_table.h"
+
+namespace ecc {
+    static unsigned check_width(unsigned width) {
+        if (width < FixedBaseTable::min_width || width > FixedBaseTable::max_width)
+            throw std::domain_error(fmt::format("FixedBaseTable width must be between {} and {}: {}",
+                                                FixedBaseTable::min_width, FixedBaseTable::max_width, width));
+        return width;
+    }
+
+    FixedBaseTable::FixedBaseTable(const Point &base, std::size_t bits, unsigned width):
+        _curve{base.curve()}, _bits{bits}, _width{check_width(width)}, _row_size{std::size_t{1} << (_width - 1)} {
+        if (base.is_infinity())
+            throw std::domain_error("FixedBaseTable cannot be built for the point at infinity.");
+
+        // The signed digits can carry into one more bit than the scalar has, i.e. we need ceil((bits + 1) / w) rows.
+        const auto rows = (bits + width) / width;
+        // Each row is built with mixed additions of its affine base, and all the rows are then normalized together.
+        std::vector<JacobianPoint> multiples;
+        multiples.reserve(rows * _row_size);
+        auto row_base = base;
+        for (std::size_t row = 0; row < rows; ++row) {
+            JacobianPoint multiple{row_base};
+            for (std::size_t d = 1; d <= _row_size; ++d) {
+                multiples.push_back(multiple);
+                if (d < _row_size)
+                    multiple += row_base;
+            }
+
+            // The next row starts at 2^w times this one: 2^(w-1) B' is the last entry, so double it once.
+            row_base = multiple.doubled().to_affine();
+        }
+
+        _table.reserve(multiples.size());
+        for (const auto &multiple: JacobianPoint::to_affine(multiples)) {
+            if (multiple.is_infinity())
+                throw std::domain_error(fmt::format("FixedBaseTable base {} has small order.", base.to_string()));
+            _table.emplace_back(multiple.x(), multiple.y());
+        }
+    }
+
+    JacobianPoint FixedBaseTable::multiply(const BigInt &k) const {
+        const auto &kv = static_cast<const mpz_t&>(k);
+        if (mpz_sgn(kv) < 0 || mpz_sizeinbase(kv, 2) > _bits)
+            throw std::domain_error(fmt::format("FixedBaseTable for {}-bit scalars cannot multiply by {}", _bits, k));
+        const auto curve = _curve.lock();
+        if (curve == nullptr)
+            throw std::domain_error("FixedBaseTable cannot be used once its curve is destroyed.");
+
+        const long modulus = 1L << _width;
+        const long half = modulus >> 1;
+        const auto rows = _table.size() / _row_size;
+
+        auto result = JacobianPoint::infinity(curve);
+        long carry = 0;
+        for (std::size_t row = 0; row < rows; ++row) {
+            // Extract the next w bits of k, and recode them into [-2^(w-1), 2^(w-1)], carrying into the next window.
+            long digit = carry;
+            const auto start = row * _width;
+            for (unsigned bit = 0; bit < _width; ++bit)
+                digit += static_cast<long>(mpz_tstbit(kv, start + bit)) << bit;
+            carry = digit > half ? 1 : 0;
+            digit -= carry * modulus;
+
+            if (digit == 0)
+                continue;
+            const auto &[x, y] = _table[row * _row_size + static_cast<std::size_t>(digit > 0 ? digit : -digit) - 1];
+            result = digit > 0 ? result.add_affine(x, y) : result.add_affine(x, -y);
+        }
+        return result;
+    }
+}
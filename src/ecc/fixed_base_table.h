@@ -0,0 +1,73 @@
+/**
+ * fixed_base_table.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "big_int.h"
+#include "elliptic_curve.h"
+#include "jacobian_point.h"
+#include "modular_int.h"
+#include "point.h"
+
+namespace ecc {
+    // A precomputed table of multiples of a fixed point B, used to compute kB with no doublings.
+    // The scalar is split into w-bit signed digits d_i in [-2^(w-1), 2^(w-1)], so that kB is the sum of the
+    // d_i 2^(wi) B. The table holds each |d| 2^(wi) B in affine coordinates, which makes every step a mixed addition.
+    // For n-bit scalars, this is about n / w additions, against a table of (n / w + 1) 2^(w-1) points.
+    // Once built, a table is never modified, so it may be shared freely between threads.
+    class FixedBaseTable final {
+    public:
+        // The smallest and largest window widths, and the width used for curve generators by default.
+        static constexpr unsigned min_width = 2;
+        static constexpr unsigned max_width = 12;
+        static constexpr unsigned default_width = 8;
+
+        // Build a table for scalars 0 <= k < 2^bits. If the base point is the point at infinity, if some multiple
+        // in the table is the point at infinity, or if the width is out of range, std::domain_error is thrown.
+        FixedBaseTable(const Point &base, std::size_t bits, unsigned width = default_width);
+
+        FixedBaseTable(const FixedBaseTable&) = delete;
+        FixedBaseTable(FixedBaseTable&&) noexcept = default;
+        ~FixedBaseTable() = default;
+
+        FixedBaseTable &operator=(const FixedBaseTable&) = delete;
+        FixedBaseTable &operator=(FixedBaseTable&&) noexcept = default;
+
+        [[nodiscard]] inline unsigned width() const noexcept {
+            return _width;
+        }
+
+        [[nodiscard]] inline std::size_t bits() const noexcept {
+            return _bits;
+        }
+
+        // The number of affine points held in the table.
+        [[nodiscard]] inline std::size_t size() const noexcept {
+            return _table.size();
+        }
+
+        // kB. If k is negative or has more than bits() bits, or the curve of B no longer exists, std::domain_error is
+        // thrown.
+        [[nodiscard]] JacobianPoint multiply(const BigInt&) const;
+
+    private:
+        // The table holds raw coordinates rather than Points, and only a weak reference to the curve, so that a table
+        // held by a curve does not keep the curve alive.
+        using Coordinates = std::pair<ModularInt, ModularInt>;
+
+        std::weak_ptr<const EllipticCurve> _curve;
+        std::size_t _bits;
+        unsigned _width;
+
+        // Row i holds d 2^(wi) B for d = 1, ..., 2^(w-1).
+        std::size_t _row_size;
+        std::vector<Coordinates> _table;
+    };
+}
@@ -0,0 +1,454 @@
+/**
+ * fixed_modular_int.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <gmp.h>
+
+#include "big_int.h"
+#include "gmp_allocator.h"
+#include "modular_int.h"
+
+namespace ecc {
+    namespace fixed {
+        static_assert(GMP_NUMB_BITS == 64 && GMP_NAIL_BITS == 0, "FixedModularInt requires 64-bit GMP limbs.");
+        static_assert(sizeof(unsigned __int128) == 16, "FixedModularInt requires 128-bit integer support.");
+
+        using limb_t = mp_limb_t;
+        using dlimb_t = unsigned __int128;
+
+        template <std::size_t N>
+        using Limbs = std::array<limb_t, N>;
+
+        // Call f(std::integral_constant<std::size_t, I>{}) for each I in [0, N), unrolled at compile time.
+        template <std::size_t N, typename F>
+        constexpr void unroll(F &&f) {
+            [&f]<std::size_t... I>(std::index_sequence<I...>) {
+                (f(std::integral_constant<std::size_t, I>{}), ...);
+            }(std::make_index_sequence<N>{});
+        }
+
+        // r = a + b, returning the carry.
+        template <std::size_t N>
+        constexpr limb_t add_n(Limbs<N> &r, const Limbs<N> &a, const Limbs<N> &b) noexcept {
+            limb_t carry = 0;
+            unroll<N>([&](auto i) {
+                const dlimb_t t = static_cast<dlimb_t>(a[i]) + b[i] + carry;
+                r[i] = static_cast<limb_t>(t);
+                carry = static_cast<limb_t>(t >> 64);
+            });
+            return carry;
+        }
+
+        // r = a - b, returning the borrow.
+        template <std::size_t N>
+        constexpr limb_t sub_n(Limbs<N> &r, const Limbs<N> &a, const Limbs<N> &b) noexcept {
+            limb_t borrow = 0;
+            unroll<N>([&](auto i) {
+                const dlimb_t t = static_cast<dlimb_t>(a[i]) - b[i] - borrow;
+                r[i] = static_cast<limb_t>(t);
+                borrow = static_cast<limb_t>(t >> 64) & 1;
+            });
+            return borrow;
+        }
+
+        // a >= b.
+        template <std::size_t N>
+        constexpr bool geq(const Limbs<N> &a, const Limbs<N> &b) noexcept {
+            for (auto i = N; i-- > 0;)
+                if (a[i] != b[i])
+                    return a[i] > b[i];
+            return true;
+        }
+
+        template <std::size_t N>
+        constexpr bool is_zero(const Limbs<N> &a) noexcept {
+            limb_t acc = 0;
+            unroll<N>([&](auto i) { acc |= a[i]; });
+            return acc == 0;
+        }
+
+        template <std::size_t N>
+        constexpr bool test_bit(const Limbs<N> &a, std::size_t bit) noexcept {
+            return (a[bit / 64] >> (bit % 64)) & 1;
+        }
+
+        // The limbs of a non-negative BigInt, which must fit.
+        template <std::size_t N>
+        Limbs<N> to_limbs(const BigInt &value) {
+            const auto &v = static_cast<const mpz_t&>(value);
+            if (mpz_sgn(v) < 0 || mpz_size(v) > N)
+                throw std::domain_error("Value does not fit in the fixed number of limbs.");
+            Limbs<N> limbs{};
+            for (std::size_t i = 0; i < mpz_size(v); ++i)
+                limbs[i] = mpz_getlimbn(v, static_cast<mp_size_t>(i));
+            return limbs;
+        }
+
+        template <std::size_t N>
+        BigInt from_limbs(const Limbs<N> &limbs) {
+            mpz_t v;
+            mpz_roinit_n(v, limbs.data(), static_cast<mp_size_t>(N));
+            return BigInt{v};
+        }
+    }
+
+    // The constants needed for Montgomery arithmetic in N limbs, with R = 2^{64N}, for an odd modulus p < R.
+    // A FixedField can be built at compile time from the limbs of its modulus. Fields built at runtime should come
+    // from get, which interns them for the lifetime of the program so that elements can hold a plain pointer.
+    template <std::size_t N>
+    class FixedField final {
+    public:
+        using Limbs = fixed::Limbs<N>;
+
+        // If the modulus is even, std::domain_error is thrown.
+        constexpr explicit FixedField(const Limbs &p): _p{p} {
+            if ((p[0] & 1) == 0)
+                throw std::domain_error("FixedField requires an odd modulus.");
+
+            // Newton's iteration for p^{-1} (mod 2^64): five steps take three correct bits to 96.
+            fixed::limb_t inv = p[0];
+            for (auto i = 0; i < 5; ++i)
+                inv *= 2 - p[0] * inv;
+            _p_inv = -inv;
+
+            // R and R^2 (mod p) by repeated modular doubling of 1, which keeps this usable at compile time.
+            Limbs x{};
+            x[0] = 1;
+            for (std::size_t i = 0; i < 64 * N; ++i)
+                double_mod(x);
+            _one = x;
+            for (std::size_t i = 0; i < 64 * N; ++i)
+                double_mod(x);
+            _r2 = x;
+
+            // (p + 1) / 4 when p ≡ 3 (mod 4). Since p is odd, p + 1 only overflows if p = R - 1.
+            if ((p[0] & 3) == 3) {
+                Limbs one{};
+                one[0] = 1;
+                Limbs e{};
+                const auto carry = fixed::add_n(e, p, one);
+                for (std::size_t i = 0; i < N; ++i)
+                    e[i] = (e[i] >> 2) | (i + 1 < N ? e[i + 1] << 62 : carry << 62);
+                _sqrt_exponent = e;
+            }
+        }
+
+        // Get the interned field for the modulus, creating it if necessary.
+        // If the modulus is even or does not fit in N limbs, std::domain_error is thrown.
+        [[nodiscard]] static const FixedField &get(const BigInt &modulus) {
+            // Deliberately leaked: fields live for the lifetime of the program.
+            static auto *mutex = new std::mutex;
+            static auto *fields = new std::map<BigInt, std::unique_ptr<const FixedField>>;
+
+            const ArenaSuspension suspension;
+            std::lock_guard lock{*mutex};
+            auto &entry = (*fields)[modulus];
+            if (!entry)
+                entry = std::make_unique<const FixedField>(fixed::to_limbs<N>(modulus));
+            return *entry;
+        }
+
+        [[nodiscard]] constexpr const Limbs &modulus_limbs() const noexcept {
+            return _p;
+        }
+
+        [[nodiscard]] BigInt modulus() const {
+            return fixed::from_limbs<N>(_p);
+        }
+
+        // R (mod p), i.e. the representation of 1.
+        [[nodiscard]] constexpr const Limbs &one() const noexcept {
+            return _one;
+        }
+
+        [[nodiscard]] constexpr const std::optional<Limbs> &sqrt_exponent() const noexcept {
+            return _sqrt_exponent;
+        }
+
+        constexpr void add(Limbs &r, const Limbs &a, const Limbs &b) const noexcept {
+            const auto carry = fixed::add_n(r, a, b);
+            if (carry || fixed::geq(r, _p))
+                fixed::sub_n(r, r, _p);
+        }
+
+        constexpr void sub(Limbs &r, const Limbs &a, const Limbs &b) const noexcept {
+            if (fixed::sub_n(r, a, b))
+                fixed::add_n(r, r, _p);
+        }
+
+        constexpr void neg(Limbs &r, const Limbs &a) const noexcept {
+            if (fixed::is_zero(a))
+                r = a;
+            else
+                fixed::sub_n(r, _p, a);
+        }
+
+        // Montgomery multiplication r = abR^{-1} (mod p), by coarsely integrated operand scanning.
+        constexpr void mul(Limbs &r, const Limbs &a, const Limbs &b) const noexcept {
+            using fixed::dlimb_t;
+            using fixed::limb_t;
+
+            std::array<limb_t, N + 2> t{};
+            fixed::unroll<N>([&](auto i) {
+                // t += a * b[i].
+                limb_t carry = 0;
+                fixed::unroll<N>([&](auto j) {
+                    const dlimb_t s = static_cast<dlimb_t>(a[j]) * b[i] + t[j] + carry;
+                    t[j] = static_cast<limb_t>(s);
+                    carry = static_cast<limb_t>(s >> 64);
+                });
+                dlimb_t s = static_cast<dlimb_t>(t[N]) + carry;
+                t[N] = static_cast<limb_t>(s);
+                t[N + 1] = static_cast<limb_t>(s >> 64);
+
+                // t = (t + m * p) / 2^64, where m is chosen to clear the bottom limb.
+                const limb_t m = t[0] * _p_inv;
+                s = static_cast<dlimb_t>(m) * _p[0] + t[0];
+                carry = static_cast<limb_t>(s >> 64);
+                fixed::unroll<N - 1>([&](auto j) {
+                    const dlimb_t u = static_cast<dlimb_t>(m) * _p[j + 1] + t[j + 1] + carry;
+                    t[j] = static_cast<limb_t>(u);
+                    carry = static_cast<limb_t>(u >> 64);
+                });
+                s = static_cast<dlimb_t>(t[N]) + carry;
+                t[N - 1] = static_cast<limb_t>(s);
+                t[N] = t[N + 1] + static_cast<limb_t>(s >> 64);
+            });
+
+            // The result is less than 2p, so at most one subtraction is needed.
+            fixed::unroll<N>([&](auto i) { r[i] = t[i]; });
+            if (t[N] || fixed::geq(r, _p))
+                fixed::sub_n(r, r, _p);
+        }
+
+        // Conversion into and out of Montgomery form. Values passed in must be less than p.
+        constexpr void to_montgomery(Limbs &r, const Limbs &a) const noexcept {
+            mul(r, a, _r2);
+        }
+
+        constexpr void from_montgomery(Limbs &r, const Limbs &a) const noexcept {
+            Limbs one{};
+            one[0] = 1;
+            mul(r, a, one);
+        }
+
+    private:
+        Limbs _p;
+        fixed::limb_t _p_inv{};
+        Limbs _one{};
+        Limbs _r2{};
+        std::optional<Limbs> _sqrt_exponent;
+
+        constexpr void double_mod(Limbs &x) const noexcept {
+            const auto carry = fixed::add_n(x, x, x);
+            if (carry || fixed::geq(x, _p))
+                fixed::sub_n(x, x, _p);
+        }
+    };
+
+    // A field element stored inline in N 64-bit limbs, in Montgomery form.
+    // Unlike ModularInt, no operation on a FixedModularInt touches the heap except conversion to and from BigInt,
+    // ModularInt and strings, and invert, which goes through GMP.
+    template <std::size_t N>
+    class FixedModularInt {
+    public:
+        using Limbs = fixed::Limbs<N>;
+
+        FixedModularInt() = delete;
+        constexpr FixedModularInt(const FixedModularInt&) = default;
+        constexpr FixedModularInt(FixedModularInt&&) noexcept = default;
+
+        // The value must be less than the modulus.
+        constexpr FixedModularInt(const Limbs &value, const FixedField<N> &field): _field{&field} {
+            if (fixed::geq(value, field.modulus_limbs()))
+                throw std::domain_error("FixedModularInt value must be reduced.");
+            field.to_montgomery(_limbs, value);
+        }
+
+        FixedModularInt(const BigInt &value, const FixedField<N> &field):
+            FixedModularInt{fixed::to_limbs<N>(value % field.modulus()), field} {}
+
+        explicit FixedModularInt(const ModularInt &m):
+            FixedModularInt{m.get_value(), FixedField<N>::get(m.get_mod())} {}
+
+        explicit FixedModularInt(const std::string_view &input_view): FixedModularInt{ModularInt{input_view}} {}
+
+        constexpr FixedModularInt &operator=(const FixedModularInt&) = default;
+        constexpr FixedModularInt &operator=(FixedModularInt&&) noexcept = default;
+
+        // The zero and one of the field.
+        [[nodiscard]] static constexpr FixedModularInt zero_element(const FixedField<N> &field) noexcept {
+            return FixedModularInt{Limbs{}, &field};
+        }
+
+        [[nodiscard]] static constexpr FixedModularInt one_element(const FixedField<N> &field) noexcept {
+            return FixedModularInt{field.one(), &field};
+        }
+
+        [[nodiscard]] constexpr FixedModularInt operator-() const noexcept {
+            FixedModularInt result{*this};
+            _field->neg(result._limbs, _limbs);
+            return result;
+        }
+
+        [[nodiscard]] constexpr FixedModularInt operator+(const FixedModularInt &other) const {
+            FixedModularInt result{*this};
+            return result += other;
+        }
+
+        [[nodiscard]] constexpr FixedModularInt operator-(const FixedModularInt &other) const {
+            FixedModularInt result{*this};
+            return result -= other;
+        }
+
+        [[nodiscard]] constexpr FixedModularInt operator*(const FixedModularInt &other) const {
+            FixedModularInt result{*this};
+            return result *= other;
+        }
+
+        constexpr FixedModularInt &operator+=(const FixedModularInt &other) {
+            check_same_field(other);
+            _field->add(_limbs, _limbs, other._limbs);
+            return *this;
+        }
+
+        constexpr FixedModularInt &operator-=(const FixedModularInt &other) {
+            check_same_field(other);
+            _field->sub(_limbs, _limbs, other._limbs);
+            return *this;
+        }
+
+        constexpr FixedModularInt &operator*=(const FixedModularInt &other) {
+            check_same_field(other);
+            _field->mul(_limbs, _limbs, other._limbs);
+            return *this;
+        }
+
+        // Raise to a non-negative power given in M limbs, by left-to-right square and multiply.
+        template <std::size_t M>
+        [[nodiscard]] constexpr FixedModularInt pow(const fixed::Limbs<M> &e) const noexcept {
+            auto result = one_element(*_field);
+            for (auto bit = 64 * M; bit-- > 0;) {
+                result *= result;
+                if (fixed::test_bit(e, bit))
+                    result *= *this;
+            }
+            return result;
+        }
+
+        [[nodiscard]] constexpr FixedModularInt pow(std::uint64_t e) const noexcept {
+            return pow(fixed::Limbs<1>{e});
+        }
+
+        // If the exponent is negative, this is inverted first, and std::domain_error is thrown if that fails.
+        [[nodiscard]] FixedModularInt pow(const BigInt &e) const {
+            const auto &exponent = static_cast<const mpz_t&>(e);
+            if (mpz_sgn(exponent) < 0) {
+                const auto inv = invert();
+                if (!inv.has_value())
+                    throw std::domain_error("FixedModularInt has no inverse: " + to_string());
+                return inv->pow(-e);
+            }
+
+            auto result = one_element(*_field);
+            for (auto bit = mpz_sizeinbase(exponent, 2); bit-- > 0;) {
+                result *= result;
+                if (mpz_tstbit(exponent, bit))
+                    result *= *this;
+            }
+            return result;
+        }
+
+        [[nodiscard]] constexpr bool operator==(const FixedModularInt &other) const {
+            check_same_field(other);
+            return _limbs == other._limbs;
+        }
+
+        [[nodiscard]] constexpr bool zero() const noexcept {
+            return fixed::is_zero(_limbs);
+        }
+
+        // The value, out of Montgomery form.
+        [[nodiscard]] constexpr Limbs limbs() const noexcept {
+            Limbs value{};
+            _field->from_montgomery(value, _limbs);
+            return value;
+        }
+
+        [[nodiscard]] constexpr const FixedField<N> &field() const noexcept {
+            return *_field;
+        }
+
+        [[nodiscard]] BigInt get_value() const {
+            return fixed::from_limbs<N>(limbs());
+        }
+
+        [[nodiscard]] ModularInt to_modular_int() const {
+            return ModularInt{get_value(), _field->modulus()};
+        }
+
+        [[nodiscard]] std::string to_string() const {
+            return to_modular_int().to_string();
+        }
+
+        // Find the multiplicative inverse of this element if it exists.
+        [[nodiscard]] std::optional<FixedModularInt> invert() const {
+            const auto value = limbs();
+            mpz_t a, p, inv;
+            mpz_roinit_n(a, value.data(), static_cast<mp_size_t>(N));
+            mpz_roinit_n(p, _field->modulus_limbs().data(), static_cast<mp_size_t>(N));
+            mpz_init(inv);
+            std::optional<FixedModularInt> result;
+            if (mpz_invert(inv, a, p))
+                result = FixedModularInt{BigInt{inv}, *_field};
+            mpz_clear(inv);
+            return result;
+        }
+
+        // Return the square root of the number if it exists, and std::nullopt otherwise.
+        // For p ≡ 3 (mod 4) this is a single inline exponentiation; otherwise it goes through ModularInt.
+        [[nodiscard]] std::optional<FixedModularInt> sqrt() const {
+            if (zero())
+                return std::nullopt;
+            if (const auto &e = _field->sqrt_exponent(); e.has_value()) {
+                const auto x = pow(*e);
+                if (x * x == *this)
+                    return x;
+                return std::nullopt;
+            }
+
+            const auto root = to_modular_int().sqrt();
+            if (!root.has_value())
+                return std::nullopt;
+            return FixedModularInt{root->get_value(), *_field};
+        }
+
+    private:
+        Limbs _limbs;
+        const FixedField<N> *_field;
+
+        // Wrap limbs that are already in Montgomery form.
+        constexpr FixedModularInt(const Limbs &limbs, const FixedField<N> *field) noexcept:
+            _limbs{limbs}, _field{field} {}
+
+        // Check to see if the fields are the same: if not, throw a domain_exception.
+        constexpr void check_same_field(const FixedModularInt &other) const {
+            if (_field != other._field)
+                throw std::domain_error("Computation attempted with incompatible FixedModularInts.");
+        }
+    };
+}
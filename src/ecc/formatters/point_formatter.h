@@ -5,7 +5,6 @@
 
 #pragma once
 
-
 #include "fmt/core.h"
 #include "fmt/format.h"
 
@@ -20,6 +19,6 @@ struct fmt::formatter<ecc::Point> {
 
     template <typename FormatContext>
     auto format(const ecc::Point& p, FormatContext& ctx) {
-        return fmt::format_to(ctx.out(), "({},{})", p.x().get_value(), p.y());
+        return fmt::format_to(ctx.out(), "{}", p.to_string());
     }
 };
\ No newline at end of file
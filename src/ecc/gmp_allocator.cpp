@@ -0,0 +1,267 @@
+/**
+ * gmp_allocator.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include <gmp.h>
+
+#include "gmp_allocator.h"
+
+namespace ecc {
+    // Each block starts with a header recording where it came from, so that it can be freed or grown correctly
+    // whichever thread, pool, or arena is current at the time. The header keeps the block 16-byte aligned.
+    namespace {
+        enum class Source : std::uint32_t {
+            POOL,
+            ARENA,
+            SYSTEM,
+        };
+
+        struct alignas(16) Header {
+            Source source;
+            std::uint32_t size_class;
+            ArenaScope *arena;
+        };
+        static_assert(sizeof(Header) == 16);
+    }
+
+    // The pools hold blocks of 16, 32, ..., 4096 bytes.
+    static constexpr std::size_t min_class_bytes = 16;
+    static constexpr std::size_t size_classes = 9;
+    static constexpr std::size_t max_class_bytes = min_class_bytes << (size_classes - 1);
+
+    // Each pool keeps at most this many free blocks, so that a burst of allocations on one thread does not hold on
+    // to its memory forever.
+    static constexpr std::size_t max_free_blocks = 1024;
+
+    // Arenas take chunks of this size from the system, and give blocks of more than a quarter of it chunks of their
+    // own, so that at most a quarter of each chunk is wasted.
+    static constexpr std::size_t arena_chunk_bytes = 64 * 1024;
+
+    static std::atomic<bool> installed{false};
+
+    static std::size_t size_class(std::size_t size) noexcept {
+        std::size_t c = 0;
+        while ((min_class_bytes << c) < size)
+            ++c;
+        return c;
+    }
+
+    // GMP's own allocation functions print a message and abort when memory runs out, as exceptions cannot be thrown
+    // through its C code safely.
+    static void *system_allocate(std::size_t size) {
+        const auto p = std::malloc(size);
+        if (p == nullptr) {
+            std::fprintf(stderr, "GMP: cannot allocate %zu bytes.\n", size);
+            std::abort();
+        }
+        return p;
+    }
+
+    static Header *header_of(void *block) noexcept {
+        return static_cast<Header*>(block) - 1;
+    }
+
+    static void *block_of(Header *header, Source source, std::uint32_t size_class,
+                          ArenaScope *arena = nullptr) noexcept {
+        header->source = source;
+        header->size_class = size_class;
+        header->arena = arena;
+        return header + 1;
+    }
+
+    namespace {
+        // A free list per size class, threaded through the free blocks themselves.
+        struct Pool {
+            std::array<Header*, size_classes> heads{};
+            std::array<std::size_t, size_classes> counts{};
+
+            ~Pool();
+        };
+    }
+
+    static thread_local Pool pool;
+
+    // Set when this thread's pool has been destroyed on thread exit, after which its blocks go back to the system,
+    // as other thread-local objects holding GMP values may be destroyed after it.
+    static thread_local bool pool_destroyed = false;
+
+    static thread_local ArenaScope *current_arena = nullptr;
+    static thread_local AllocationStats stats;
+
+    Pool::~Pool() {
+        for (std::size_t c = 0; c < size_classes; ++c)
+            while (heads[c] != nullptr) {
+                const auto next = *reinterpret_cast<Header**>(heads[c] + 1);
+                std::free(heads[c]);
+                heads[c] = next;
+            }
+        pool_destroyed = true;
+    }
+
+    static void *pool_allocate(std::size_t size) {
+        if (size > max_class_bytes || pool_destroyed) {
+            ++stats.system_allocations;
+            return block_of(static_cast<Header*>(system_allocate(sizeof(Header) + size)), Source::SYSTEM, 0);
+        }
+
+        const auto c = size_class(size);
+        if (auto header = pool.heads[c]; header != nullptr) {
+            pool.heads[c] = *reinterpret_cast<Header**>(header + 1);
+            --pool.counts[c];
+            ++stats.pool_hits;
+            return block_of(header, Source::POOL, static_cast<std::uint32_t>(c));
+        }
+        ++stats.system_allocations;
+        const auto header = static_cast<Header*>(system_allocate(sizeof(Header) + (min_class_bytes << c)));
+        return block_of(header, Source::POOL, static_cast<std::uint32_t>(c));
+    }
+
+    void *arena_allocate(ArenaScope &arena, std::size_t size) {
+        ++stats.arena_allocations;
+        const auto needed = sizeof(Header) + (size + alignof(Header) - 1) / alignof(Header) * alignof(Header);
+        if (needed > arena._remaining) {
+            const auto chunk_bytes = needed > arena_chunk_bytes / 4 ? needed : arena_chunk_bytes;
+            ++stats.system_allocations;
+            const auto chunk = static_cast<std::byte*>(system_allocate(chunk_bytes));
+            arena._chunks.push_back(chunk);
+            arena._reserved += chunk_bytes;
+
+            // A chunk of its own for a large block leaves the current chunk to carry on.
+            if (chunk_bytes == needed)
+                return block_of(reinterpret_cast<Header*>(chunk), Source::ARENA, 0, &arena);
+            arena._next = chunk;
+            arena._remaining = chunk_bytes;
+        }
+        const auto header = reinterpret_cast<Header*>(arena._next);
+        arena._next += needed;
+        arena._remaining -= needed;
+        return block_of(header, Source::ARENA, 0, &arena);
+    }
+
+    static void release_block(Header *header) noexcept {
+        switch (header->source) {
+            case Source::POOL: {
+                const auto c = header->size_class;
+                if (pool_destroyed || pool.counts[c] >= max_free_blocks) {
+                    std::free(header);
+                    return;
+                }
+                *reinterpret_cast<Header**>(header + 1) = pool.heads[c];
+                pool.heads[c] = header;
+                ++pool.counts[c];
+                return;
+            }
+            case Source::SYSTEM:
+                std::free(header);
+                return;
+            case Source::ARENA:
+                // Released with the rest of the arena.
+                return;
+        }
+    }
+
+    static void release(void *block, std::size_t) noexcept {
+        ++stats.frees;
+        release_block(header_of(block));
+    }
+
+    static void *allocate(std::size_t size) {
+        ++stats.allocations;
+        if (current_arena != nullptr)
+            return arena_allocate(*current_arena, size);
+        return pool_allocate(size);
+    }
+
+    static void *reallocate(void *block, std::size_t old_size, std::size_t new_size) {
+        ++stats.reallocations;
+        const auto header = header_of(block);
+        void *grown = nullptr;
+        switch (header->source) {
+            case Source::POOL:
+                // The block may already be big enough.
+                if (new_size <= min_class_bytes << header->size_class)
+                    return block;
+                grown = pool_allocate(new_size);
+                break;
+            case Source::SYSTEM:
+                if (new_size > max_class_bytes) {
+                    const auto moved = static_cast<Header*>(std::realloc(header, sizeof(Header) + new_size));
+                    if (moved == nullptr) {
+                        std::fprintf(stderr, "GMP: cannot reallocate %zu bytes.\n", new_size);
+                        std::abort();
+                    }
+                    return moved + 1;
+                }
+                grown = pool_allocate(new_size);
+                break;
+            case Source::ARENA:
+                // The block's arena is still alive, as its values must not outlive it, so it grows in place there.
+                grown = arena_allocate(*header->arena, new_size);
+                break;
+        }
+        std::memcpy(grown, block, std::min(old_size, new_size));
+        release_block(header);
+        return grown;
+    }
+
+    void install_gmp_allocator() {
+        static std::once_flag flag;
+        std::call_once(flag, [] {
+            mp_set_memory_functions(allocate, reallocate, release);
+            installed = true;
+        });
+    }
+
+    bool gmp_allocator_installed() noexcept {
+        return installed;
+    }
+
+    AllocationStats AllocationStats::operator-(const AllocationStats &other) const noexcept {
+        return {allocations - other.allocations,
+                reallocations - other.reallocations,
+                frees - other.frees,
+                pool_hits - other.pool_hits,
+                arena_allocations - other.arena_allocations,
+                system_allocations - other.system_allocations};
+    }
+
+    AllocationStats allocation_stats() noexcept {
+        return stats;
+    }
+
+    ArenaScope::ArenaScope(): _previous{current_arena} {
+        if (!installed)
+            throw std::domain_error("ArenaScope requires install_gmp_allocator to have been called.");
+        current_arena = this;
+    }
+
+    ArenaScope::~ArenaScope() {
+        current_arena = _previous;
+        for (const auto chunk: _chunks)
+            std::free(chunk);
+    }
+
+    std::size_t ArenaScope::reserved() const noexcept {
+        return _reserved;
+    }
+
+    ArenaSuspension::ArenaSuspension() noexcept: _suspended{current_arena} {
+        current_arena = nullptr;
+    }
+
+    ArenaSuspension::~ArenaSuspension() {
+        current_arena = _suspended;
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * gmp_allocator.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace ecc {
+    // Install allocation functions for GMP's limb storage in place of its default malloc, realloc, and free.
+    // Blocks of up to 4 KiB come from size-classed pools that belong to the calling thread, so that the temporaries
+    // of the arithmetic are recycled without taking the system allocator's locks, and growing a block within its
+    // size class costs nothing. Larger blocks go to the system allocator.
+    //
+    // GMP requires that blocks are freed by the functions that allocated them, so this must be called before any
+    // GMP allocation, i.e. at the start of main, and before any other thread is started. Later calls do nothing.
+    void install_gmp_allocator();
+
+    [[nodiscard]] bool gmp_allocator_installed() noexcept;
+
+    // The allocation counts of the calling thread since it started, which only change once the allocator has been
+    // installed. Comparing two snapshots shows whether a piece of code allocates, and whether from the system.
+    struct AllocationStats {
+        // Calls by GMP to allocate, reallocate, and free.
+        std::size_t allocations = 0;
+        std::size_t reallocations = 0;
+        std::size_t frees = 0;
+
+        // Blocks taken from this thread's pools, from arenas, and from the system allocator.
+        std::size_t pool_hits = 0;
+        std::size_t arena_allocations = 0;
+        std::size_t system_allocations = 0;
+
+        [[nodiscard]] AllocationStats operator-(const AllocationStats&) const noexcept;
+    };
+
+    [[nodiscard]] AllocationStats allocation_stats() noexcept;
+
+    // While an ArenaScope is alive, every GMP block allocated on its thread is carved from large chunks, freeing it
+    // costs nothing, and the chunks are all released together when the scope ends. This suits batch jobs that make
+    // many temporaries. Values that outlive the scope must not be assigned or modified in it, as GMP may move them
+    // into new blocks, which would come from the arena: results should be written out instead, e.g. with
+    // BigInt::to_bytes. Values made in the scope must stay on its thread. Scopes may be nested.
+    // What the library keeps for itself, such as the interned fields and their tables, curve tables, and per-thread
+    // scratch, is always allocated with the arena suspended, so it may be built in a scope and used after it.
+    // If the allocator has not been installed, std::domain_error is thrown.
+    class ArenaScope final {
+    public:
+        ArenaScope();
+        ~ArenaScope();
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope(ArenaScope&&) = delete;
+        ArenaScope &operator=(const ArenaScope&) = delete;
+        ArenaScope &operator=(ArenaScope&&) = delete;
+
+        // The number of bytes taken from the system for this arena so far.
+        [[nodiscard]] std::size_t reserved() const noexcept;
+
+    private:
+        // The chunks, and the unused end of the last one.
+        std::vector<void*> _chunks;
+        std::byte *_next = nullptr;
+        std::size_t _remaining = 0;
+        std::size_t _reserved = 0;
+
+        // The scope that was active when this one began.
+        ArenaScope *_previous;
+
+        friend void *arena_allocate(ArenaScope&, std::size_t);
+    };
+
+    // While an ArenaSuspension is alive, GMP blocks allocated on its thread come from the pools even if an ArenaScope
+    // is active, and the scope carries on when it ends. Anything that outlives the calls that make it, like a cache,
+    // must be allocated under one. If the allocator has not been installed, this does nothing.
+    class ArenaSuspension final {
+    public:
+        ArenaSuspension() noexcept;
+        ~ArenaSuspension();
+
+        ArenaSuspension(const ArenaSuspension&) = delete;
+        ArenaSuspension(ArenaSuspension&&) = delete;
+        ArenaSuspension &operator=(const ArenaSuspension&) = delete;
+        ArenaSuspension &operator=(ArenaSuspension&&) = delete;
+
+    private:
+        ArenaScope *_suspended;
+    };
+}
@@ -2,33 +2,93 @@
  * rand_gmp.cpp
  * By Sebastian Raaphorst, 2023.
  */
-#include <chrono>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/random.h>
+#else
+#include <random>
+#endif
 
 #include <gmp.h>
 #include "gmp_rng.h"
 #include "big_int.h"
 
 namespace ecc::gmp {
-    gmp_rng::gmp_rng() noexcept {
-        const auto time = std::chrono::high_resolution_clock::now();
-        const auto duration = time.time_since_epoch();
-        const auto seed = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    // The number of limbs read from the system at a time, unless the modulus needs more.
+    static constexpr std::size_t buffer_limbs = 1024;
 
-        gmp_randinit_mt(state);
-        gmp_randseed_ui(state, seed);
+    // Fill the span with bytes from the operating system's cryptographic source.
+    static void system_entropy(std::span<std::uint8_t> bytes) {
+#if defined(__linux__)
+        std::size_t filled = 0;
+        while (filled < bytes.size()) {
+            const auto got = getrandom(bytes.data() + filled, bytes.size() - filled, 0);
+            if (got < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "getrandom failed");
+            }
+            filled += static_cast<std::size_t>(got);
+        }
+#else
+        std::random_device device;
+        for (auto &byte: bytes)
+            byte = static_cast<std::uint8_t>(device());
+#endif
     }
 
-    gmp_rng::~gmp_rng() noexcept {
-        gmp_randclear(state);
+    gmp_rng &gmp_rng::local() {
+        thread_local gmp_rng rng;
+        return rng;
     }
 
-    BigInt gmp_rng::random_mod(const ecc::BigInt &mod) noexcept {
-        mpz_t random_num;
-        mpz_init(random_num);
-        const auto &e = static_cast<const mpz_t&>(mod);
-        mpz_urandomm(random_num, state, e);
-        BigInt result{random_num};
-        mpz_clear(random_num);
+    BigInt gmp_rng::random_mod(const BigInt &mod) {
+        return std::move(random_mod(mod, 1).front());
+    }
+
+    void gmp_rng::refill(std::size_t min_limbs) {
+        _buffer.resize(std::max(buffer_limbs, min_limbs));
+        system_entropy({reinterpret_cast<std::uint8_t*>(_buffer.data()), _buffer.size() * sizeof(mp_limb_t)});
+        _buffer_pos = 0;
+    }
+
+    std::vector<BigInt> gmp_rng::random_mod(const BigInt &mod, std::size_t count) {
+        const auto &m = static_cast<const mpz_t&>(mod);
+        if (mpz_sgn(m) <= 0)
+            throw std::domain_error("random_mod requires a positive modulus.");
+
+        // Take just enough limbs for the bits of mod, mask off the excess, and reject values of mod or more.
+        // That is as uniform as mpz_urandomm, and a candidate is accepted with probability over 1/2.
+        const auto bits = mpz_sizeinbase(m, 2);
+        const auto limbs = (bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+        const auto top_bits = bits - (limbs - 1) * GMP_NUMB_BITS;
+        const auto top_mask = top_bits == GMP_NUMB_BITS ? ~mp_limb_t{0} : (mp_limb_t{1} << top_bits) - 1;
+
+        std::vector<BigInt> result;
+        result.reserve(count);
+        mpz_t value;
+        while (result.size() < count) {
+            if (_buffer.size() - _buffer_pos < limbs)
+                refill(limbs);
+            auto *candidate = _buffer.data() + _buffer_pos;
+            _buffer_pos += limbs;
+            candidate[limbs - 1] &= top_mask;
+
+            // A read-only view of the candidate's limbs in the buffer, which need not be normalized.
+            mpz_roinit_n(value, candidate, static_cast<mp_size_t>(limbs));
+            if (mpz_cmp(value, m) < 0)
+                result.emplace_back(value);
+        }
         return result;
     }
 }
@@ -5,21 +5,44 @@
 
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 #include <gmp.h>
 
 #include "big_int.h"
 
 namespace ecc::gmp {
-    // A random number generator.
+    // A cryptographically secure random number generator, for private keys, nonces, and anything else that must not
+    // be predictable. Every bit is read from the operating system's cryptographic source (getrandom on Linux), in bulk
+    // so that the system calls are amortized: unlike a seeded generator such as GMP's Mersenne Twister, whose state can
+    // be recovered from its outputs, nothing about one draw tells anything about another.
+    // A gmp_rng must not be shared between threads: use local() for the calling thread's own generator.
     class gmp_rng {
     private:
-        gmp_randstate_t state;
+        // Random limbs read from the system in bulk, of which those from _buffer_pos on are still unused.
+        std::vector<mp_limb_t> _buffer;
+        std::size_t _buffer_pos = 0;
+
+        // Refill the buffer with fresh random limbs, at least min_limbs of them.
+        void refill(std::size_t min_limbs);
 
     public:
-        gmp_rng() noexcept;
-        ~gmp_rng() noexcept;
+        gmp_rng() = default;
+        ~gmp_rng() = default;
+
+        gmp_rng(const gmp_rng&) = delete;
+        gmp_rng &operator=(const gmp_rng&) = delete;
+
+        // This thread's generator.
+        [[nodiscard]] static gmp_rng &local();
+
+        // Generate a BigInt in [0, mod). If mod is not positive, std::domain_error is thrown, and if the system's
+        // source fails, std::system_error is.
+        BigInt random_mod(const BigInt &mod);
 
-        // Generate a BigInt in [0,_mod), where _mod is the parameter.
-        BigInt random_mod(const BigInt&) noexcept;
+        // Generate count BigInts in [0, mod) at once, which saves the per-call overhead of the above when many are
+        // needed. Errors are as above.
+        [[nodiscard]] std::vector<BigInt> random_mod(const BigInt &mod, std::size_t count);
     };
 }
@@ -0,0 +1,297 @@
+/**
+ * jacobian_point.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+#include "formatters/modular_int_formatter.h"
+#include "batch_invert.h"
+#include "expression.h"
+#include "jacobian_point.h"
+
+namespace ecc {
+    // The formulas below are those of the Explicit-Formulas Database (hyperelliptic.org/EFD), for short Weierstrass
+    // curves in Jacobian coordinates, named as they are there. Each value is evaluated as one expression, with lazy
+    // reduction, and the small multiples that the database builds up by repeated addition are taken directly.
+    using CoefficientA = EllipticCurve::CoefficientA;
+    using expr::lazy;
+
+    JacobianPoint::JacobianPoint(std::shared_ptr<const EllipticCurve> curve, ModularInt x, ModularInt y, ModularInt z):
+        _curve{std::move(curve)}, _x{std::move(x)}, _y{std::move(y)}, _z{std::move(z)} {}
+
+    JacobianPoint::JacobianPoint(const Point &p):
+        JacobianPoint{p._curve, p._x, p._y, ModularInt{p._infinity ? 0 : 1, p._curve->get_field()}} {}
+
+    JacobianPoint JacobianPoint::infinity(std::shared_ptr<const EllipticCurve> curve) {
+        const auto &field = curve->get_field();
+        return JacobianPoint{curve, ModularInt{1, field}, ModularInt{1, field}, ModularInt{0, field}};
+    }
+
+    bool JacobianPoint::is_infinity() const noexcept {
+        return _z.get_value().zero();
+    }
+
+    bool JacobianPoint::on_curve() const {
+        if (is_infinity())
+            return true;
+        const ModularInt z2 = lazy(_z) * _z;
+        const ModularInt z4 = lazy(z2) * z2;
+        const ModularInt lhs = lazy(_y) * _y;
+        const ModularInt rhs = lazy(_x) * _x * _x + lazy(_curve->a()) * _x * z4 + lazy(_curve->b()) * z4 * z2;
+        return lhs == rhs;
+    }
+
+    JacobianPoint JacobianPoint::operator-() const {
+        return JacobianPoint{_curve, _x, -_y, _z};
+    }
+
+    JacobianPoint JacobianPoint::operator+(const JacobianPoint &other) const {
+        check_same_curve(other._curve);
+        if (is_infinity())
+            return other;
+        if (other.is_infinity())
+            return *this;
+
+        // add-2007-bl.
+        const ModularInt z1z1 = lazy(_z) * _z;
+        const ModularInt z2z2 = lazy(other._z) * other._z;
+        const ModularInt u1 = lazy(_x) * z2z2;
+        const ModularInt u2 = lazy(other._x) * z1z1;
+        const ModularInt s1 = lazy(_y) * other._z * z2z2;
+        const ModularInt s2 = lazy(other._y) * _z * z1z1;
+        const auto h = u2 - u1;
+        const auto r = s2 - s1;
+
+        // The formulas break down when the affine x coordinates agree: then we have either P + P or P + (-P).
+        if (h.get_value().zero()) {
+            if (r.get_value().zero())
+                return doubled();
+            return infinity(_curve);
+        }
+
+        // The database's r is 2 (S2 - S1), and its Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) H = 2 Z1 Z2 H.
+        const ModularInt i = lazy(h) * h * 4;
+        const ModularInt j = lazy(h) * i;
+        const ModularInt v = lazy(u1) * i;
+        ModularInt x3 = lazy(r) * r * 4 - j - lazy(v) * 2;
+        ModularInt y3 = (lazy(r) * (lazy(v) - x3) - lazy(s1) * j) * 2;
+        ModularInt z3 = lazy(_z) * other._z * h * 2;
+        return JacobianPoint{_curve, std::move(x3), std::move(y3), std::move(z3)};
+    }
+
+    JacobianPoint JacobianPoint::operator-(const JacobianPoint &other) const {
+        return *this + -other;
+    }
+
+    JacobianPoint JacobianPoint::operator+(const Point &other) const {
+        check_same_curve(other._curve);
+        if (other._infinity)
+            return *this;
+        return add_affine(other._x, other._y);
+    }
+
+    JacobianPoint JacobianPoint::operator-(const Point &other) const {
+        return *this + -other;
+    }
+
+    JacobianPoint JacobianPoint::add_affine(const ModularInt &x2, const ModularInt &y2) const {
+        if (is_infinity())
+            return JacobianPoint{_curve, x2, y2, ModularInt{1, _curve->get_field()}};
+
+        // madd-2007-bl, i.e. add-2007-bl with Z2 = 1.
+        const ModularInt z1z1 = lazy(_z) * _z;
+        const ModularInt u2 = lazy(x2) * z1z1;
+        const ModularInt s2 = lazy(y2) * _z * z1z1;
+        const auto h = u2 - _x;
+        const auto r = s2 - _y;
+
+        if (h.get_value().zero()) {
+            if (r.get_value().zero())
+                return doubled();
+            return infinity(_curve);
+        }
+
+        // As above, r is 2 (S2 - Y1), and Z3 = (Z1 + H)^2 - Z1Z1 - HH = 2 Z1 H.
+        const ModularInt i = lazy(h) * h * 4;
+        const ModularInt j = lazy(h) * i;
+        const ModularInt v = lazy(_x) * i;
+        ModularInt x3 = lazy(r) * r * 4 - j - lazy(v) * 2;
+        ModularInt y3 = (lazy(r) * (lazy(v) - x3) - lazy(_y) * j) * 2;
+        ModularInt z3 = lazy(_z) * h * 2;
+        return JacobianPoint{_curve, std::move(x3), std::move(y3), std::move(z3)};
+    }
+
+    JacobianPoint JacobianPoint::doubled() const {
+        if (is_infinity() || _y.get_value().zero())
+            return infinity(_curve);
+
+        // In each case, 2 ((X1 + B)^2 - A - C) = 4 X1 B and (Y1 + Z1)^2 - B - D = 2 Y1 Z1, with B = Y1^2, and A and D
+        // the squares of the other coordinates.
+        switch (_curve->a_type()) {
+            case CoefficientA::ZERO: {
+                // dbl-2009-l.
+                const ModularInt a = lazy(_x) * _x;
+                const ModularInt b = lazy(_y) * _y;
+                const ModularInt d = lazy(_x) * b * 4;
+                const ModularInt e = lazy(a) * 3;
+                ModularInt x3 = lazy(e) * e - lazy(d) * 2;
+                ModularInt y3 = lazy(e) * (lazy(d) - x3) - lazy(b) * b * 8;
+                ModularInt z3 = lazy(_y) * _z * 2;
+                return JacobianPoint{_curve, std::move(x3), std::move(y3), std::move(z3)};
+            }
+
+            case CoefficientA::MINUS_THREE: {
+                // dbl-2001-b.
+                const ModularInt delta = lazy(_z) * _z;
+                const ModularInt gamma = lazy(_y) * _y;
+                const ModularInt beta4 = lazy(_x) * gamma * 4;
+                const ModularInt alpha = (lazy(_x) - delta) * (lazy(_x) + delta) * 3;
+                ModularInt x3 = lazy(alpha) * alpha - lazy(beta4) * 2;
+                ModularInt y3 = lazy(alpha) * (lazy(beta4) - x3) - lazy(gamma) * gamma * 8;
+                ModularInt z3 = lazy(_y) * _z * 2;
+                return JacobianPoint{_curve, std::move(x3), std::move(y3), std::move(z3)};
+            }
+
+            default: {
+                // dbl-2007-bl.
+                const ModularInt xx = lazy(_x) * _x;
+                const ModularInt yy = lazy(_y) * _y;
+                const ModularInt zz = lazy(_z) * _z;
+                const ModularInt s = lazy(_x) * yy * 4;
+                const ModularInt m = lazy(xx) * 3 + lazy(_curve->a()) * zz * zz;
+                ModularInt x3 = lazy(m) * m - lazy(s) * 2;
+                ModularInt y3 = lazy(m) * (lazy(s) - x3) - lazy(yy) * yy * 8;
+                ModularInt z3 = lazy(_y) * _z * 2;
+                return JacobianPoint{_curve, std::move(x3), std::move(y3), std::move(z3)};
+            }
+        }
+    }
+
+    JacobianPoint &JacobianPoint::operator+=(const JacobianPoint &other) {
+        return *this = *this + other;
+    }
+
+    JacobianPoint &JacobianPoint::operator-=(const JacobianPoint &other) {
+        return *this = *this - other;
+    }
+
+    JacobianPoint &JacobianPoint::operator+=(const Point &other) {
+        return *this = *this + other;
+    }
+
+    JacobianPoint &JacobianPoint::operator-=(const Point &other) {
+        return *this = *this - other;
+    }
+
+    JacobianPoint JacobianPoint::operator*(const BigInt &k) const {
+        return multiply(k, wnaf_width(mpz_sizeinbase(static_cast<const mpz_t&>(k), 2)));
+    }
+
+    JacobianPoint JacobianPoint::multiply(const BigInt &k, unsigned width) const {
+        const auto digits = k.wnaf(width);
+        if (digits.empty() || is_infinity())
+            return infinity(_curve);
+
+        // table[i] = (2i + 1)P, normalized to affine with one inversion so that the additions below are mixed.
+        const std::size_t table_size = std::size_t{1} << (width - 2);
+        std::vector<JacobianPoint> jacobian_table;
+        jacobian_table.reserve(table_size);
+        jacobian_table.push_back(*this);
+        if (table_size > 1) {
+            const auto twice = doubled();
+            while (jacobian_table.size() < table_size)
+                jacobian_table.push_back(jacobian_table.back() + twice);
+        }
+        const auto table = to_affine(jacobian_table);
+
+        // Left to right: the most significant digit is nonzero, so start from it rather than from infinity.
+        auto idx = digits.size() - 1;
+        const auto top = digits[idx];
+        auto result = JacobianPoint{top > 0 ? table[top >> 1] : -table[-top >> 1]};
+        while (idx-- > 0) {
+            result = result.doubled();
+            if (const auto digit = digits[idx]; digit > 0)
+                result += table[digit >> 1];
+            else if (digit < 0)
+                result -= table[-digit >> 1];
+        }
+        return result;
+    }
+
+    unsigned JacobianPoint::wnaf_width(std::size_t bits) noexcept {
+        // The table costs 2^(w-2) additions, and saves about bits / (w + 1) of them.
+        if (bits < 16)
+            return 2;
+        if (bits < 80)
+            return 3;
+        if (bits < 200)
+            return 4;
+        if (bits < 520)
+            return 5;
+        return 6;
+    }
+
+    bool JacobianPoint::operator==(const JacobianPoint &other) const {
+        check_same_curve(other._curve);
+        if (is_infinity() || other.is_infinity())
+            return is_infinity() == other.is_infinity();
+
+        // Compare X1 Z2^2 with X2 Z1^2, and Y1 Z2^3 with Y2 Z1^3.
+        const auto z1z1 = _z * _z;
+        const auto z2z2 = other._z * other._z;
+        return _x * z2z2 == other._x * z1z1
+            && _y * z2z2 * other._z == other._y * z1z1 * _z;
+    }
+
+    Point JacobianPoint::to_affine() const {
+        if (is_infinity())
+            return Point::infinity(_curve);
+
+        const auto z_inv = _z.invert();
+        if (!z_inv.has_value())
+            throw std::domain_error(fmt::format("Unexpected error: {} has no inverse.", _z));
+        const auto z_inv2 = *z_inv * *z_inv;
+        return Point{_curve, _x * z_inv2, _y * z_inv2 * *z_inv, false};
+    }
+
+    std::vector<Point> JacobianPoint::to_affine(std::span<const JacobianPoint> points) {
+        std::vector<ModularInt> z_inverses;
+        z_inverses.reserve(points.size());
+        for (const auto &p: points)
+            z_inverses.push_back(p._z);
+        (void)batch_invert(z_inverses);
+
+        // The points at infinity have Z = 0, which batch_invert skips over.
+        std::vector<Point> result;
+        result.reserve(points.size());
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            const auto &p = points[i];
+            if (p.is_infinity()) {
+                result.push_back(Point::infinity(p._curve));
+                continue;
+            }
+            const auto &z_inv = z_inverses[i];
+            const auto z_inv2 = z_inv * z_inv;
+            result.push_back(Point{p._curve, p._x * z_inv2, p._y * z_inv2 * z_inv, false});
+        }
+        return result;
+    }
+
+    std::string JacobianPoint::to_string() const {
+        return to_affine().to_string();
+    }
+
+    void JacobianPoint::check_same_curve(const std::shared_ptr<const EllipticCurve> &curve) const {
+        if (!(*_curve == *curve))
+            throw std::domain_error("Computation attempted with points on different curves.");
+    }
+}
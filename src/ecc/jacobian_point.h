@@ -0,0 +1,109 @@
+/**
+ * jacobian_point.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "big_int.h"
+#include "elliptic_curve.h"
+#include "modular_int.h"
+#include "point.h"
+
+namespace ecc {
+    class FixedBaseTable;
+
+    // A point on an elliptic curve in Jacobian coordinates (X : Y : Z), representing the affine point
+    // (X / Z^2, Y / Z^3), with Z = 0 for the point at infinity.
+    // Addition and doubling need no field inversions, so chains of operations should be done here, and
+    // converted to affine with to_affine only when the result is needed.
+    class JacobianPoint final {
+        friend FixedBaseTable;
+    public:
+        JacobianPoint() = delete;
+        JacobianPoint(const JacobianPoint&) = default;
+        JacobianPoint(JacobianPoint&&) noexcept = default;
+        explicit JacobianPoint(const Point&);
+        ~JacobianPoint() = default;
+
+        JacobianPoint &operator=(const JacobianPoint&) = default;
+        JacobianPoint &operator=(JacobianPoint&&) noexcept = default;
+
+        // The point at infinity on the curve.
+        [[nodiscard]] static JacobianPoint infinity(std::shared_ptr<const EllipticCurve>);
+
+        [[nodiscard]] bool is_infinity() const noexcept;
+
+        [[nodiscard]] inline const ModularInt &x() const noexcept {
+            return _x;
+        }
+        [[nodiscard]] inline const ModularInt &y() const noexcept {
+            return _y;
+        }
+        [[nodiscard]] inline const ModularInt &z() const noexcept {
+            return _z;
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<const EllipticCurve> &curve() const noexcept {
+            return _curve;
+        }
+
+        // Determine if the point satisfies Y^2 = X^3 + aXZ^4 + bZ^6.
+        [[nodiscard]] bool on_curve() const;
+
+        [[nodiscard]] JacobianPoint operator-() const;
+        [[nodiscard]] JacobianPoint operator+(const JacobianPoint&) const;
+        [[nodiscard]] JacobianPoint operator-(const JacobianPoint&) const;
+
+        // Mixed addition with an affine point, which is cheaper than a full addition.
+        [[nodiscard]] JacobianPoint operator+(const Point&) const;
+        [[nodiscard]] JacobianPoint operator-(const Point&) const;
+
+        // 2P, specialized for curves with a = 0 and a = -3.
+        [[nodiscard]] JacobianPoint doubled() const;
+
+        JacobianPoint &operator+=(const JacobianPoint&);
+        JacobianPoint &operator-=(const JacobianPoint&);
+        JacobianPoint &operator+=(const Point&);
+        JacobianPoint &operator-=(const Point&);
+
+        // Scalar multiplication kP, using the wNAF of k with a window suited to its size.
+        [[nodiscard]] JacobianPoint operator*(const BigInt&) const;
+
+        // Scalar multiplication kP using the width-w NAF of k, and a table of the odd multiples P, 3P, ...,
+        // (2^(w-1) - 1)P built for the call. If the width is not between 2 and 8, std::domain_error is thrown.
+        [[nodiscard]] JacobianPoint multiply(const BigInt&, unsigned width) const;
+
+        // The wNAF width used by operator* for a scalar with the given number of bits.
+        [[nodiscard]] static unsigned wnaf_width(std::size_t bits) noexcept;
+
+        // Equality of the represented points, which does not require normalizing either side.
+        [[nodiscard]] bool operator==(const JacobianPoint&) const;
+
+        // Convert to affine coordinates, which costs one field inversion.
+        [[nodiscard]] Point to_affine() const;
+
+        // Convert many points to affine coordinates with a single field inversion between them.
+        [[nodiscard]] static std::vector<Point> to_affine(std::span<const JacobianPoint>);
+
+        [[nodiscard]] std::string to_string() const;
+
+    private:
+        std::shared_ptr<const EllipticCurve> _curve;
+        ModularInt _x, _y, _z;
+
+        JacobianPoint(std::shared_ptr<const EllipticCurve>, ModularInt x, ModularInt y, ModularInt z);
+
+        // Mixed addition of the affine point (x, y), which must not be the point at infinity.
+        [[nodiscard]] JacobianPoint add_affine(const ModularInt &x, const ModularInt &y) const;
+
+        // Check to see if the curves are the same: if not, throw a domain_exception.
+        void check_same_curve(const std::shared_ptr<const EllipticCurve>&) const;
+    };
+}
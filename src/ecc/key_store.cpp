@@ -0,0 +1,390 @@
+/**
+ * key_store.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "key_store.h"
+
+namespace ecc {
+    // The fixed-size start of a store. The integers are little-endian, like the limbs.
+    struct Header {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t kind;
+        std::uint32_t limb_bits;
+        std::uint32_t limbs;
+        std::uint64_t count;
+        std::array<std::uint8_t, 32> reserved;
+    };
+    static_assert(sizeof(Header) == 64 && sizeof(Header) % sizeof(mp_limb_t) == 0);
+
+    static constexpr std::array<char, 8> magic{'E', 'C', 'C', 'S', 'T', 'O', 'R', 'E'};
+    static constexpr std::uint32_t version = 1;
+
+    // p, a, and b.
+    static constexpr std::size_t curve_parameters = 3;
+
+    // The records are buffered in chunks of this many limbs when writing.
+    static constexpr std::size_t write_buffer_limbs = 1 << 16;
+
+    // The format is the in-memory layout of the limbs on a little-endian host with 64-bit limbs.
+    static void check_host() {
+        if constexpr (std::endian::native != std::endian::little || GMP_NUMB_BITS != 64 || GMP_NAIL_BITS != 0)
+            throw std::domain_error("KeyStore requires a little-endian host with 64-bit GMP limbs.");
+    }
+
+    static std::size_t coordinates(KeyStore::Kind kind) noexcept {
+        return kind == KeyStore::Kind::POINTS ? 2 : 1;
+    }
+
+    // Copy the limbs of a nonnegative value into the whole of the span, padded with zero limbs.
+    static void copy_limbs(mpz_srcptr value, std::span<mp_limb_t> out) noexcept {
+        const auto size = mpz_size(value);
+        std::copy_n(mpz_limbs_read(value), size, out.begin());
+        std::fill(out.begin() + static_cast<std::ptrdiff_t>(size), out.end(), mp_limb_t{0});
+    }
+
+    struct FileCloser {
+        void operator()(std::FILE *file) const noexcept {
+            std::fclose(file);
+        }
+    };
+
+    // Writes the header, the curve parameters, and then the records through a buffer. If the store is not finished,
+    // because writing it failed, the partial file is removed rather than left behind truncated.
+    class StoreWriter final {
+    public:
+        StoreWriter(const std::filesystem::path &path, KeyStore::Kind kind, std::size_t limbs, std::size_t count):
+                path{path}, limbs{limbs} {
+            check_host();
+            file.reset(std::fopen(path.c_str(), "wb"));
+            if (file == nullptr)
+                throw std::system_error(errno, std::generic_category(), fmt::format("Cannot create {}", path.string()));
+
+            // The destructor does not run if the constructor throws, so the file is removed here.
+            try {
+                Header header{};
+                header.magic = magic;
+                header.version = version;
+                header.kind = static_cast<std::uint32_t>(kind);
+                header.limb_bits = GMP_NUMB_BITS;
+                header.limbs = static_cast<std::uint32_t>(limbs);
+                header.count = count;
+                write(&header, sizeof header);
+                buffer.reserve(write_buffer_limbs);
+            } catch (...) {
+                discard();
+                throw;
+            }
+        }
+
+        StoreWriter(const StoreWriter&) = delete;
+        StoreWriter &operator=(const StoreWriter&) = delete;
+
+        ~StoreWriter() {
+            if (!finished)
+                discard();
+        }
+
+        // Append a value, padded to the fixed width.
+        void append(mpz_srcptr value) {
+            if (buffer.size() + limbs > write_buffer_limbs)
+                flush();
+            buffer.resize(buffer.size() + limbs);
+            copy_limbs(value, std::span{buffer}.last(limbs));
+        }
+
+        void finish() {
+            flush();
+            // fclose flushes the stream's own buffer, so it can fail too.
+            if (std::fclose(file.release()) != 0)
+                throw std::system_error(errno, std::generic_category(), fmt::format("Cannot write {}", path.string()));
+            finished = true;
+        }
+
+    private:
+        const std::filesystem::path &path;
+        std::size_t limbs;
+        std::unique_ptr<std::FILE, FileCloser> file;
+        std::vector<mp_limb_t> buffer;
+        bool finished = false;
+
+        // Close the file, and remove it if it is a regular file, which leaves devices and symlinks alone.
+        void discard() noexcept {
+            file.reset();
+            std::error_code ignored;
+            if (std::filesystem::is_regular_file(std::filesystem::symlink_status(path, ignored)))
+                std::filesystem::remove(path, ignored);
+        }
+
+        void write(const void *data, std::size_t size) {
+            if (std::fwrite(data, 1, size, file.get()) != size)
+                throw std::system_error(errno, std::generic_category(), fmt::format("Cannot write {}", path.string()));
+        }
+
+        void flush() {
+            write(buffer.data(), buffer.size() * sizeof(mp_limb_t));
+            buffer.clear();
+        }
+    };
+
+    LimbView::LimbView(std::span<const mp_limb_t> limbs) noexcept {
+        mpz_roinit_n(view, limbs.data(), static_cast<mp_size_t>(limbs.size()));
+    }
+
+    BigInt LimbView::to_big_int() const {
+        return BigInt{view};
+    }
+
+    KeyStore::KeyStore(void *mapping, std::size_t mapping_size):
+        _kind{Kind::FIELD_ELEMENTS}, _count{0}, _limbs{0},
+        _mapping{mapping}, _mapping_size{mapping_size}, _records{nullptr} {}
+
+    KeyStore::KeyStore(KeyStore &&other) noexcept:
+        _kind{other._kind}, _count{other._count}, _limbs{other._limbs},
+        _field{std::move(other._field)}, _curve{std::move(other._curve)},
+        _mapping{std::exchange(other._mapping, nullptr)}, _mapping_size{std::exchange(other._mapping_size, 0)},
+        _records{std::exchange(other._records, nullptr)} {}
+
+    KeyStore::~KeyStore() {
+        if (_mapping != nullptr)
+            munmap(_mapping, _mapping_size);
+    }
+
+    KeyStore &KeyStore::operator=(KeyStore &&other) noexcept {
+        if (this != &other) {
+            if (_mapping != nullptr)
+                munmap(_mapping, _mapping_size);
+            _kind = other._kind;
+            _count = other._count;
+            _limbs = other._limbs;
+            _field = std::move(other._field);
+            _curve = std::move(other._curve);
+            _mapping = std::exchange(other._mapping, nullptr);
+            _mapping_size = std::exchange(other._mapping_size, 0);
+            _records = std::exchange(other._records, nullptr);
+        }
+        return *this;
+    }
+
+    void KeyStore::write(const std::filesystem::path &path, const std::shared_ptr<const PrimeField> &field,
+                         std::span<const ModularInt> elements) {
+        for (const auto &m: elements)
+            if (m.get_field() != field)
+                throw std::domain_error(fmt::format("KeyStore given an element mod {} for a store mod {}.",
+                                                    m.get_mod(), field->modulus()));
+
+        const BigInt zero;
+        StoreWriter writer{path, Kind::FIELD_ELEMENTS, field->limbs(), elements.size()};
+        writer.append(static_cast<const mpz_t&>(field->modulus()));
+        writer.append(static_cast<const mpz_t&>(zero));
+        writer.append(static_cast<const mpz_t&>(zero));
+        for (const auto &m: elements)
+            writer.append(static_cast<const mpz_t&>(m.get_value()));
+        writer.finish();
+    }
+
+    void KeyStore::write(const std::filesystem::path &path, const std::shared_ptr<const EllipticCurve> &curve,
+                         std::span<const Point> points) {
+        for (const auto &p: points)
+            if (!(*p.curve() == *curve))
+                throw std::domain_error(fmt::format("KeyStore given a point {} that is not on the curve {}.",
+                                                    p.to_string(), curve->to_string()));
+
+        const auto &field = curve->get_field();
+        const auto &modulus = static_cast<const mpz_t&>(field->modulus());
+        StoreWriter writer{path, Kind::POINTS, field->limbs(), points.size()};
+        writer.append(modulus);
+        writer.append(static_cast<const mpz_t&>(curve->a().get_value()));
+        writer.append(static_cast<const mpz_t&>(curve->b().get_value()));
+        // The point at infinity is (p, 0).
+        const BigInt zero;
+        for (const auto &p: points) {
+            if (p.is_infinity()) {
+                writer.append(modulus);
+                writer.append(static_cast<const mpz_t&>(zero));
+            } else {
+                writer.append(static_cast<const mpz_t&>(p.x().get_value()));
+                writer.append(static_cast<const mpz_t&>(p.y().get_value()));
+            }
+        }
+        writer.finish();
+    }
+
+    KeyStore KeyStore::open(const std::filesystem::path &path) {
+        return open(path, nullptr);
+    }
+
+    KeyStore KeyStore::open(const std::filesystem::path &path, std::shared_ptr<const EllipticCurve> curve) {
+        check_host();
+        const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), fmt::format("Cannot open {}", path.string()));
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0) {
+            const auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), fmt::format("Cannot stat {}", path.string()));
+        }
+        const auto size = static_cast<std::size_t>(st.st_size);
+        if (size < sizeof(Header)) {
+            ::close(fd);
+            throw std::domain_error(fmt::format("{} is too short to be a KeyStore.", path.string()));
+        }
+
+        // The mapping keeps the file open, so the descriptor is not needed after this.
+        const auto mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const auto error = errno;
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            throw std::system_error(error, std::generic_category(), fmt::format("Cannot map {}", path.string()));
+
+        // From here, the store owns the mapping, and unmaps it if the checks below throw.
+        KeyStore store{mapping, size};
+        Header header;
+        std::memcpy(&header, mapping, sizeof header);
+        if (header.magic != magic || header.version != version || header.limb_bits != GMP_NUMB_BITS
+            || header.limbs == 0 || header.kind > static_cast<std::uint32_t>(Kind::POINTS))
+            throw std::domain_error(fmt::format("{} does not have a supported KeyStore header.", path.string()));
+        store._kind = static_cast<Kind>(header.kind);
+        store._limbs = header.limbs;
+
+        // Check that the records fill the rest of the file exactly, without overflowing in the arithmetic.
+        const auto body = size - sizeof(Header);
+        const auto record_limbs = store._limbs * coordinates(store._kind);
+        const auto available = body / sizeof(mp_limb_t);
+        if (body % sizeof(mp_limb_t) != 0 || available / curve_parameters < store._limbs
+            || (available - curve_parameters * store._limbs) % record_limbs != 0
+            || (available - curve_parameters * store._limbs) / record_limbs != header.count)
+            throw std::domain_error(fmt::format("{} is {} bytes, which does not agree with its header.",
+                                                path.string(), size));
+        store._count = header.count;
+
+        const auto parameters = reinterpret_cast<const mp_limb_t*>(static_cast<const std::byte*>(mapping)
+                                                                    + sizeof(Header));
+        store._records = parameters + curve_parameters * store._limbs;
+        const auto parameter = [&](std::size_t i) {
+            return LimbView{std::span{parameters + i * store._limbs, store._limbs}}.to_big_int();
+        };
+
+        // The modulus must use all of the limbs, so that the store has one layout per field.
+        const auto modulus = parameter(0);
+        if (mpz_size(static_cast<const mpz_t&>(modulus)) != store._limbs)
+            throw std::domain_error(fmt::format("{} has a modulus of the wrong width.", path.string()));
+        store._field = PrimeField::get(modulus);
+
+        if (store._kind == Kind::FIELD_ELEMENTS) {
+            if (curve != nullptr)
+                throw std::domain_error(fmt::format("{} is a store of field elements, not points.", path.string()));
+            return store;
+        }
+
+        const auto a = parameter(1);
+        const auto b = parameter(2);
+        if (curve == nullptr) {
+            curve = EllipticCurve::create(a, b, modulus);
+        } else if (curve->get_field() != store._field || !(curve->a().get_value() == a)
+                   || !(curve->b().get_value() == b)) {
+            throw std::domain_error(fmt::format("{} is a store of points on y^2 = x^3 + {}x + {} mod {}, not on {}.",
+                                                path.string(), a, b, modulus, curve->to_string()));
+        }
+        store._curve = std::move(curve);
+        return store;
+    }
+
+    const std::shared_ptr<const EllipticCurve> &KeyStore::curve() const {
+        if (_kind != Kind::POINTS)
+            throw std::domain_error("A KeyStore of field elements has no curve.");
+        return _curve;
+    }
+
+    LimbView KeyStore::element_view(std::size_t i) const noexcept {
+        return LimbView{record(i, 0)};
+    }
+
+    LimbView KeyStore::x_view(std::size_t i) const noexcept {
+        return LimbView{record(i, 0)};
+    }
+
+    LimbView KeyStore::y_view(std::size_t i) const noexcept {
+        return LimbView{record(i, 1)};
+    }
+
+    bool KeyStore::is_infinity(std::size_t i) const {
+        check_index(i, Kind::POINTS);
+        return mpz_cmp(x_view(i), static_cast<const mpz_t&>(_field->modulus())) == 0;
+    }
+
+    ModularInt KeyStore::element(std::size_t i) const {
+        check_index(i, Kind::FIELD_ELEMENTS);
+        auto value = element_view(i).to_big_int();
+        if (!(value < _field->modulus()))
+            throw std::domain_error(fmt::format("KeyStore element {} is not reduced: {}", i, value));
+        return ModularInt{std::move(value), _field};
+    }
+
+    Point KeyStore::point(std::size_t i) const {
+        if (is_infinity(i))
+            return _curve->infinity();
+        const auto x = x_view(i).to_big_int();
+        const auto y = y_view(i).to_big_int();
+        if (!(x < _field->modulus()) || !(y < _field->modulus()))
+            throw std::domain_error(fmt::format("KeyStore point {} has a coordinate that is not reduced.", i));
+        return _curve->point(x, y);
+    }
+
+    std::optional<std::size_t> KeyStore::find(const Point &p) const {
+        if (_kind != Kind::POINTS || !(*p.curve() == *_curve))
+            throw std::domain_error(fmt::format("KeyStore cannot contain the point {}.", p.to_string()));
+
+        // Compare in place, with the point at infinity as (p, 0).
+        const BigInt zero;
+        const auto &x = static_cast<const mpz_t&>(p.is_infinity() ? _field->modulus() : p.x().get_value());
+        const auto &y = static_cast<const mpz_t&>(p.is_infinity() ? zero : p.y().get_value());
+        for (std::size_t i = 0; i < _count; ++i)
+            if (mpz_cmp(x_view(i), x) == 0 && mpz_cmp(y_view(i), y) == 0)
+                return i;
+        return std::nullopt;
+    }
+
+    std::span<const mp_limb_t> KeyStore::record(std::size_t i, std::size_t coordinate) const noexcept {
+        return {_records + (i * coordinates(_kind) + coordinate) * _limbs, _limbs};
+    }
+
+    void KeyStore::check_index(std::size_t i, Kind kind) const {
+        if (_kind != kind)
+            throw std::domain_error(fmt::format("KeyStore of {} accessed as a store of {}.",
+                                                _kind == Kind::POINTS ? "points" : "field elements",
+                                                kind == Kind::POINTS ? "points" : "field elements"));
+        if (i >= _count)
+            throw std::domain_error(fmt::format("KeyStore index {} out of range for {} entries.", i, _count));
+    }
+}
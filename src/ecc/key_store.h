@@ -0,0 +1,131 @@
+/**
+ * key_store.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include <gmp.h>
+
+#include "big_int.h"
+#include "elliptic_curve.h"
+#include "modular_int.h"
+#include "point.h"
+#include "prime_field.h"
+
+namespace ecc {
+    // A read-only mpz_t over limbs that belong to someone else, made with mpz_roinit_n, which can be passed to any
+    // GMP function that takes an mpz_srcptr. It must not outlive the limbs.
+    class LimbView final {
+    public:
+        explicit LimbView(std::span<const mp_limb_t>) noexcept;
+
+        [[nodiscard]] inline operator mpz_srcptr() const noexcept {
+            return view;
+        }
+
+        // Copy the value out of the view.
+        [[nodiscard]] BigInt to_big_int() const;
+
+    private:
+        mpz_t view;
+    };
+
+    // An on-disk array of field elements or of points, which is memory-mapped when opened, so that loading it costs
+    // a check of the header rather than a parse of every element.
+    //
+    // The file is a 64-byte header, followed by the modulus p and the curve coefficients a and b (both zero for a
+    // store of field elements), and then the elements, or the x and y of the points. Every one of these is a
+    // fixed-width little-endian run of 64-bit limbs, as wide as p, so each starts on a limb boundary and is used in
+    // place. The point at infinity is stored with x = p, which is not a valid coordinate.
+    //
+    // Stores are written and read on little-endian hosts with 64-bit limbs: otherwise, std::domain_error is thrown.
+    class KeyStore final {
+    public:
+        enum class Kind {
+            FIELD_ELEMENTS,
+            POINTS,
+        };
+
+        KeyStore(const KeyStore&) = delete;
+        KeyStore(KeyStore&&) noexcept;
+        ~KeyStore();
+
+        KeyStore &operator=(const KeyStore&) = delete;
+        KeyStore &operator=(KeyStore&&) noexcept;
+
+        // Write elements of the field. If any element is from another field, std::domain_error is thrown.
+        // If the file cannot be written, std::system_error is thrown.
+        static void write(const std::filesystem::path&, const std::shared_ptr<const PrimeField>&,
+                          std::span<const ModularInt>);
+
+        // Write points on the curve. If any point is on another curve, std::domain_error is thrown.
+        // If the file cannot be written, std::system_error is thrown.
+        static void write(const std::filesystem::path&, const std::shared_ptr<const EllipticCurve>&,
+                          std::span<const Point>);
+
+        // Map a store. If the file cannot be opened or mapped, std::system_error is thrown, and if the header is not
+        // that of a store, or does not agree with the size of the file, std::domain_error is thrown.
+        [[nodiscard]] static KeyStore open(const std::filesystem::path&);
+
+        // Map a store of points on the given curve, so that they share the curve, its generator and its tables.
+        // In addition to the above, if the store is not of points on this curve, std::domain_error is thrown.
+        [[nodiscard]] static KeyStore open(const std::filesystem::path&, std::shared_ptr<const EllipticCurve>);
+
+        [[nodiscard]] inline Kind kind() const noexcept {
+            return _kind;
+        }
+
+        [[nodiscard]] inline std::size_t size() const noexcept {
+            return _count;
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<const PrimeField> &get_field() const noexcept {
+            return _field;
+        }
+
+        // The curve of a store of points. If this is a store of field elements, std::domain_error is thrown.
+        [[nodiscard]] const std::shared_ptr<const EllipticCurve> &curve() const;
+
+        // Views of the i-th field element, or of the coordinates of the i-th point, which is not at infinity.
+        // These do not check their arguments.
+        [[nodiscard]] LimbView element_view(std::size_t) const noexcept;
+        [[nodiscard]] LimbView x_view(std::size_t) const noexcept;
+        [[nodiscard]] LimbView y_view(std::size_t) const noexcept;
+
+        [[nodiscard]] bool is_infinity(std::size_t) const;
+
+        // Copy out the i-th field element or point, checking that it is reduced, or on the curve.
+        // If the index is out of range, the store is of the wrong kind, or the check fails, std::domain_error is
+        // thrown.
+        [[nodiscard]] ModularInt element(std::size_t) const;
+        [[nodiscard]] Point point(std::size_t) const;
+
+        // The index of the first occurrence of the point, compared in place, or std::nullopt if it is not stored.
+        [[nodiscard]] std::optional<std::size_t> find(const Point&) const;
+
+    private:
+        Kind _kind;
+        std::size_t _count;
+        std::size_t _limbs;
+        std::shared_ptr<const PrimeField> _field;
+        std::shared_ptr<const EllipticCurve> _curve;
+
+        // The mapping, and the records, which start after the header and the curve parameters.
+        void *_mapping;
+        std::size_t _mapping_size;
+        const mp_limb_t *_records;
+
+        KeyStore(void *mapping, std::size_t mapping_size);
+
+        [[nodiscard]] std::span<const mp_limb_t> record(std::size_t, std::size_t coordinate) const noexcept;
+        void check_index(std::size_t, Kind) const;
+    };
+}
@@ -6,7 +6,10 @@
 #ifdef DEBUG
 #include <iostream>
 #endif
+#include <algorithm>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <stdexcept>
@@ -17,7 +20,6 @@
 #include <gmp.h>
 
 #include "operations.h"
-#include "gmp_rng.h"
 
 #include "formatters/big_int_formatter.h"
 #include "formatters/modular_int_formatter.h"
@@ -26,7 +28,7 @@
 namespace ecc {
     using namespace operations;
 
-    static gmp::gmp_rng rng;
+    static const std::string div_error{"Division by zero."};
 
     // The representation of a ModularInt.
     static std::string modular_int_string(const BigInt &value, const BigInt &mod) {
@@ -37,6 +39,10 @@ namespace ecc {
         return static_cast<int>(legendre);
     }
 
+    // The 2-adic valuation of p - 1 from which sqrt uses the field's lookup tables rather than plain Tonelli and
+    // Shanks, whose cost grows with its square.
+    static constexpr mp_bitcnt_t sqrt_table_threshold = 8;
+
     // Used by the std::string_view constructor to extract the BigInts.
     [[nodiscard]] static std::pair<BigInt, BigInt> parse_big_ints(const std::string_view input_view) {
         const auto openPos = input_view.find('(');
@@ -52,104 +58,162 @@ namespace ecc {
         return {std::move(value), std::move(mod)};
     }
 
-    // Make sure we reduce in case _value >= _mod.
-    ModularInt::ModularInt(BigInt value, BigInt mod): _value{std::move(value)}, _mod{std::move(mod)} {
-        if (_mod.zero())
+    // Make sure we reduce in case _value >= _mod. The value is reduced into storage made with room for any element,
+    // rather than kept and grown later.
+    ModularInt::ModularInt(BigInt value, BigInt mod) {
+        if (mod.zero())
             throw std::domain_error(fmt::format("Tried to create a ModularInt with _mod 0: {}",
-                                                modular_int_string(_value, _mod)));
-        _value %= _mod;
+                                                modular_int_string(value, mod)));
+        _field = PrimeField::get(mod);
+        _value.reserve(_field->element_capacity());
+        reduce(value.value);
+    }
+
+    ModularInt::ModularInt(BigInt value, std::shared_ptr<const PrimeField> field): ModularInt{std::move(field)} {
+        reduce(value.value);
+    }
+
+    ModularInt::ModularInt(std::shared_ptr<const PrimeField> field):
+        _value{BigInt::with_capacity(field->element_capacity())}, _field{std::move(field)} {}
+
+    // A copy gets the full capacity too, rather than just enough for its value, as it is usually a value to update.
+    ModularInt::ModularInt(const ModularInt &other): ModularInt{other._field} {
+        mpz_set(_value.value, other._value.value);
     }
 
     ModularInt::ModularInt(const std::string_view &input_view):
         ModularInt(std::forward<std::pair<BigInt, BigInt>>(parse_big_ints(input_view))) {}
 
-    ModularInt::ModularInt(std::pair<BigInt, BigInt> &&pair): ModularInt(std::get<0>(pair), std::get<1>(pair)) {}
+    ModularInt::ModularInt(std::pair<BigInt, BigInt> &&pair):
+        ModularInt(std::move(pair.first), std::move(pair.second)) {}
+
+    template <auto F>
+    ModularInt ModularInt::op_once(const ModularInt &other) const {
+        check_same_mod(other);
+        ModularInt result{_field};
+        F(result._value.value, _value.value, other._value.value);
+        result.reduce_once();
+        return result;
+    }
+
+    template <auto F>
+    ModularInt &ModularInt::op_once_set(const ModularInt &other) {
+        check_same_mod(other);
+        F(_value.value, _value.value, other._value.value);
+        reduce_once();
+        return *this;
+    }
+
+    template <auto F>
+    ModularInt ModularInt::op_wide(const ModularInt &other) const {
+        check_same_mod(other);
+        auto &product = _field->scratch().product;
+        F(product.value, _value.value, other._value.value);
+        ModularInt result{_field};
+        result.reduce(product.value);
+        return result;
+    }
+
+    template <auto F>
+    ModularInt &ModularInt::op_wide_set(const ModularInt &other) {
+        check_same_mod(other);
+        auto &product = _field->scratch().product;
+        F(product.value, _value.value, other._value.value);
+        reduce(product.value);
+        return *this;
+    }
 
     ModularInt ModularInt::operator-() const {
-        return op(negation<BigInt>);
+        ModularInt result{_field};
+        if (!_value.zero())
+            mpz_sub(result._value.value, mod().value, _value.value);
+        return result;
     }
 
     ModularInt ModularInt::operator+(const ModularInt &other) const {
-        return op(addition<BigInt>, other);
+        return op_once<mpz_add>(other);
     }
 
     ModularInt ModularInt::operator-(const ModularInt &other) const {
-        return op(subtraction<BigInt>, other);
+        return op_once<mpz_sub>(other);
     }
 
     ModularInt ModularInt::operator*(const ModularInt &other) const {
-        return op(multiplication<BigInt>, other);
+        return op_wide<mpz_mul>(other);
     }
 
     ModularInt ModularInt::operator/(const ModularInt &other) const {
-        return op(division<BigInt>, other);
+        other._value.check(div_error);
+        return op_wide<mpz_fdiv_q>(other);
     }
 
     ModularInt ModularInt::pow(const BigInt &n) const {
-        mpz_t pvalue;
-        mpz_init_set(pvalue, _value.value);
-        mpz_powm(pvalue, pvalue, n.value, _mod.value);
-        ModularInt result{pvalue, _mod};
-        mpz_clear(pvalue);
+        // The result is already reduced, and has room for it.
+        ModularInt result{_field};
+        mpz_powm(result._value.value, _value.value, n.value, mod().value);
         return result;
     }
 
    ModularInt ModularInt::pow(long n) const {
-        ModularInt a{1, _mod};
+        ModularInt a{_field};
 
         // Power 0 obviously gives 1 (_mod m).
-        if (n == 0L)
+        if (n == 0L) {
+            mpz_set_ui(a._value.value, 1);
+            a.reduce_once();
             return a;
+        }
 
         // To take a^n, take {a^{-1}}^n.
         if (n < 0) {
-            auto a_opt = invert();
-            if (!a_opt.has_value())
-                throw std::domain_error(fmt::format("ModularInt has no inverse: {}", a));
-            a._value = (*a_opt)._value;
+            if (!mpz_invert(a._value.value, _value.value, mod().value))
+                throw std::domain_error(fmt::format("ModularInt has no inverse: {}", *this));
             n = -n;
         } else
-            a._value = _value;
+            mpz_set(a._value.value, _value.value);
 
-        mpz_powm_ui(a._value.value, a._value.value, n, _mod.value);
+        mpz_powm_ui(a._value.value, a._value.value, n, mod().value);
         return a;
     }
 
     ModularInt &ModularInt::operator+=(const ModularInt &other) {
-        return op_set(addition<BigInt>, other);
+        return op_once_set<mpz_add>(other);
     }
 
     ModularInt &ModularInt::operator-=(const ModularInt &other) {
-        return op_set(subtraction<BigInt>, other);
+        return op_once_set<mpz_sub>(other);
     }
 
     ModularInt &ModularInt::operator*=(const ModularInt &other) {
-        return op_set(multiplication<BigInt>, other);
+        return op_wide_set<mpz_mul>(other);
     }
 
     ModularInt &ModularInt::operator/=(const ModularInt &other) {
-        return op_set(division<BigInt>, other);
+        other._value.check(div_error);
+        return op_wide_set<mpz_fdiv_q>(other);
     }
 
     ModularInt &ModularInt::operator++() {
-        _value = (++_value) % _mod;
+        mpz_add_ui(_value.value, _value.value, 1);
+        reduce_once();
         return *this;
     }
 
     ModularInt ModularInt::operator++(int) {
         ModularInt tmp{*this};
-        _value = (_value + 1) % _mod;
+        ++*this;
         return tmp;
     }
 
     ModularInt &ModularInt::operator--() {
-        _value = (--_value) % _mod;
+        mpz_sub_ui(_value.value, _value.value, 1);
+        reduce_once();
         return *this;
     }
 
     ModularInt ModularInt::operator--(int) {
         ModularInt tmp{*this};
-        _value = (_value - 1) % _mod;
+        --*this;
         return tmp;
     }
 
@@ -164,12 +228,34 @@ namespace ecc {
     }
 
     std::string ModularInt::to_string() const noexcept {
-        return modular_int_string(_value, _mod);
+        return modular_int_string(_value, mod());
+    }
+
+    void ModularInt::to_bytes(std::span<std::uint8_t> out, BigInt::Endian endian) const {
+        if (out.size() != _field->bytes())
+            throw std::domain_error(fmt::format("{} needs a buffer of {} bytes, not {}.",
+                                                *this, _field->bytes(), out.size()));
+        _value.to_bytes(out, endian);
+    }
+
+    ModularInt ModularInt::from_bytes(std::span<const std::uint8_t> in, std::shared_ptr<const PrimeField> field,
+                                      BigInt::Endian endian) {
+        if (in.size() != field->bytes())
+            throw std::domain_error(fmt::format("Elements of the field mod {} are {} bytes, not {}.",
+                                                field->modulus(), field->bytes(), in.size()));
+        auto value = BigInt::from_bytes(in, endian);
+        if (!(value < field->modulus()))
+            throw std::domain_error(fmt::format("Encoded value {} is not reduced mod {}.", value, field->modulus()));
+
+        // The value is already reduced, so skip the constructor's mod.
+        ModularInt result{std::move(field)};
+        result._value = std::move(value);
+        return result;
     }
 
     ModularInt::Legendre ModularInt::legendre() const {
         // We use GMP functions here for efficiency.
-        switch (mpz_legendre(_value.value, _mod.value)) {
+        switch (mpz_legendre(_value.value, mod().value)) {
             case  1: return Legendre::RESIDUE;
             case -1: return Legendre::NOT_RESIDUE;
             default: return Legendre::DIVIDES;
@@ -181,50 +267,79 @@ namespace ecc {
     }
 
     std::optional<ModularInt> ModularInt::sqrt() const {
-        // If a non-residue class, exit immediately.
-        if (legendre() != Legendre::RESIDUE)
+        // Zero has no Legendre symbol of 1, and so is not treated as having a square root.
+        if (_value.zero())
             return std::nullopt;
 
-        // Test the last two bits of the modulus.
-        // If they are both 1, then we can use Fermat's Little Theorem to calculate the result:
+        // If the modulus is 3 (mod 4), then we can use Fermat's Little Theorem to calculate the result:
         // x = a^{(n+1)/4} (_mod n)
         // n+1 converts the last two bits from 1 to 0, and thus 4 divides n+1.
         // By Fermat:
         // a^n = a (_mod n)
         // a^{n+1} = a^2 (_mod n)
         // a^{(n+1)/4} = a^{1/2} (_mod n), which is exactly what we want.
-        if (_mod.check_bit(0) && _mod.check_bit(1))
-            return pow((_mod + 1) / 4);
-
-        // Otherwise, we must use the Tonelli and Shanks method.
-        // Initialize q to n - 1 (even), find # of zeros on right in binary representation, and eliminate them.
-        // std::clog << "Invoking Tonelli and Shanks\n";
-        auto q = _mod - 1;
-        const auto e = mpz_scan1(q.value, 0);
-        mpz_tdiv_q_2exp(q.value, q.value, e);
-
-        // Find a generator.
-        // Randomly search for non-residue.
-        ModularInt n{1, _mod};
-        while (n.legendre() != Legendre::NOT_RESIDUE)
-            n = ModularInt{rng.random_mod(_mod.value), _mod};
+        // The exponent is cached by the field. If a is not a residue, x^2 = -a instead, so checking x is cheaper
+        // than computing the Legendre symbol first.
+        if (const auto &exponent = _field->sqrt_exponent(); exponent.has_value()) {
+            auto x = pow(*exponent);
+            if (is_square_of(x))
+                return x;
+            return std::nullopt;
+        }
+
+        if (_field->atkin_exponent().has_value())
+            return atkin_sqrt();
+
+        if (_field->tonelli_shanks().e >= sqrt_table_threshold)
+            return table_sqrt();
+        return tonelli_shanks_sqrt();
+    }
+
+    std::optional<ModularInt> ModularInt::atkin_sqrt() const {
+        // For p ≡ 5 (mod 8), with t = (2a)^{(p-5)/8} and i = 2at^2, i is a square root of -1 if a is a residue,
+        // and then x = at(i - 1) is a square root of a.
+        // The intermediate values are updated in place, so that none of them need new storage.
+        auto two_a = *this;
+        two_a += *this;
+        const auto t = two_a.pow(*_field->atkin_exponent());
+        auto i = std::move(two_a);
+        i *= t;
+        i *= t;
+        --i;
+        auto x = *this;
+        x *= t;
+        x *= i;
+        if (is_square_of(x))
+            return x;
+        return std::nullopt;
+    }
+
+    std::optional<ModularInt> ModularInt::tonelli_shanks_sqrt() const {
+        // The decomposition n - 1 = q * 2^e and the generator n^q for a non-residue n are cached by the field.
+        const auto &ts = _field->tonelli_shanks();
 
         // Initialize working components.
-        // y = n^q, where q is a BigInt, so the power is calculated with with the _mod of n.
-        auto y = n.pow(q);
-        auto r = e;
+        // y = n^q.
+        ModularInt y{ts.generator, _field};
+        auto r = ts.e;
 
         // x = a^{{q-1}/2}
         // q-1 should be exactly divisible by 2 now.
-        auto x = pow((q - 1) / 2);
-        auto b = (*this) * x * x;
-        x = (*this) * x;
+        auto x = pow(ts.q_minus_one_half);
+        auto b = x;
+        b *= x;
+        b *= *this;
+        x *= *this;
+
+        // The values of the loop are updated in place, so that their storage is reused on every iteration.
+        auto t1 = b;
+        auto t = y;
 
         // Loop on algorithm until finished or failure. Terminate when b == 1.
         while (b._value != 1) {
-            // Find minimum m such that b^{2m} = 1 (_mod p).
-            auto m = 1;
-            auto t1 = b;
+            // Find minimum m such that b^{2^m} = 1 (_mod p).
+            mp_bitcnt_t m = 1;
+            t1 = b;
             while (m < r) {
                 t1 *= t1;
                 if (t1._value == 1)
@@ -232,63 +347,107 @@ namespace ecc {
                 ++m;
             }
 
-            // Should never happen as a is quadratic residue.
-            if (r == m) {
-#ifdef DEBUG
-                std::clog << "ERROR: " << to_string() << " is not a quadratic residue!\n";
-#endif
-                throw std::domain_error(fmt::format("Unexpected error: {} is not a quadratic residue.", *this));
-            }
+            // If no such m < r exists, b has order 2^r, which happens iff a is not a quadratic residue.
+            if (r == m)
+                return std::nullopt;
 
-            // Calculate t = y^{2^{r - m - 1}}.
-            const auto shift_by = r - m - 1;
-            const auto shift = 1 << shift_by;
-            const auto t = y.pow(shift);
+            // Calculate t = y^{2^{r - m - 1}} by repeated squaring, as the exponent need not fit in a long.
+            t = y;
+            for (auto i = r - m - 1; i > 0; --i)
+                t *= t;
 
-            y = t * t;
+            y = t;
+            y *= t;
             r = m;
-            x = x * t;
+            x *= t;
             b *= y;
         }
 
         return x;
     }
 
-    std::optional<ModularInt> ModularInt::invert() const {
-        // We use GMP functions here for efficiency.
-        mpz_t result;
-        mpz_init(result);
-        const auto success = mpz_invert(result, _value.value, _mod.value);
-
-        if (success) {
-            ModularInt m{BigInt{result}, _mod};
-            mpz_clear(result);
-            return m;
+    std::optional<ModularInt> ModularInt::table_sqrt() const {
+        const auto &ts = _field->tonelli_shanks();
+        const auto &tables = _field->sqrt_tables();
+        const auto &p = mod().value;
+        const auto window = tables.window;
+
+        // As in Tonelli and Shanks, x = a^{(q+1)/2} and c = a^q = g^k for some k, so that x^2 = a g^k, and
+        // x g^{-k/2} is a square root of a when k is even, which it is iff a is a residue.
+        auto x = pow(ts.q_minus_one_half);
+        auto c = x;
+        c *= x;
+        c *= *this;
+        x *= *this;
+
+        // Find k a window at a time from the bottom. With the known low bits K of k cleared from c = g^{k - K},
+        // squaring e - offset - v times leaves h^{j}, whose lookup gives the next v bits of k. The squares are
+        // taken in the scratch space.
+        auto &scratch = _field->scratch();
+        auto &t = scratch.element;
+        auto k = BigInt::with_capacity(ts.e + 1);
+        for (mp_bitcnt_t offset = 0, step = 0; offset < ts.e; offset += window, ++step) {
+            const auto v = std::min(window, ts.e - offset);
+            mpz_set(t.value, c._value.value);
+            for (auto i = ts.e - offset - v; i > 0; --i) {
+                mpz_mul(scratch.product.value, t.value, t.value);
+                mpz_mod(t.value, scratch.product.value, p);
+            }
+            const auto digit = tables.digits.find(t);
+            if (digit == tables.digits.end())
+                throw std::domain_error(fmt::format("Unexpected error: no square root table entry modulo {}.",
+                                                    mod()));
+            const auto d = digit->second >> (window - v);
+            if (offset == 0 && d % 2 == 1) {
+                // k is odd, so a is not a quadratic residue.
+                return std::nullopt;
+            }
+
+            // c is multiplied in the scratch space too, so the correction is used as it is.
+            mpz_mul(scratch.product.value, c._value.value, tables.corrections[step][d].value);
+            c.reduce(scratch.product.value);
+            mpz_set_ui(t.value, d);
+            mpz_mul_2exp(t.value, t.value, offset);
+            mpz_add(k.value, k.value, t.value);
         }
 
-        mpz_clear(result);
+        mpz_fdiv_q_2exp(k.value, k.value, 1);
+        ModularInt correction{_field};
+        mpz_powm(correction._value.value, tables.generator_inverse.value, k.value, p);
+        x *= correction;
+        return x;
+    }
+
+    std::optional<ModularInt> ModularInt::invert() const {
+        // We use GMP functions here for efficiency. The inverse is already reduced.
+        ModularInt result{_field};
+        if (mpz_invert(result._value.value, _value.value, mod().value))
+            return result;
         return std::nullopt;
     }
 
     void ModularInt::check_same_mod(const ModularInt &other) const {
-        if (_mod != other._mod) {
+        if (_field != other._field) {
             throw std::domain_error(fmt::format("Computation attempted with incompatible ModularInts: {} and {}.",
                                                 *this, other));
         }
     }
 
-    ModularInt ModularInt::op(const bigint_func1 &f) const {
-        return ModularInt{f(_value), _mod};
+    void ModularInt::reduce_once() noexcept {
+        if (mpz_sgn(_value.value) < 0)
+            mpz_add(_value.value, _value.value, mod().value);
+        else if (mpz_cmp(_value.value, mod().value) >= 0)
+            mpz_sub(_value.value, _value.value, mod().value);
     }
 
-    ModularInt ModularInt::op(const bigint_func2 &f, const ModularInt &other) const {
-        check_same_mod(other);
-        return ModularInt{f(_value, other._value), _mod};
+    bool ModularInt::is_square_of(const ModularInt &x) const {
+        auto &product = _field->scratch().product;
+        mpz_mul(product.value, x._value.value, x._value.value);
+        mpz_mod(product.value, product.value, mod().value);
+        return mpz_cmp(product.value, _value.value) == 0;
     }
 
-    ModularInt &ModularInt::op_set(const bigint_func2 &f, const ModularInt &other) {
-        check_same_mod(other);
-        _value = f(_value, other._value) % _mod;
-        return *this;
+    void ModularInt::reduce(mpz_srcptr value) noexcept {
+        mpz_mod(_value.value, value, mod().value);
     }
 }
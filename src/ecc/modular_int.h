@@ -5,14 +5,22 @@
 
 #pragma once
 
-#include <functional>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 
 #include "big_int.h"
+#include "prime_field.h"
 
 namespace ecc {
+    namespace expr {
+        struct Access;
+    }
+
     class ModularInt {
+        friend expr::Access;
     public:
         enum class Legendre {
             DIVIDES = 0,
@@ -22,9 +30,10 @@ namespace ecc {
         static int legendre_value(Legendre) noexcept;
 
         ModularInt() = delete;
-        ModularInt(const ModularInt&) = default;
+        ModularInt(const ModularInt&);
         ModularInt(ModularInt&&) noexcept = default;
         ModularInt(BigInt, BigInt);
+        ModularInt(BigInt, std::shared_ptr<const PrimeField>);
         ModularInt(const std::string_view&);
         ~ModularInt() = default;
 
@@ -59,11 +68,24 @@ namespace ecc {
         }
 
         [[nodiscard]] inline const BigInt &get_mod() const {
-            return _mod;
+            return _field->modulus();
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<const PrimeField> &get_field() const noexcept {
+            return _field;
         }
 
         [[nodiscard]] std::string to_string() const noexcept;
 
+        // Write the value into a buffer of exactly the field's bytes(), without the modulus.
+        // If the buffer is the wrong length, std::domain_error is thrown.
+        void to_bytes(std::span<std::uint8_t>, BigInt::Endian = BigInt::Endian::BIG) const;
+
+        // Read an element of the field from exactly bytes() bytes, as written by to_bytes.
+        // If the length is wrong or the value is not reduced, std::domain_error is thrown.
+        [[nodiscard]] static ModularInt from_bytes(std::span<const std::uint8_t>, std::shared_ptr<const PrimeField>,
+                                                   BigInt::Endian = BigInt::Endian::BIG);
+
         // Find the Legendre _value of (_value/_mod), which is:
         // 0 if _mod | _value
         // 1 if _value is a residue class, i.e. there exists b such that b^2 ≡ _value (_mod)
@@ -71,7 +93,9 @@ namespace ecc {
         [[nodiscard]] Legendre legendre() const;
         [[nodiscard]] bool residue() const;
 
-        // Return the square root of the number if it exists, and std::nullopt.
+        // Return the square root of the number if it exists, and std::nullopt otherwise, or if the number is zero.
+        // This uses a^{(p+1)/4} for p ≡ 3 (mod 4), Atkin's method for p ≡ 5 (mod 8), and Tonelli and Shanks
+        // otherwise, with the field's lookup tables when p - 1 is divisible by a large power of 2.
         [[nodiscard]] std::optional<ModularInt> sqrt() const;
 
         // Find the multiplicative inverse of this element if it exists, which
@@ -82,24 +106,51 @@ namespace ecc {
             return _value;
         }
         [[nodiscard]] const inline BigInt &mod() const noexcept {
-            return _mod;
+            return _field->modulus();
         }
 
     private:
         BigInt _value;
-        BigInt _mod;
+        std::shared_ptr<const PrimeField> _field;
 
         // Delegates to pair-extracted constructor.
         explicit ModularInt(std::pair<BigInt, BigInt>&&);
 
-        using bigint_func1 = std::function<BigInt(const BigInt&)>;
-        using bigint_func2 = std::function<BigInt(const BigInt&, const BigInt&)>;
+        // A zero element of the field, with room for any element, for operations to write their results into.
+        explicit ModularInt(std::shared_ptr<const PrimeField>);
 
-        // Check to see if the _mod values are the same: if not, throw a domain_exception.
+        // Check to see if the fields are the same: if not, throw a domain_exception.
+        // Since fields are interned, this is a pointer comparison.
         void check_same_mod(const ModularInt&) const;
 
-        [[nodiscard]] ModularInt op(const bigint_func1&) const;
-        [[nodiscard]] ModularInt op(const bigint_func2&, const ModularInt&) const;
-        [[nodiscard]] ModularInt &op_set(const bigint_func2&, const ModularInt&);
+        // The square root algorithms behind sqrt, for a nonzero value. Each one finds a candidate without first
+        // checking that the value is a residue, and returns std::nullopt if the candidate shows that it is not.
+        [[nodiscard]] std::optional<ModularInt> atkin_sqrt() const;
+        [[nodiscard]] std::optional<ModularInt> tonelli_shanks_sqrt() const;
+        [[nodiscard]] std::optional<ModularInt> table_sqrt() const;
+
+        // Whether x^2 is this value, computed in the scratch space.
+        [[nodiscard]] bool is_square_of(const ModularInt&) const;
+
+        // Bring a value in (-_mod, 2 * _mod) back into [0, _mod) with at most one addition or subtraction.
+        void reduce_once() noexcept;
+
+        // Set the value to a value of any size brought into [0, _mod) with a division.
+        void reduce(mpz_srcptr) noexcept;
+
+        // As with BigInt, the GMP function F is a template parameter so that the call is direct. The result is F
+        // applied to the two values. For op_once, F must give a result in (-_mod, 2 * _mod), which is written
+        // straight into the result's value and brought back into range by reduce_once. For op_wide, F may give a
+        // result of up to twice the size of the modulus, which is written into the scratch space and reduced from
+        // there into the result's value, so that neither has to grow.
+        // These are only instantiated in modular_int.cpp.
+        template <auto F>
+        [[nodiscard]] ModularInt op_once(const ModularInt&) const;
+        template <auto F>
+        ModularInt &op_once_set(const ModularInt&);
+        template <auto F>
+        [[nodiscard]] ModularInt op_wide(const ModularInt&) const;
+        template <auto F>
+        ModularInt &op_wide_set(const ModularInt&);
     };
 }
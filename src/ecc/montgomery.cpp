@@ -0,0 +1,460 @@
+/**
+ * montgomery.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "montgomery.h"
+
+namespace ecc {
+    // Moduli of up to this many limbs keep their double-width products on the stack.
+    static constexpr std::size_t stack_limbs = 32;
+
+    // The window width used by pow.
+    static constexpr unsigned pow_window = 4;
+
+    // Copy the value of a, which must fit, into exactly n limbs, padding with zeros.
+    static void copy_limbs(mp_limb_t *rp, mpz_srcptr a, std::size_t n) noexcept {
+        const auto size = mpz_size(a);
+        mpn_copyi(rp, mpz_limbs_read(a), static_cast<mp_size_t>(size));
+        mpn_zero(rp + size, static_cast<mp_size_t>(n - size));
+    }
+
+    // A double-width product buffer, on the stack when small enough.
+    namespace {
+        class ProductBuffer {
+        public:
+            explicit ProductBuffer(std::size_t n) {
+                if (n > stack_limbs) {
+                    heap.resize(2 * n);
+                    ptr = heap.data();
+                } else
+                    ptr = stack.data();
+            }
+
+            [[nodiscard]] inline mp_limb_t *data() noexcept {
+                return ptr;
+            }
+
+        private:
+            std::array<mp_limb_t, 2 * stack_limbs> stack;
+            std::vector<mp_limb_t> heap;
+            mp_limb_t *ptr;
+        };
+    }
+
+    Montgomery::Montgomery(const BigInt &modulus) {
+        const auto &p = static_cast<const mpz_t&>(modulus);
+        if (mpz_cmp_ui(p, 3) < 0 || mpz_even_p(p))
+            throw std::domain_error(fmt::format("Montgomery form requires an odd modulus: {}", modulus));
+
+        _n = mpz_size(p);
+        _p.resize(_n);
+        copy_limbs(_p.data(), p, _n);
+
+        // Newton's iteration for p^{-1} (mod 2^GMP_NUMB_BITS): p * p ≡ 1 (mod 8) for odd p, so we start with
+        // three correct bits, and each step doubles them.
+        mp_limb_t inv = _p[0];
+        for (auto i = 0; i < 5; ++i)
+            inv *= 2 - _p[0] * inv;
+        _p_inv = -inv;
+
+        // R, R^2 and R^3 (mod p).
+        mpz_t r, r2, r3;
+        mpz_inits(r, r2, r3, nullptr);
+        mpz_setbit(r, _n * GMP_NUMB_BITS);
+        mpz_mod(r, r, p);
+        mpz_mul(r2, r, r);
+        mpz_mod(r2, r2, p);
+        mpz_mul(r3, r2, r);
+        mpz_mod(r3, r3, p);
+
+        _one.resize(_n);
+        _r2.resize(_n);
+        _r3.resize(_n);
+        copy_limbs(_one.data(), r, _n);
+        copy_limbs(_r2.data(), r2, _n);
+        copy_limbs(_r3.data(), r3, _n);
+        mpz_clears(r3, r2, r, nullptr);
+
+        const auto n = static_cast<mp_size_t>(_n);
+        _sec_itch = 2 * _n + static_cast<std::size_t>(std::max(mpn_sec_mul_itch(n, n), mpn_sec_sqr_itch(n)));
+    }
+
+    void Montgomery::redc(mp_limb_t *rp, mp_limb_t *tp) const noexcept {
+        // Clear one limb at a time from the bottom by adding a multiple of p. The carry out of each step is
+        // parked in the limb that was just cleared, and they are all added back in at the end.
+        auto *up = tp;
+        for (std::size_t i = 0; i < _n; ++i) {
+            const mp_limb_t q = up[0] * _p_inv;
+            up[0] = mpn_addmul_1(up, _p.data(), static_cast<mp_size_t>(_n), q);
+            ++up;
+        }
+
+        // The result is less than 2p, so at most one subtraction is needed.
+        const auto carry = mpn_add_n(rp, up, tp, static_cast<mp_size_t>(_n));
+        if (carry || mpn_cmp(rp, _p.data(), static_cast<mp_size_t>(_n)) >= 0)
+            mpn_sub_n(rp, rp, _p.data(), static_cast<mp_size_t>(_n));
+    }
+
+    void Montgomery::add(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        const auto carry = mpn_add_n(rp, ap, bp, n);
+        if (carry || mpn_cmp(rp, _p.data(), n) >= 0)
+            mpn_sub_n(rp, rp, _p.data(), n);
+    }
+
+    void Montgomery::sub(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        if (mpn_sub_n(rp, ap, bp, n))
+            mpn_add_n(rp, rp, _p.data(), n);
+    }
+
+    void Montgomery::neg(mp_limb_t *rp, const mp_limb_t *ap) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        if (mpn_zero_p(ap, n))
+            mpn_zero(rp, n);
+        else
+            mpn_sub_n(rp, _p.data(), ap, n);
+    }
+
+    void Montgomery::mul(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+        ProductBuffer t{_n};
+        mpn_mul_n(t.data(), ap, bp, static_cast<mp_size_t>(_n));
+        redc(rp, t.data());
+    }
+
+    void Montgomery::sqr(mp_limb_t *rp, const mp_limb_t *ap) const noexcept {
+        ProductBuffer t{_n};
+        mpn_sqr(t.data(), ap, static_cast<mp_size_t>(_n));
+        redc(rp, t.data());
+    }
+
+    void Montgomery::pow(mp_limb_t *rp, const mp_limb_t *ap, const BigInt &e) const {
+        const auto &exponent = static_cast<const mpz_t&>(e);
+        if (mpz_sgn(exponent) < 0)
+            throw std::domain_error(fmt::format("Montgomery pow requires a non-negative exponent: {}", e));
+
+        const auto n = static_cast<mp_size_t>(_n);
+        if (mpz_sgn(exponent) == 0) {
+            mpn_copyi(rp, _one.data(), n);
+            return;
+        }
+
+        // Fixed window exponentiation: table[i] = a^i.
+        constexpr std::size_t table_size = 1U << pow_window;
+        std::vector<mp_limb_t> table(table_size * _n);
+        mpn_copyi(table.data(), _one.data(), n);
+        mpn_copyi(table.data() + _n, ap, n);
+        for (std::size_t i = 2; i < table_size; ++i)
+            mul(table.data() + i * _n, table.data() + (i - 1) * _n, ap);
+
+        const auto digit = [&exponent](std::size_t window) {
+            unsigned d = 0;
+            for (unsigned bit = 0; bit < pow_window; ++bit)
+                d |= static_cast<unsigned>(mpz_tstbit(exponent, window * pow_window + bit)) << bit;
+            return d;
+        };
+
+        const auto windows = (mpz_sizeinbase(exponent, 2) + pow_window - 1) / pow_window;
+        std::vector<mp_limb_t> acc(_n);
+        mpn_copyi(acc.data(), table.data() + digit(windows - 1) * _n, n);
+        for (auto window = windows - 1; window-- > 0;) {
+            for (unsigned i = 0; i < pow_window; ++i)
+                sqr(acc.data(), acc.data());
+            if (const auto d = digit(window); d != 0)
+                mul(acc.data(), acc.data(), table.data() + d * _n);
+        }
+        mpn_copyi(rp, acc.data(), n);
+    }
+
+    bool Montgomery::invert(mp_limb_t *rp, const mp_limb_t *ap) const {
+        const auto n = static_cast<mp_size_t>(_n);
+        if (mpn_zero_p(ap, n))
+            return false;
+
+        // Invert aR directly to get a^{-1}R^{-1}, and then a Montgomery multiplication by R^3 gives a^{-1}R.
+        mpz_t a, p, inv;
+        mpz_roinit_n(a, ap, n);
+        mpz_roinit_n(p, _p.data(), n);
+        mpz_init(inv);
+        if (!mpz_invert(inv, a, p)) {
+            mpz_clear(inv);
+            return false;
+        }
+
+        std::vector<mp_limb_t> tmp(_n);
+        copy_limbs(tmp.data(), inv, _n);
+        mpz_clear(inv);
+        mul(rp, tmp.data(), _r3.data());
+        return true;
+    }
+
+    void Montgomery::to_montgomery(mp_limb_t *rp, const BigInt &a) const {
+        // aR = REDC(a * R^2).
+        std::vector<mp_limb_t> tmp(_n);
+        copy_limbs(tmp.data(), static_cast<const mpz_t&>(a), _n);
+        mul(rp, tmp.data(), _r2.data());
+    }
+
+    BigInt Montgomery::from_montgomery(const mp_limb_t *ap) const {
+        // a = REDC(aR).
+        ProductBuffer t{_n};
+        const auto n = static_cast<mp_size_t>(_n);
+        mpn_copyi(t.data(), ap, n);
+        mpn_zero(t.data() + _n, n);
+
+        std::vector<mp_limb_t> result(_n);
+        redc(result.data(), t.data());
+
+        mpz_t value;
+        mpz_roinit_n(value, result.data(), n);
+        return BigInt{value};
+    }
+
+    bool Montgomery::is_zero(const mp_limb_t *ap) const noexcept {
+        return mpn_zero_p(ap, static_cast<mp_size_t>(_n));
+    }
+
+    void Montgomery::sec_redc(mp_limb_t *rp, mp_limb_t *tp) const noexcept {
+        // As redc, but the result is always computed both with and without the subtraction of p, and the right one
+        // is selected with a mask.
+        const auto n = static_cast<mp_size_t>(_n);
+        auto *up = tp;
+        for (std::size_t i = 0; i < _n; ++i) {
+            const mp_limb_t q = up[0] * _p_inv;
+            up[0] = mpn_addmul_1(up, _p.data(), n, q);
+            ++up;
+        }
+
+        // The low half of tp is free now, so it holds the difference.
+        const auto carry = mpn_add_n(rp, up, tp, n);
+        const auto borrow = mpn_sub_n(tp, rp, _p.data(), n);
+        mpn_cnd_swap(carry | (borrow ^ 1), rp, tp, n);
+    }
+
+    void Montgomery::sec_add(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        ProductBuffer t{_n};
+        const auto carry = mpn_add_n(rp, ap, bp, n);
+        const auto borrow = mpn_sub_n(t.data(), rp, _p.data(), n);
+        mpn_cnd_swap(carry | (borrow ^ 1), rp, t.data(), n);
+    }
+
+    void Montgomery::sec_sub(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        const auto borrow = mpn_sub_n(rp, ap, bp, n);
+        mpn_cnd_add_n(borrow, rp, rp, _p.data(), n);
+    }
+
+    void Montgomery::sec_mul(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp,
+                             mp_limb_t *scratch) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        mpn_sec_mul(scratch, ap, n, bp, n, scratch + 2 * _n);
+        sec_redc(rp, scratch);
+    }
+
+    void Montgomery::sec_sqr(mp_limb_t *rp, const mp_limb_t *ap, mp_limb_t *scratch) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        mpn_sec_sqr(scratch, ap, n, scratch + 2 * _n);
+        sec_redc(rp, scratch);
+    }
+
+    void Montgomery::sec_to_montgomery(mp_limb_t *rp, const mp_limb_t *ap, mp_limb_t *scratch) const noexcept {
+        sec_mul(rp, ap, _r2.data(), scratch);
+    }
+
+    void Montgomery::sec_from_montgomery(mp_limb_t *rp, const mp_limb_t *ap) const noexcept {
+        const auto n = static_cast<mp_size_t>(_n);
+        ProductBuffer t{_n};
+        mpn_copyi(t.data(), ap, n);
+        mpn_zero(t.data() + _n, n);
+        sec_redc(rp, t.data());
+    }
+
+    MontgomeryInt::MontgomeryInt(std::shared_ptr<const PrimeField> field):
+        _limbs(field->montgomery().limbs()), _field{std::move(field)} {}
+
+    MontgomeryInt::MontgomeryInt(const ModularInt &m): MontgomeryInt{m.get_field()} {
+        engine().to_montgomery(_limbs.data(), m.get_value());
+    }
+
+    MontgomeryInt::MontgomeryInt(const BigInt &value, std::shared_ptr<const PrimeField> field):
+        MontgomeryInt{std::move(field)} {
+        engine().to_montgomery(_limbs.data(), value % _field->modulus());
+    }
+
+    MontgomeryInt MontgomeryInt::operator-() const {
+        MontgomeryInt result{_field};
+        engine().neg(result._limbs.data(), _limbs.data());
+        return result;
+    }
+
+    MontgomeryInt MontgomeryInt::operator+(const MontgomeryInt &other) const {
+        check_same_field(other);
+        MontgomeryInt result{_field};
+        engine().add(result._limbs.data(), _limbs.data(), other._limbs.data());
+        return result;
+    }
+
+    MontgomeryInt MontgomeryInt::operator-(const MontgomeryInt &other) const {
+        check_same_field(other);
+        MontgomeryInt result{_field};
+        engine().sub(result._limbs.data(), _limbs.data(), other._limbs.data());
+        return result;
+    }
+
+    MontgomeryInt MontgomeryInt::operator*(const MontgomeryInt &other) const {
+        check_same_field(other);
+        MontgomeryInt result{_field};
+        engine().mul(result._limbs.data(), _limbs.data(), other._limbs.data());
+        return result;
+    }
+
+    MontgomeryInt MontgomeryInt::pow(const BigInt &n) const {
+        if (mpz_sgn(static_cast<const mpz_t&>(n)) < 0) {
+            const auto inv = invert();
+            if (!inv.has_value())
+                throw std::domain_error(fmt::format("MontgomeryInt has no inverse: {}", to_string()));
+            return inv->pow(-n);
+        }
+
+        MontgomeryInt result{_field};
+        engine().pow(result._limbs.data(), _limbs.data(), n);
+        return result;
+    }
+
+    MontgomeryInt MontgomeryInt::pow(long n) const {
+        return pow(BigInt{n});
+    }
+
+    MontgomeryInt &MontgomeryInt::operator+=(const MontgomeryInt &other) {
+        check_same_field(other);
+        engine().add(_limbs.data(), _limbs.data(), other._limbs.data());
+        return *this;
+    }
+
+    MontgomeryInt &MontgomeryInt::operator-=(const MontgomeryInt &other) {
+        check_same_field(other);
+        engine().sub(_limbs.data(), _limbs.data(), other._limbs.data());
+        return *this;
+    }
+
+    MontgomeryInt &MontgomeryInt::operator*=(const MontgomeryInt &other) {
+        check_same_field(other);
+        engine().mul(_limbs.data(), _limbs.data(), other._limbs.data());
+        return *this;
+    }
+
+    bool MontgomeryInt::operator==(const MontgomeryInt &other) const {
+        check_same_field(other);
+        return _limbs == other._limbs;
+    }
+
+    BigInt MontgomeryInt::get_value() const {
+        return engine().from_montgomery(_limbs.data());
+    }
+
+    ModularInt MontgomeryInt::to_modular_int() const {
+        return ModularInt{get_value(), _field};
+    }
+
+    bool MontgomeryInt::zero() const noexcept {
+        return mpn_zero_p(_limbs.data(), static_cast<mp_size_t>(_limbs.size()));
+    }
+
+    std::string MontgomeryInt::to_string() const {
+        return to_modular_int().to_string();
+    }
+
+    ModularInt::Legendre MontgomeryInt::legendre() const {
+        return to_modular_int().legendre();
+    }
+
+    bool MontgomeryInt::residue() const {
+        return legendre() == ModularInt::Legendre::RESIDUE;
+    }
+
+    std::optional<MontgomeryInt> MontgomeryInt::sqrt() const {
+        if (zero())
+            return std::nullopt;
+
+        // If p ≡ 3 (mod 4), a^{(p+1)/4} is the root if there is one, so we can skip the Legendre symbol and check
+        // the candidate instead.
+        if (const auto &exponent = _field->sqrt_exponent(); exponent.has_value()) {
+            auto x = pow(*exponent);
+            if (x * x == *this)
+                return x;
+            return std::nullopt;
+        }
+
+        if (!residue())
+            return std::nullopt;
+
+        // Tonelli and Shanks, as in ModularInt::sqrt, but entirely in Montgomery form.
+        const auto &ts = _field->tonelli_shanks();
+        const auto n = static_cast<mp_size_t>(_limbs.size());
+        const auto is_one = [this, n](const MontgomeryInt &m) {
+            return mpn_cmp(m._limbs.data(), engine().one(), n) == 0;
+        };
+
+        MontgomeryInt y{ts.generator, _field};
+        auto r = ts.e;
+        auto x = pow(ts.q_minus_one_half);
+        auto b = (*this) * x * x;
+        x *= *this;
+
+        while (!is_one(b)) {
+            // Find minimum m such that b^{2^m} = 1 (mod p).
+            mp_bitcnt_t m = 1;
+            auto t1 = b;
+            while (m < r) {
+                t1 *= t1;
+                if (is_one(t1))
+                    break;
+                ++m;
+            }
+
+            // Should never happen as a is quadratic residue.
+            if (r == m)
+                throw std::domain_error(fmt::format("Unexpected error: {} is not a quadratic residue.", to_string()));
+
+            // Calculate t = y^{2^{r - m - 1}} by repeated squaring.
+            auto t = y;
+            for (auto i = r - m - 1; i > 0; --i)
+                t *= t;
+
+            y = t * t;
+            r = m;
+            x *= t;
+            b *= y;
+        }
+
+        return x;
+    }
+
+    std::optional<MontgomeryInt> MontgomeryInt::invert() const {
+        MontgomeryInt result{_field};
+        if (engine().invert(result._limbs.data(), _limbs.data()))
+            return result;
+        return std::nullopt;
+    }
+
+    void MontgomeryInt::check_same_field(const MontgomeryInt &other) const {
+        if (_field != other._field) {
+            throw std::domain_error(fmt::format("Computation attempted with incompatible MontgomeryInts: {} and {}.",
+                                                to_string(), other.to_string()));
+        }
+    }
+}
@@ -0,0 +1,167 @@
+/**
+ * montgomery.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gmp.h>
+
+#include "big_int.h"
+#include "modular_int.h"
+#include "prime_field.h"
+
+namespace ecc {
+    // The Montgomery arithmetic kernel for an odd modulus p of n limbs, with R = 2^{n * GMP_NUMB_BITS}.
+    // An element a is represented by aR (mod p), fully reduced into exactly n limbs, so that multiplication
+    // is an mpn product followed by a REDC instead of a multi-precision division.
+    // All limb arrays passed to the kernel must hold exactly limbs() limbs unless otherwise stated.
+    class Montgomery final {
+    public:
+        // If the modulus is even or less than 3, std::domain_error is thrown.
+        explicit Montgomery(const BigInt&);
+
+        [[nodiscard]] inline std::size_t limbs() const noexcept {
+            return _n;
+        }
+
+        [[nodiscard]] inline const mp_limb_t *modulus() const noexcept {
+            return _p.data();
+        }
+
+        // R (mod p), i.e. the representation of 1.
+        [[nodiscard]] inline const mp_limb_t *one() const noexcept {
+            return _one.data();
+        }
+
+        // Reduce the 2n limbs of tp, which must be less than pR, into rp: rp = tp * R^{-1} (mod p).
+        // The contents of tp are destroyed.
+        void redc(mp_limb_t *rp, mp_limb_t *tp) const noexcept;
+
+        void add(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept;
+        void sub(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept;
+        void neg(mp_limb_t *rp, const mp_limb_t *ap) const noexcept;
+        void mul(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept;
+        void sqr(mp_limb_t *rp, const mp_limb_t *ap) const noexcept;
+
+        // rp = ap^e (mod p), where e is non-negative.
+        void pow(mp_limb_t *rp, const mp_limb_t *ap, const BigInt&) const;
+
+        // rp = ap^{-1} (mod p). Returns false and leaves rp untouched if ap is not invertible.
+        bool invert(mp_limb_t *rp, const mp_limb_t *ap) const;
+
+        // Conversion in: a must be in [0, p).
+        void to_montgomery(mp_limb_t *rp, const BigInt&) const;
+
+        // Conversion out.
+        [[nodiscard]] BigInt from_montgomery(const mp_limb_t *ap) const;
+
+        [[nodiscard]] bool is_zero(const mp_limb_t *ap) const noexcept;
+
+        // Constant-time counterparts of the above, for secret values: their running time and memory accesses depend
+        // only on the number of limbs. Products use mpn_sec_mul and mpn_sec_sqr, and the final corrections are masked
+        // with mpn_cnd_add_n, mpn_cnd_sub_n, and mpn_cnd_swap rather than branched on. The products write their
+        // intermediate results into sec_itch() limbs of scratch from the caller, so that a run of them allocates
+        // nothing.
+        [[nodiscard]] inline std::size_t sec_itch() const noexcept {
+            return _sec_itch;
+        }
+
+        void sec_redc(mp_limb_t *rp, mp_limb_t *tp) const noexcept;
+        void sec_add(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept;
+        void sec_sub(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp) const noexcept;
+        void sec_mul(mp_limb_t *rp, const mp_limb_t *ap, const mp_limb_t *bp, mp_limb_t *scratch) const noexcept;
+        void sec_sqr(mp_limb_t *rp, const mp_limb_t *ap, mp_limb_t *scratch) const noexcept;
+
+        // Conversion in and out between a in [0, p) and aR (mod p), both held in exactly limbs() limbs.
+        void sec_to_montgomery(mp_limb_t *rp, const mp_limb_t *ap, mp_limb_t *scratch) const noexcept;
+        void sec_from_montgomery(mp_limb_t *rp, const mp_limb_t *ap) const noexcept;
+
+    private:
+        std::size_t _n;
+        // -p^{-1} (mod 2^GMP_NUMB_BITS).
+        mp_limb_t _p_inv;
+        std::vector<mp_limb_t> _p;
+        std::vector<mp_limb_t> _one;
+        std::vector<mp_limb_t> _r2;
+        std::vector<mp_limb_t> _r3;
+
+        // The scratch space that sec_mul and sec_sqr need: the product, and then what mpn_sec_mul and mpn_sec_sqr
+        // need.
+        std::size_t _sec_itch;
+    };
+
+    // An element of a field in Montgomery form.
+    // This is an opt-in alternative to ModularInt for multiplication-heavy code: convert in once, do the
+    // arithmetic here, and convert out when the result is needed. Requires an odd modulus.
+    class MontgomeryInt {
+    public:
+        MontgomeryInt() = delete;
+        MontgomeryInt(const MontgomeryInt&) = default;
+        MontgomeryInt(MontgomeryInt&&) noexcept = default;
+        explicit MontgomeryInt(const ModularInt&);
+        MontgomeryInt(const BigInt&, std::shared_ptr<const PrimeField>);
+        ~MontgomeryInt() = default;
+
+        MontgomeryInt &operator=(const MontgomeryInt&) = default;
+        MontgomeryInt &operator=(MontgomeryInt&&) noexcept = default;
+
+        [[nodiscard]] MontgomeryInt operator-() const;
+        [[nodiscard]] MontgomeryInt operator+(const MontgomeryInt&) const;
+        [[nodiscard]] MontgomeryInt operator-(const MontgomeryInt&) const;
+        [[nodiscard]] MontgomeryInt operator*(const MontgomeryInt&) const;
+        [[nodiscard]] MontgomeryInt pow(const BigInt&) const;
+        [[nodiscard]] MontgomeryInt pow(long) const;
+
+        MontgomeryInt &operator+=(const MontgomeryInt&);
+        MontgomeryInt &operator-=(const MontgomeryInt&);
+        MontgomeryInt &operator*=(const MontgomeryInt&);
+
+        [[nodiscard]] bool operator==(const MontgomeryInt&) const;
+
+        // Conversion out of Montgomery form.
+        [[nodiscard]] BigInt get_value() const;
+        [[nodiscard]] ModularInt to_modular_int() const;
+
+        [[nodiscard]] inline const BigInt &get_mod() const {
+            return _field->modulus();
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<const PrimeField> &get_field() const noexcept {
+            return _field;
+        }
+
+        [[nodiscard]] bool zero() const noexcept;
+
+        [[nodiscard]] std::string to_string() const;
+
+        [[nodiscard]] ModularInt::Legendre legendre() const;
+        [[nodiscard]] bool residue() const;
+
+        // Return the square root of the number if it exists, and std::nullopt otherwise.
+        [[nodiscard]] std::optional<MontgomeryInt> sqrt() const;
+
+        // Find the multiplicative inverse of this element if it exists.
+        [[nodiscard]] std::optional<MontgomeryInt> invert() const;
+
+    private:
+        std::vector<mp_limb_t> _limbs;
+        std::shared_ptr<const PrimeField> _field;
+
+        // An uninitialized element of the field.
+        explicit MontgomeryInt(std::shared_ptr<const PrimeField>);
+
+        [[nodiscard]] inline const Montgomery &engine() const {
+            return _field->montgomery();
+        }
+
+        // Check to see if the fields are the same: if not, throw a domain_exception.
+        void check_same_field(const MontgomeryInt&) const;
+    };
+}
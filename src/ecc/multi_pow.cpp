@@ -0,0 +1,171 @@
+/**
+ * multi_pow.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/modular_int_formatter.h"
+#include "montgomery.h"
+#include "multi_pow.h"
+
+namespace ecc {
+    // The widths considered by the cost model.
+    static constexpr unsigned min_straus_width = 1;
+    static constexpr unsigned max_straus_width = 8;
+
+    // The relative cost of a Montgomery squaring, in units of a Montgomery multiplication, as measured with
+    // bench_fixed_base_pow: about 0.9 for P-256, and 0.7 at 2048 bits.
+    static constexpr double squaring_cost = 0.8;
+
+    // Check the inputs to a multi-exponentiation, and return the field they are over.
+    static const std::shared_ptr<const PrimeField> &check_inputs(std::span<const ModularInt> bases,
+                                                                  std::span<const BigInt> exponents) {
+        if (bases.size() != exponents.size())
+            throw std::domain_error(fmt::format("multi_pow given {} bases and {} exponents.",
+                                                bases.size(), exponents.size()));
+        if (bases.empty())
+            throw std::domain_error("multi_pow requires at least one term.");
+
+        const auto &field = bases.front().get_field();
+        for (const auto &b: bases)
+            if (b.get_field() != field)
+                throw std::domain_error(fmt::format("multi_pow attempted with incompatible ModularInts: {} and {}.",
+                                                    bases.front(), b));
+        return field;
+    }
+
+    // The largest number of bits in the absolute value of any of the exponents.
+    static std::size_t max_bits(std::span<const BigInt> exponents) noexcept {
+        std::size_t bits = 0;
+        for (const auto &e: exponents)
+            if (!e.zero())
+                bits = std::max(bits, mpz_sizeinbase(static_cast<const mpz_t&>(e), 2));
+        return bits;
+    }
+
+    // The sliding window form of a non-negative e, least significant first: each nonzero digit is an odd value of at
+    // most w bits, and it is followed by at least w - 1 zeros.
+    static std::vector<std::uint8_t> sliding_windows(const BigInt &e, unsigned width) {
+        const auto &ev = static_cast<const mpz_t&>(e);
+        const auto length = mpz_sgn(ev) == 0 ? 0 : mpz_sizeinbase(ev, 2);
+        std::vector<std::uint8_t> digits(length);
+        for (std::size_t i = 0; i < length;) {
+            if (!mpz_tstbit(ev, i)) {
+                ++i;
+                continue;
+            }
+            unsigned digit = 0;
+            for (unsigned bit = 0; bit < width; ++bit)
+                digit |= static_cast<unsigned>(mpz_tstbit(ev, i + bit)) << bit;
+            digits[i] = static_cast<std::uint8_t>(digit);
+            i += width;
+        }
+        return digits;
+    }
+
+    ModularInt multi_pow(std::span<const ModularInt> bases, std::span<const BigInt> exponents) {
+        const auto &field = check_inputs(bases, exponents);
+        if (!field->modulus().check_bit(0)) {
+            auto result = bases.front().pow(exponents.front());
+            for (std::size_t i = 1; i < bases.size(); ++i)
+                result *= bases[i].pow(exponents[i]);
+            return result;
+        }
+        return multi_exp::straus(bases, exponents, multi_exp::straus_width(bases.size(), max_bits(exponents)));
+    }
+
+    namespace multi_exp {
+        ModularInt straus(std::span<const ModularInt> bases, std::span<const BigInt> exponents, unsigned width) {
+            const auto &field = check_inputs(bases, exponents);
+            if (width < min_straus_width || width > max_straus_width)
+                throw std::domain_error(fmt::format("Straus width must be between {} and {}: {}",
+                                                    min_straus_width, max_straus_width, width));
+            const auto &engine = field->montgomery();
+            const auto n = engine.limbs();
+            const std::size_t table_size = std::size_t{1} << (width - 1);
+
+            // The sliding windows of each exponent, and the odd powers of each base, with the table for the i-th
+            // term starting at i * table_size * n limbs. A negative exponent is taken as a power of the inverse.
+            std::vector<std::vector<std::uint8_t>> digits;
+            std::vector<mp_limb_t> tables;
+            std::vector<mp_limb_t> square(n);
+            digits.reserve(bases.size());
+            tables.reserve(bases.size() * table_size * n);
+            std::size_t length = 0;
+            for (std::size_t i = 0; i < bases.size(); ++i) {
+                if (exponents[i].zero())
+                    continue;
+                const bool negative = exponents[i] < 0;
+                digits.emplace_back(sliding_windows(negative ? -exponents[i] : exponents[i], width));
+                length = std::max(length, digits.back().size());
+
+                auto base = bases[i];
+                if (negative) {
+                    const auto inverse = base.invert();
+                    if (!inverse.has_value())
+                        throw std::domain_error(fmt::format("ModularInt has no inverse: {}", base));
+                    base = *inverse;
+                }
+
+                const auto offset = tables.size();
+                tables.resize(offset + table_size * n);
+                auto entry = tables.data() + offset;
+                engine.to_montgomery(entry, base.get_value());
+                if (table_size > 1) {
+                    engine.sqr(square.data(), entry);
+                    for (std::size_t j = 1; j < table_size; ++j, entry += n)
+                        engine.mul(entry + n, entry, square.data());
+                }
+            }
+
+            // The first nonzero digit is copied rather than multiplied into 1, which also skips the squarings of 1.
+            std::vector<mp_limb_t> result(n);
+            bool started = false;
+            for (auto idx = length; idx-- > 0;) {
+                if (started)
+                    engine.sqr(result.data(), result.data());
+                for (std::size_t i = 0; i < digits.size(); ++i) {
+                    if (idx >= digits[i].size() || digits[i][idx] == 0)
+                        continue;
+                    const auto entry = tables.data() + (i * table_size + digits[i][idx] / 2) * n;
+                    if (started)
+                        engine.mul(result.data(), result.data(), entry);
+                    else
+                        mpn_copyi(result.data(), entry, static_cast<mp_size_t>(n));
+                    started = true;
+                }
+            }
+
+            if (!started)
+                return ModularInt{1, field};
+            return ModularInt{engine.from_montgomery(result.data()), field};
+        }
+
+        double straus_cost(std::size_t n, std::size_t bits, unsigned width) noexcept {
+            // One shared squaring per bit, and for each base, a table of 2^(w-1) odd powers built with a squaring and
+            // multiplications, and a multiplication for the nonzero digit every w + 1 bits on average.
+            const auto table = static_cast<double>(std::size_t{1} << (width - 1));
+            return squaring_cost * static_cast<double>(bits)
+                + static_cast<double>(n) * (squaring_cost + table - 1 + static_cast<double>(bits) / (width + 1));
+        }
+
+        unsigned straus_width(std::size_t n, std::size_t bits) noexcept {
+            auto best = min_straus_width;
+            for (auto width = min_straus_width + 1; width <= max_straus_width; ++width)
+                if (straus_cost(n, bits, width) < straus_cost(n, bits, best))
+                    best = width;
+            return best;
+        }
+    }
+}
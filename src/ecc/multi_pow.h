@@ -0,0 +1,34 @@
+/**
+ * multi_pow.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "big_int.h"
+#include "modular_int.h"
+
+namespace ecc {
+    // The product of b_i^e_i over the bases b_i and exponents e_i, which must all be over the same field.
+    // This is Straus's method, the multiplicative side of msm::straus: the sliding windows of all the exponents are
+    // interleaved so that the squarings are shared, with a table of odd powers of each base, in Montgomery form.
+    // A negative exponent raises the inverse of its base, and if that does not exist, std::domain_error is thrown.
+    // Over an even modulus, the powers are computed separately. If the spans differ in size or are empty, or the bases
+    // are over different fields, std::domain_error is thrown.
+    [[nodiscard]] ModularInt multi_pow(std::span<const ModularInt> bases, std::span<const BigInt> exponents);
+
+    // The individual pieces of multi_pow, for callers that want to pick their own width.
+    namespace multi_exp {
+        // Straus's method with sliding windows of the given width, in [1, 8]. The table for each base holds its odd
+        // powers b, b^3, ..., b^(2^w - 1). If the modulus is even, std::domain_error is thrown.
+        [[nodiscard]] ModularInt straus(std::span<const ModularInt> bases, std::span<const BigInt> exponents,
+                                        unsigned width);
+
+        // The estimated cost of Straus's method in units of a multiplication, and the width minimizing it.
+        [[nodiscard]] double straus_cost(std::size_t n, std::size_t bits, unsigned width) noexcept;
+        [[nodiscard]] unsigned straus_width(std::size_t n, std::size_t bits) noexcept;
+    }
+}
@@ -0,0 +1,259 @@
+/**
+ * multi_scalar_mul.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "multi_scalar_mul.h"
+
+namespace ecc {
+    // The widths considered by the cost model.
+    static constexpr unsigned min_straus_width = 2;
+    static constexpr unsigned max_straus_width = 8;
+    static constexpr unsigned min_pippenger_window = 1;
+    static constexpr unsigned max_pippenger_window = 20;
+
+    // Below this many terms per chunk, splitting an MSM across threads loses more to the smaller Pippenger windows
+    // than it gains.
+    static constexpr std::size_t min_chunk_size = 256;
+
+    // The relative costs of a doubling and of a full Jacobian addition, in units of a mixed addition, as measured with
+    // bench_multi_scalar_mul on secp256k1 and P-256.
+    static constexpr double doubling_cost = 0.8;
+    static constexpr double addition_cost = 1.4;
+
+    // Check the inputs to a multi-scalar multiplication, and return the curve they are on.
+    static const std::shared_ptr<const EllipticCurve> &check_inputs(std::span<const BigInt> scalars,
+                                                                     std::span<const Point> points) {
+        if (scalars.size() != points.size())
+            throw std::domain_error(fmt::format("multi_scalar_mul given {} scalars and {} points.",
+                                                scalars.size(), points.size()));
+        if (points.empty())
+            throw std::domain_error("multi_scalar_mul requires at least one term.");
+
+        const auto &curve = points.front().curve();
+        for (const auto &p: points)
+            if (p.curve() != curve && !(*p.curve() == *curve))
+                throw std::domain_error("multi_scalar_mul attempted with points on different curves.");
+        return curve;
+    }
+
+    // The largest number of bits in the absolute value of any of the scalars.
+    static std::size_t max_bits(std::span<const BigInt> scalars) noexcept {
+        std::size_t bits = 0;
+        for (const auto &k: scalars)
+            if (!k.zero())
+                bits = std::max(bits, mpz_sizeinbase(static_cast<const mpz_t&>(k), 2));
+        return bits;
+    }
+
+    // The sum using whichever method the cost model prefers, for inputs that have already been checked.
+    static JacobianPoint cheapest_sum(std::span<const BigInt> scalars, std::span<const Point> points) {
+        const auto n = points.size();
+        const auto bits = max_bits(scalars);
+
+        const auto width = msm::straus_width(n, bits);
+        const auto window = msm::pippenger_window(n, bits);
+        if (msm::straus_cost(n, bits, width) <= msm::pippenger_cost(n, bits, window))
+            return msm::straus(scalars, points, width);
+        return msm::pippenger(scalars, points, window);
+    }
+
+    Point multi_scalar_mul(std::span<const BigInt> scalars, std::span<const Point> points) {
+        check_inputs(scalars, points);
+        return cheapest_sum(scalars, points).to_affine();
+    }
+
+    Point multi_scalar_mul_parallel(std::span<const BigInt> scalars, std::span<const Point> points, ThreadPool &pool) {
+        const auto &curve = check_inputs(scalars, points);
+
+        std::mutex result_mutex;
+        auto result = JacobianPoint::infinity(curve);
+        pool.parallel_for(points.size(), min_chunk_size, [&](std::size_t begin, std::size_t end) {
+            const auto sum = cheapest_sum(scalars.subspan(begin, end - begin), points.subspan(begin, end - begin));
+            std::lock_guard lock{result_mutex};
+            result += sum;
+        });
+        return result.to_affine();
+    }
+
+    namespace msm {
+        JacobianPoint straus(std::span<const BigInt> scalars, std::span<const Point> points, unsigned width) {
+            const auto &curve = check_inputs(scalars, points);
+            if (width < min_straus_width || width > max_straus_width)
+                throw std::domain_error(fmt::format("Straus width must be between {} and {}: {}",
+                                                    min_straus_width, max_straus_width, width));
+            const std::size_t table_size = std::size_t{1} << (width - 2);
+
+            // The wNAF of each scalar, and the odd multiples P, 3P, ..., (2^(w-1) - 1)P of each point, with the
+            // table for the i-th term starting at i * table_size. The tables are normalized to affine together,
+            // so that the additions in the main loop are mixed.
+            std::vector<std::vector<std::int8_t>> digits;
+            std::vector<JacobianPoint> jacobian_tables;
+            digits.reserve(points.size());
+            jacobian_tables.reserve(points.size() * table_size);
+            std::size_t length = 0;
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                if (points[i].is_infinity() || scalars[i].zero())
+                    continue;
+                digits.emplace_back(scalars[i].wnaf(width));
+                length = std::max(length, digits.back().size());
+
+                jacobian_tables.emplace_back(points[i]);
+                if (table_size > 1) {
+                    const auto twice = jacobian_tables.back().doubled();
+                    for (std::size_t j = 1; j < table_size; ++j)
+                        jacobian_tables.push_back(jacobian_tables.back() + twice);
+                }
+            }
+            const auto tables = JacobianPoint::to_affine(jacobian_tables);
+
+            auto result = JacobianPoint::infinity(curve);
+            for (auto idx = length; idx-- > 0;) {
+                result = result.doubled();
+                for (std::size_t i = 0; i < digits.size(); ++i) {
+                    if (idx >= digits[i].size())
+                        continue;
+                    if (const auto digit = digits[i][idx]; digit > 0)
+                        result += tables[i * table_size + (digit >> 1)];
+                    else if (digit < 0)
+                        result -= tables[i * table_size + (-digit >> 1)];
+                }
+            }
+            return result;
+        }
+
+        JacobianPoint shamir(const BigInt &k0, const Point &p, const BigInt &k1, const Point &q) {
+            const auto &curve = p.curve();
+            if (!(*curve == *q.curve()))
+                throw std::domain_error("Shamir's trick attempted with points on different curves.");
+
+            // table[0] = P + Q and table[1] = P - Q, normalized together.
+            const JacobianPoint jp{p};
+            const JacobianPoint sums[] = {jp + q, jp - q};
+            const auto table = JacobianPoint::to_affine(sums);
+
+            const auto digits = BigInt::joint_sparse_form(k0, k1);
+            auto result = JacobianPoint::infinity(curve);
+            for (auto idx = digits.size(); idx-- > 0;) {
+                result = result.doubled();
+                const auto [u0, u1] = digits[idx];
+                if (u0 == 0 && u1 == 0)
+                    continue;
+
+                // Add u0 P + u1 Q, which is ±P, ±Q, ±(P + Q), or ±(P - Q).
+                const Point &term = u0 == 0 ? q : u1 == 0 ? p : u0 == u1 ? table[0] : table[1];
+                if (u0 > 0 || (u0 == 0 && u1 > 0))
+                    result += term;
+                else
+                    result -= term;
+            }
+            return result;
+        }
+
+        JacobianPoint pippenger(std::span<const BigInt> scalars, std::span<const Point> points, unsigned window) {
+            const auto &curve = check_inputs(scalars, points);
+            if (window < min_pippenger_window || window > max_pippenger_window)
+                throw std::domain_error(fmt::format("Pippenger window must be between {} and {}: {}",
+                                                    min_pippenger_window, max_pippenger_window, window));
+
+            const auto n = points.size();
+            const auto bits = max_bits(scalars);
+            const long modulus = 1L << window;
+            const long half = modulus >> 1;
+
+            // Recode each |k_i| into signed digits in [-2^(c-1), 2^(c-1)], which can carry into one more bit.
+            // The sign of k_i is folded into the digits, so that negative scalars need no special treatment.
+            const std::size_t windows = (bits + window) / window;
+            std::vector<std::int32_t> digits(n * windows);
+            mpz_t kv;
+            mpz_init(kv);
+            for (std::size_t i = 0; i < n; ++i) {
+                // mpz_tstbit works on the two's complement of negative numbers, so take the absolute value.
+                mpz_abs(kv, static_cast<const mpz_t&>(scalars[i]));
+                const long sign = mpz_sgn(static_cast<const mpz_t&>(scalars[i])) < 0 ? -1 : 1;
+                long carry = 0;
+                for (std::size_t w = 0; w < windows; ++w) {
+                    long digit = carry;
+                    for (unsigned bit = 0; bit < window; ++bit)
+                        digit += static_cast<long>(mpz_tstbit(kv, w * window + bit)) << bit;
+                    carry = digit > half ? 1 : 0;
+                    digit -= carry * modulus;
+                    digits[i * windows + w] = static_cast<std::int32_t>(sign * digit);
+                }
+            }
+            mpz_clear(kv);
+
+            // Bucket j collects the points whose digit is j + 1 in the current window.
+            const auto infinity = JacobianPoint::infinity(curve);
+            std::vector<JacobianPoint> buckets(static_cast<std::size_t>(half), infinity);
+            auto result = infinity;
+            for (auto w = windows; w-- > 0;) {
+                for (unsigned d = 0; d < window; ++d)
+                    result = result.doubled();
+
+                std::fill(buckets.begin(), buckets.end(), infinity);
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (const auto digit = digits[i * windows + w]; digit > 0)
+                        buckets[digit - 1] += points[i];
+                    else if (digit < 0)
+                        buckets[-digit - 1] -= points[i];
+                }
+
+                // The sum of (j + 1) buckets[j], as the sum of the running sums from the top bucket down.
+                auto running = infinity;
+                auto total = infinity;
+                for (auto j = buckets.size(); j-- > 0;) {
+                    running += buckets[j];
+                    total += running;
+                }
+                result += total;
+            }
+            return result;
+        }
+
+        double straus_cost(std::size_t n, std::size_t bits, unsigned width) noexcept {
+            // One shared doubling per bit, and for each point, a table of 2^(w-2) points built with full additions,
+            // and a mixed addition for the nonzero digit every w + 1 bits on average.
+            const auto table = static_cast<double>(std::size_t{1} << (width - 2));
+            return doubling_cost * static_cast<double>(bits)
+                + static_cast<double>(n) * (addition_cost * table + static_cast<double>(bits) / (width + 1));
+        }
+
+        double pippenger_cost(std::size_t n, std::size_t bits, unsigned window) noexcept {
+            // One doubling per bit, and for each window, a mixed addition per point and two full additions per bucket.
+            const auto windows = static_cast<double>((bits + window) / window);
+            const auto buckets = static_cast<double>(std::size_t{1} << (window - 1));
+            return doubling_cost * static_cast<double>(bits)
+                + windows * (static_cast<double>(n) + 2 * addition_cost * buckets);
+        }
+
+        unsigned straus_width(std::size_t n, std::size_t bits) noexcept {
+            auto best = min_straus_width;
+            for (auto width = min_straus_width + 1; width <= max_straus_width; ++width)
+                if (straus_cost(n, bits, width) < straus_cost(n, bits, best))
+                    best = width;
+            return best;
+        }
+
+        unsigned pippenger_window(std::size_t n, std::size_t bits) noexcept {
+            auto best = min_pippenger_window;
+            for (auto window = min_pippenger_window + 1; window <= max_pippenger_window; ++window)
+                if (pippenger_cost(n, bits, window) < pippenger_cost(n, bits, best))
+                    best = window;
+            return best;
+        }
+    }
+}
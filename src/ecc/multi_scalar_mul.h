@@ -0,0 +1,51 @@
+/**
+ * multi_scalar_mul.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "big_int.h"
+#include "jacobian_point.h"
+#include "point.h"
+#include "thread_pool.h"
+
+namespace ecc {
+    // The sum of k_i P_i over the scalars k_i and points P_i, which must all be on the same curve.
+    // This picks between Straus's and Pippenger's methods, and their window sizes, based on the number of
+    // terms and the size of the scalars.
+    // If the spans differ in size or are empty, or the points are on different curves, std::domain_error is thrown.
+    [[nodiscard]] Point multi_scalar_mul(std::span<const BigInt> scalars, std::span<const Point> points);
+
+    // As above, but with the terms split into chunks whose sums are computed concurrently on the pool and then
+    // added together. Small inputs are not split.
+    [[nodiscard]] Point multi_scalar_mul_parallel(std::span<const BigInt> scalars, std::span<const Point> points,
+                                                  ThreadPool &pool = ThreadPool::global());
+
+    // The individual algorithms behind multi_scalar_mul, for callers that want to pick their own.
+    namespace msm {
+        // Straus's method: interleave the wNAFs of all the scalars, so that the doublings are shared, with a table
+        // of odd multiples of each point. Best for a small number of terms.
+        [[nodiscard]] JacobianPoint straus(std::span<const BigInt> scalars, std::span<const Point> points,
+                                           unsigned width);
+
+        // Shamir's trick for k0 P + k1 Q, using the joint sparse form of (k0, k1): one pass of doublings, with a
+        // mixed addition of one of ±P, ±Q, ±(P + Q), ±(P - Q) for about half of the bits.
+        // If the points are on different curves, std::domain_error is thrown.
+        [[nodiscard]] JacobianPoint shamir(const BigInt &k0, const Point &p, const BigInt &k1, const Point &q);
+
+        // Pippenger's bucket method: for each window of c bits, add every point into the bucket for its signed
+        // digit, and then combine the buckets with running sums. Best for a large number of terms.
+        [[nodiscard]] JacobianPoint pippenger(std::span<const BigInt> scalars, std::span<const Point> points,
+                                              unsigned window);
+
+        // The estimated cost of each method in units of a mixed addition, and the width minimizing it.
+        [[nodiscard]] double straus_cost(std::size_t n, std::size_t bits, unsigned width) noexcept;
+        [[nodiscard]] double pippenger_cost(std::size_t n, std::size_t bits, unsigned window) noexcept;
+        [[nodiscard]] unsigned straus_width(std::size_t n, std::size_t bits) noexcept;
+        [[nodiscard]] unsigned pippenger_window(std::size_t n, std::size_t bits) noexcept;
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * named_curves.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <memory>
+
+#include "big_int.h"
+#include "elliptic_curve.h"
+#include "gmp_allocator.h"
+#include "named_curves.h"
+
+namespace ecc::curves {
+    // The curves are made on first use, which may be in an ArenaScope, so the arena is suspended for them.
+    const std::shared_ptr<const EllipticCurve> &secp256k1() {
+        const ArenaSuspension suspension;
+        static const auto curve = EllipticCurve::create(
+                BigInt{0},
+                BigInt{7},
+                BigInt{"115792089237316195423570985008687907853269984665640564039457584007908834671663"},
+                BigInt{"55066263022277343669578718895168534326250603453777594175500187360389116729240"},
+                BigInt{"32670510020758816978083085130507043184471273380659243275938904335757337482424"},
+                BigInt{"115792089237316195423570985008687907852837564279074904382605163141518161494337"},
+                BigInt{1});
+        return curve;
+    }
+
+    const std::shared_ptr<const EllipticCurve> &p256() {
+        const ArenaSuspension suspension;
+        static const auto curve = EllipticCurve::create(
+                BigInt{-3},
+                BigInt{"41058363725152142129326129780047268409114441015993725554835256314039467401291"},
+                BigInt{"115792089210356248762697446949407573530086143415290314195533631308867097853951"},
+                BigInt{"48439561293906451759052585252797914202762949526041747995844080717082404635286"},
+                BigInt{"36134250956749795798585127919587881956611106672985015071877198253568414405109"},
+                BigInt{"115792089210356248762697446949407573529996955224135760342422259061068512044369"},
+                BigInt{1});
+        return curve;
+    }
+}
@@ -0,0 +1,20 @@
+/**
+ * named_curves.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "elliptic_curve.h"
+
+// Standard curves, with their generators, group orders, and cofactors.
+// Each is created on first use and shared thereafter.
+namespace ecc::curves {
+    // secp256k1 from SEC 2: y^2 = x^3 + 7 over p = 2^256 - 2^32 - 977.
+    [[nodiscard]] const std::shared_ptr<const EllipticCurve> &secp256k1();
+
+    // NIST P-256, or secp256r1: y^2 = x^3 - 3x + b over p = 2^256 - 2^224 + 2^192 + 2^96 - 1.
+    [[nodiscard]] const std::shared_ptr<const EllipticCurve> &p256();
+}
@@ -3,18 +3,241 @@
  * By Sebastian Raaphorst, 2023.
  */
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <fmt/core.h>
 #include <fmt/format.h>
 
+#include "formatters/modular_int_formatter.h"
+#include "expression.h"
+#include "jacobian_point.h"
 #include "point.h"
+#include "prime_field.h"
 
 namespace ecc {
-    Point::Point(ecc::ModularInt x, ecc::ModularInt y): _x{std::move(x)}, _y{std::move(y)} {
+    using expr::lazy;
+
+    // The inverse of a non-zero element of the curve's field, which must exist as the modulus is prime.
+    static ModularInt field_inverse(const ModularInt &m) {
+        auto inv = m.invert();
+        if (!inv.has_value())
+            throw std::domain_error(fmt::format("Unexpected error: {} has no inverse.", m));
+        return std::move(*inv);
+    }
+
+    // The SEC 1 leading bytes.
+    static constexpr std::uint8_t infinity_tag = 0x00;
+    static constexpr std::uint8_t even_tag = 0x02;
+    static constexpr std::uint8_t odd_tag = 0x03;
+    static constexpr std::uint8_t uncompressed_tag = 0x04;
+
+    Point::Point(std::shared_ptr<const EllipticCurve> curve, ModularInt x, ModularInt y):
+        _curve{std::move(curve)}, _x{std::move(x)}, _y{std::move(y)}, _infinity{false} {
+        check_same_mod(_x, _y);
+        if (!_curve->contains(_x, _y))
+            throw std::domain_error(fmt::format("Point ({},{}) is not on the curve {}.", _x, _y, _curve->to_string()));
+    }
+
+    Point::Point(std::shared_ptr<const EllipticCurve> curve, ModularInt x, ModularInt y, bool infinity):
+        _curve{std::move(curve)}, _x{std::move(x)}, _y{std::move(y)}, _infinity{infinity} {}
+
+    Point Point::infinity(std::shared_ptr<const EllipticCurve> curve) {
+        const auto &field = curve->get_field();
+        return Point{curve, ModularInt{0, field}, ModularInt{1, field}, true};
+    }
+
+    const ModularInt &Point::x() const {
+        if (_infinity)
+            throw std::domain_error("The point at infinity has no affine coordinates.");
+        return _x;
+    }
+
+    const ModularInt &Point::y() const {
+        if (_infinity)
+            throw std::domain_error("The point at infinity has no affine coordinates.");
+        return _y;
+    }
+
+    bool Point::on_curve() const {
+        return _infinity || _curve->contains(_x, _y);
+    }
+
+    Point Point::operator-() const {
+        if (_infinity)
+            return *this;
+        return Point{_curve, _x, -_y, false};
+    }
+
+    Point Point::operator+(const Point &other) const {
+        check_same_curve(other);
+        if (_infinity)
+            return other;
+        if (other._infinity)
+            return *this;
+
+        // P + P is a doubling, and P + (-P) is the point at infinity.
+        if (_x == other._x) {
+            if (_y == other._y)
+                return doubled();
+            return Point::infinity(_curve);
+        }
+
+        // The slope of the line through the two points. Each coordinate is evaluated as one expression.
+        const ModularInt lambda = (lazy(other._y) - _y) * field_inverse(other._x - _x);
+        ModularInt x3 = lazy(lambda) * lambda - _x - other._x;
+        ModularInt y3 = lazy(lambda) * (lazy(_x) - x3) - _y;
+        return Point{_curve, std::move(x3), std::move(y3), false};
+    }
+
+    Point Point::operator-(const Point &other) const {
+        return *this + -other;
+    }
+
+    Point Point::doubled() const {
+        // Points with y = 0 have order 2.
+        if (_infinity || _y.get_value().zero())
+            return Point::infinity(_curve);
+
+        // The slope of the tangent line, (3x^2 + a) / 2y.
+        const ModularInt lambda = (lazy(_x) * _x * 3 + _curve->a()) * field_inverse(_y + _y);
+        ModularInt x3 = lazy(lambda) * lambda - lazy(_x) * 2;
+        ModularInt y3 = lazy(lambda) * (lazy(_x) - x3) - _y;
+        return Point{_curve, std::move(x3), std::move(y3), false};
+    }
 
+    Point &Point::operator+=(const Point &other) {
+        return *this = *this + other;
     }
 
-    void Point::check_same_mod(const ecc::ModularInt &x, const ecc::ModularInt &y) {
-        if (x.get_mod() != y.get_mod())
+    Point &Point::operator-=(const Point &other) {
+        return *this = *this - other;
+    }
+
+    Point Point::operator*(const BigInt &k) const {
+        return (JacobianPoint{*this} * k).to_affine();
+    }
+
+    bool Point::operator==(const Point &other) const {
+        check_same_curve(other);
+        if (_infinity || other._infinity)
+            return _infinity == other._infinity;
+        return _x == other._x && _y == other._y;
+    }
+
+    std::string Point::to_string() const {
+        if (_infinity)
+            return "O";
+        return fmt::format("({},{})", _x, _y);
+    }
+
+    std::vector<std::uint8_t> Point::encode(bool compressed) const {
+        std::vector<std::uint8_t> bytes(_infinity ? 1 : encoded_size(_curve->get_field()->bits(), compressed));
+        (void)encode(bytes, compressed);
+        return bytes;
+    }
+
+    std::size_t Point::encode(std::span<std::uint8_t> out, bool compressed) const {
+        const auto length = _infinity ? 1 : encoded_size(_curve->get_field()->bits(), compressed);
+        if (out.size() < length)
+            throw std::domain_error(fmt::format("SEC 1 encoding of {} needs {} bytes, but only {} are available.",
+                                                to_string(), length, out.size()));
+        if (_infinity) {
+            out.front() = infinity_tag;
+            return length;
+        }
+
+        const auto size = _curve->get_field()->bytes();
+        _x.to_bytes(out.subspan(1, size));
+        if (compressed) {
+            out.front() = _y.get_value().check_bit(0) ? odd_tag : even_tag;
+        } else {
+            out.front() = uncompressed_tag;
+            _y.to_bytes(out.subspan(1 + size, size));
+        }
+        return length;
+    }
+
+    std::size_t Point::encoded_size(std::size_t field_bits, bool compressed) noexcept {
+        const auto size = (field_bits + 7) / 8;
+        return compressed ? 1 + size : 1 + 2 * size;
+    }
+
+    Point Point::decode(const std::shared_ptr<const EllipticCurve> &curve, std::span<const std::uint8_t> bytes) {
+        if (bytes.empty())
+            throw std::domain_error("Empty SEC 1 point encoding.");
+
+        const auto tag = bytes.front();
+        const auto &field = curve->get_field();
+        const auto size = field->bytes();
+        if (tag == infinity_tag && bytes.size() == 1)
+            return infinity(curve);
+        if ((tag == even_tag || tag == odd_tag) && bytes.size() == 1 + size)
+            return decompress(curve, ModularInt::from_bytes(bytes.subspan(1, size), field), tag == odd_tag);
+        if (tag == uncompressed_tag && bytes.size() == 1 + 2 * size)
+            return Point{curve, ModularInt::from_bytes(bytes.subspan(1, size), field),
+                         ModularInt::from_bytes(bytes.subspan(1 + size, size), field)};
+        throw std::domain_error(fmt::format("Malformed SEC 1 point encoding: tag {:#04x}, {} bytes.",
+                                            tag, bytes.size()));
+    }
+
+    std::vector<Point> Point::decompress_batch(const std::shared_ptr<const EllipticCurve> &curve,
+                                               std::span<const std::uint8_t> bytes, ThreadPool &pool) {
+        const auto size = encoded_size(curve->get_field()->bits());
+        if (bytes.size() % size != 0)
+            throw std::domain_error(fmt::format("SEC 1 batch of {} bytes is not a whole number of {}-byte encodings.",
+                                                bytes.size(), size));
+        const auto count = bytes.size() / size;
+
+        // Point has no default, so the slots start out at infinity, and are all overwritten.
+        std::vector<Point> points(count, infinity(curve));
+        pool.parallel_for(count, 64, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                const auto encoding = bytes.subspan(i * size, size);
+                if (encoding.front() != even_tag && encoding.front() != odd_tag)
+                    throw std::domain_error(fmt::format("SEC 1 batch entry {} is not a compressed point.", i));
+                points[i] = decompress(curve, ModularInt::from_bytes(encoding.subspan(1), curve->get_field()),
+                                       encoding.front() == odd_tag);
+            }
+        });
+        return points;
+    }
+
+    Point Point::decompress(const std::shared_ptr<const EllipticCurve> &curve, ModularInt x, bool odd_y) {
+        // y^2 = 0 has the single root y = 0, which sqrt does not report, as 0 is not a quadratic residue.
+        auto rhs = curve->rhs(x);
+        if (rhs.get_value().zero()) {
+            if (odd_y)
+                throw std::domain_error("SEC 1 point encoding has y = 0 with odd parity.");
+            return Point{curve, std::move(x), std::move(rhs), false};
+        }
+
+        // sqrt checks its candidate root rather than computing a Legendre symbol first, so a non-residue costs no
+        // more than a residue.
+        auto y = rhs.sqrt();
+        if (!y.has_value())
+            throw std::domain_error("SEC 1 point encoding has an x coordinate with no point on the curve.");
+        if ((y->get_value().check_bit(0) != 0) != odd_y)
+            *y = -*y;
+
+        // y^2 = x^3 + ax + b by construction, so there is no need to check the point again.
+        return Point{curve, std::move(x), std::move(*y), false};
+    }
+
+    void Point::check_same_mod(const ModularInt &x, const ModularInt &y) {
+        if (x.get_field() != y.get_field())
+            throw std::domain_error(fmt::format("Point coordinates have incompatible moduli: {} and {}.", x, y));
+    }
 
+    void Point::check_same_curve(const Point &other) const {
+        if (!(*_curve == *other._curve))
+            throw std::domain_error(fmt::format("Computation attempted with points on different curves: {} and {}.",
+                                                to_string(), other.to_string()));
     }
-}
\ No newline at end of file
+}
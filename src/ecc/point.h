@@ -5,25 +5,112 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "elliptic_curve.h"
 #include "modular_int.h"
+#include "thread_pool.h"
 
 namespace ecc {
+    class JacobianPoint;
+
+    // A point on an elliptic curve in affine coordinates, or the point at infinity.
+    // Points form an abelian group under addition, with the point at infinity as the identity.
     class Point final {
+        friend JacobianPoint;
     public:
         Point() = delete;
-        Point(ModularInt x, ModularInt y);
+        Point(const Point&) = default;
+        Point(Point&&) noexcept = default;
+
+        // If (x, y) is not on the curve, std::domain_error is thrown.
+        Point(std::shared_ptr<const EllipticCurve>, ModularInt x, ModularInt y);
+        ~Point() = default;
 
-        [[nodiscard]] inline const ModularInt &x() const noexcept {
-            return _x;
+        Point &operator=(const Point&) = default;
+        Point &operator=(Point&&) noexcept = default;
+
+        // The point at infinity on the curve.
+        [[nodiscard]] static Point infinity(std::shared_ptr<const EllipticCurve>);
+
+        [[nodiscard]] inline bool is_infinity() const noexcept {
+            return _infinity;
         }
-        [[nodiscard]] inline const ModularInt &y() const noexcept {
-            return _y;
+
+        // The coordinates. If this is the point at infinity, std::domain_error is thrown.
+        [[nodiscard]] const ModularInt &x() const;
+        [[nodiscard]] const ModularInt &y() const;
+
+        [[nodiscard]] inline const std::shared_ptr<const EllipticCurve> &curve() const noexcept {
+            return _curve;
         }
+
+        // Determine if the point satisfies the curve equation. The point at infinity always does.
+        [[nodiscard]] bool on_curve() const;
+
+        [[nodiscard]] Point operator-() const;
+        [[nodiscard]] Point operator+(const Point&) const;
+        [[nodiscard]] Point operator-(const Point&) const;
+
+        // 2P, which is cheaper than P + P.
+        [[nodiscard]] Point doubled() const;
+
+        Point &operator+=(const Point&);
+        Point &operator-=(const Point&);
+
+        // Scalar multiplication kP. The work is done in Jacobian coordinates.
+        [[nodiscard]] Point operator*(const BigInt&) const;
+
+        [[nodiscard]] bool operator==(const Point&) const;
+
+        [[nodiscard]] std::string to_string() const;
+
+        // The SEC 1 (section 2.3.3) encoding of the point: 0x02 or 0x03 for an even or odd y followed by x if
+        // compressed, 0x04 followed by x and y if not, each coordinate big-endian and padded to the length of the
+        // field modulus, and the single byte 0x00 for the point at infinity.
+        [[nodiscard]] std::vector<std::uint8_t> encode(bool compressed = true) const;
+
+        // Write the SEC 1 encoding into the start of the buffer, returning the number of bytes written, so that
+        // many points can be encoded into one buffer without an allocation each.
+        // If the buffer is too short, std::domain_error is thrown.
+        std::size_t encode(std::span<std::uint8_t>, bool compressed = true) const;
+
+        // The length of the encoding of a point other than infinity on a curve over a field of the given number of
+        // bits.
+        [[nodiscard]] static std::size_t encoded_size(std::size_t field_bits, bool compressed = true) noexcept;
+
+        // Decode a SEC 1 encoding, compressed or not, recovering y from x for a compressed one.
+        // If the encoding is malformed, or x or y is not reduced, or the point is not on the curve,
+        // std::domain_error is thrown.
+        [[nodiscard]] static Point decode(const std::shared_ptr<const EllipticCurve>&, std::span<const std::uint8_t>);
+
+        // Decode a buffer of compressed encodings laid end to end, for loading large sets of keys, with the square
+        // roots computed concurrently on the pool. This throws as decode does, and also if the buffer is not a whole
+        // number of compressed encodings.
+        [[nodiscard]] static std::vector<Point> decompress_batch(const std::shared_ptr<const EllipticCurve>&,
+                                                                 std::span<const std::uint8_t>,
+                                                                 ThreadPool &pool = ThreadPool::global());
+
     private:
+        std::shared_ptr<const EllipticCurve> _curve;
         ModularInt _x, _y;
+        bool _infinity;
+
+        // Unchecked constructor for points known to lie on the curve.
+        Point(std::shared_ptr<const EllipticCurve>, ModularInt x, ModularInt y, bool infinity);
+
+        // The point with the given x coordinate and parity of y. If there is none, std::domain_error is thrown.
+        [[nodiscard]] static Point decompress(const std::shared_ptr<const EllipticCurve>&, ModularInt x, bool odd_y);
 
         // Check to see if the mod values are the same: if not, throw a domain_exception.
         static void check_same_mod(const ModularInt&, const ModularInt&);
+
+        // Check to see if the curves are the same: if not, throw a domain_exception.
+        void check_same_curve(const Point&) const;
     };
 }
-
@@ -0,0 +1,196 @@
+/**
+ * prime_field.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <gmp.h>
+
+#include "formatters/big_int_formatter.h"
+#include "gmp_allocator.h"
+#include "montgomery.h"
+#include "prime_field.h"
+
+namespace ecc {
+    // The upper bound on the search for a quadratic non-residue.
+    // For an odd prime p, the least non-residue is tiny (O(log^2 p) under GRH), so hitting this means that
+    // the modulus is not prime.
+    static constexpr unsigned long non_residue_search_limit = 1UL << 20;
+
+    // The number of bits of the discrete logarithm found per table lookup by the windowed Tonelli and Shanks.
+    // The tables hold e / w rows of 2^w field elements.
+    static constexpr mp_bitcnt_t sqrt_table_window = 8;
+
+    namespace {
+        // The interning table. Entries hold weak pointers so that a field is released once no ModularInt refers
+        // to it any longer. The registry is deliberately leaked so that fields held by static objects can still
+        // deregister themselves during static destruction.
+        struct Registry {
+            std::mutex mutex;
+            std::map<BigInt, std::weak_ptr<const PrimeField>> fields;
+        };
+
+        Registry &registry() {
+            static auto *instance = new Registry;
+            return *instance;
+        }
+    }
+
+    std::shared_ptr<const PrimeField> PrimeField::get(const BigInt &modulus) {
+        if (modulus.zero())
+            throw std::domain_error("Tried to create a PrimeField with modulus 0.");
+
+        // Fields are shared by everything that uses their modulus, so they must not come from a caller's arena.
+        const ArenaSuspension suspension;
+
+        // The integers modulo -m are those modulo m, and the arithmetic relies on a positive modulus.
+        const auto positive = modulus < 0 ? -modulus : modulus;
+        auto &reg = registry();
+        std::lock_guard lock{reg.mutex};
+
+        auto &entry = reg.fields[positive];
+        if (auto field = entry.lock())
+            return field;
+
+        // The constructor is private, so we cannot use std::make_shared.
+        std::shared_ptr<const PrimeField> field{new PrimeField{positive}};
+        entry = field;
+        return field;
+    }
+
+    PrimeField::PrimeField(BigInt modulus): _modulus{std::move(modulus)} {
+        _bits = mpz_sizeinbase(_modulus.value, 2);
+        _limbs = mpz_size(_modulus.value);
+
+        // The last two bits of p are 1 iff p ≡ 3 (mod 4).
+        if (_modulus.check_bit(0) && _modulus.check_bit(1))
+            _sqrt_exponent = (_modulus + 1) / 4;
+
+        // The last three bits of p are 101 iff p ≡ 5 (mod 8).
+        if (_modulus.check_bit(0) && !_modulus.check_bit(1) && _modulus.check_bit(2))
+            _atkin_exponent = (_modulus - 5) / 8;
+    }
+
+    PrimeField::~PrimeField() {
+        // Remove our entry, unless another thread has already replaced it with a live field in the window
+        // between our reference count dropping to zero and this destructor running.
+        auto &reg = registry();
+        std::lock_guard lock{reg.mutex};
+        const auto iter = reg.fields.find(_modulus);
+        if (iter != reg.fields.end() && iter->second.expired())
+            reg.fields.erase(iter);
+    }
+
+    PrimeField::Scratch &PrimeField::scratch() const {
+        static thread_local Scratch scratch;
+        // The scratch lives as long as the thread, so it must not grow into an ArenaScope that is open at the time.
+        // Once grown, its blocks come from the pools, and stay there if GMP grows them further.
+        if (scratch.product.capacity() < 2 * element_capacity() || scratch.element.capacity() < element_capacity()) {
+            const ArenaSuspension suspension;
+            scratch.product.reserve(2 * element_capacity());
+            scratch.element.reserve(element_capacity());
+        }
+        return scratch;
+    }
+
+    const PrimeField::TonelliShanks &PrimeField::tonelli_shanks() const {
+        std::call_once(_tonelli_shanks_flag, [this] {
+            const ArenaSuspension suspension;
+            const auto &p = _modulus.value;
+            if (!_modulus.check_bit(0) || mpz_cmp_ui(p, 3) < 0)
+                throw std::domain_error(fmt::format("Tonelli and Shanks requires an odd prime: {}", _modulus));
+
+            // Initialize q to p - 1 (even), find # of zeros on right in binary representation, and eliminate them.
+            auto q = _modulus - 1;
+            const auto e = mpz_scan1(q.value, 0);
+            mpz_tdiv_q_2exp(q.value, q.value, e);
+
+            // Search deterministically for the smallest non-residue.
+            mpz_t n;
+            mpz_init_set_ui(n, 2);
+            while (mpz_legendre(n, p) != -1) {
+                if (mpz_cmp_ui(n, non_residue_search_limit) >= 0 || mpz_cmp(n, p) >= 0) {
+                    mpz_clear(n);
+                    throw std::domain_error(fmt::format("Could not find a non-residue modulo: {}", _modulus));
+                }
+                mpz_add_ui(n, n, 1);
+            }
+
+            // The generator of the 2-Sylow subgroup is n^q.
+            mpz_t z;
+            mpz_init(z);
+            mpz_powm(z, n, q.value, p);
+
+            auto q_minus_one_half = (q - 1) / 2;
+            _tonelli_shanks = std::make_unique<TonelliShanks>(TonelliShanks{
+                std::move(q), e, std::move(q_minus_one_half), BigInt{n}, BigInt{z}
+            });
+
+            mpz_clears(z, n, nullptr);
+        });
+        return *_tonelli_shanks;
+    }
+
+    const PrimeField::SqrtTables &PrimeField::sqrt_tables() const {
+        std::call_once(_sqrt_tables_flag, [this] {
+            const ArenaSuspension suspension;
+            const auto &ts = tonelli_shanks();
+            const auto &p = _modulus.value;
+            const auto window = std::min(ts.e, sqrt_table_window);
+            const auto windows = (ts.e + window - 1) / window;
+
+            mpz_t g_inverse, h, power;
+            mpz_inits(g_inverse, h, power, nullptr);
+            mpz_invert(g_inverse, ts.generator.value, p);
+
+            // h = g^{2^(e - window)}, and its powers.
+            std::map<BigInt, unsigned long> digits;
+            mpz_set(h, ts.generator.value);
+            for (auto i = window; i < ts.e; ++i)
+                mpz_powm_ui(h, h, 2, p);
+            mpz_set_ui(power, 1);
+            for (unsigned long j = 0; j < 1UL << window; ++j) {
+                digits.emplace(BigInt{power}, j);
+                mpz_mul(power, power, h);
+                mpz_mod(power, power, p);
+            }
+
+            // corrections[i][d] = (g^{-2^{i window}})^d, with the base squared window times for each i.
+            std::vector<std::vector<BigInt>> corrections(windows);
+            mpz_set(h, g_inverse);
+            for (auto &row: corrections) {
+                row.reserve(1UL << window);
+                mpz_set_ui(power, 1);
+                for (unsigned long d = 0; d < 1UL << window; ++d) {
+                    row.emplace_back(power);
+                    mpz_mul(power, power, h);
+                    mpz_mod(power, power, p);
+                }
+                for (mp_bitcnt_t i = 0; i < window; ++i)
+                    mpz_powm_ui(h, h, 2, p);
+            }
+
+            _sqrt_tables = std::make_unique<SqrtTables>(SqrtTables{
+                window, std::move(digits), std::move(corrections), BigInt{g_inverse}
+            });
+            mpz_clears(power, h, g_inverse, nullptr);
+        });
+        return *_sqrt_tables;
+    }
+
+    const Montgomery &PrimeField::montgomery() const {
+        std::call_once(_montgomery_flag, [this] {
+            const ArenaSuspension suspension;
+            _montgomery = std::make_unique<Montgomery>(_modulus);
+        });
+        return *_montgomery;
+    }
+}
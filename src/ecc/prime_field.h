@@ -0,0 +1,143 @@
+/**
+ * prime_field.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <gmp.h>
+
+#include "big_int.h"
+
+namespace ecc {
+    class Montgomery;
+
+    // The shared context for every ModularInt over the same modulus.
+    // Contexts are interned: asking for the context of a modulus that is already in use returns the existing
+    // instance, so two ModularInts are compatible iff they point to the same PrimeField.
+    // Despite the name, the modulus is not required to be prime: the cached square root data below is only
+    // meaningful for odd primes, and is only computed when first requested.
+    class PrimeField final {
+    public:
+        // The data needed by Tonelli and Shanks, where p - 1 = q * 2^e with q odd.
+        struct TonelliShanks {
+            BigInt q;
+            mp_bitcnt_t e;
+            // (q - 1) / 2.
+            BigInt q_minus_one_half;
+            // The smallest quadratic non-residue n, and n^q (mod p), a generator of the 2-Sylow subgroup.
+            BigInt non_residue;
+            BigInt generator;
+        };
+
+        // Tables for a windowed Tonelli and Shanks: with a = a^q in the 2-Sylow subgroup generated by g = n^q, the
+        // discrete logarithm of a^q to the base g is found a window of bits at a time by table lookups, rather than
+        // one bit at a time by repeated squaring.
+        struct SqrtTables {
+            mp_bitcnt_t window;
+            // h^j -> j for j in [0, 2^window), where h = g^{2^(e - window)} has order 2^window.
+            std::map<BigInt, unsigned long> digits;
+            // corrections[i][d] = g^{-d 2^{i window}}, which clears the digit d found in the i-th window.
+            std::vector<std::vector<BigInt>> corrections;
+            // g^-1.
+            BigInt generator_inverse;
+        };
+
+        // Working space for the arithmetic of the calling thread, so that intermediate results are written into
+        // storage that is already large enough rather than into new values that grow by reallocating. Each thread has
+        // one, shared by every field and sized for the largest so far. Its values are overwritten by the next
+        // operation to use them, so they must not be held across calls into ModularInt.
+        struct Scratch {
+            // Room for a product of two elements, or anything else of up to twice the size of the modulus.
+            BigInt product;
+            // Room for an element.
+            BigInt element;
+        };
+
+        // Get the interned context for the modulus, creating it if necessary. A negative modulus -m gives the field
+        // for m. If the modulus is zero, std::domain_error is thrown.
+        [[nodiscard]] static std::shared_ptr<const PrimeField> get(const BigInt&);
+
+        PrimeField(const PrimeField&) = delete;
+        PrimeField(PrimeField&&) = delete;
+        ~PrimeField();
+
+        PrimeField &operator=(const PrimeField&) = delete;
+        PrimeField &operator=(PrimeField&&) = delete;
+
+        [[nodiscard]] inline const BigInt &modulus() const noexcept {
+            return _modulus;
+        }
+
+        // The number of bits in the modulus.
+        [[nodiscard]] inline std::size_t bits() const noexcept {
+            return _bits;
+        }
+
+        // The number of bytes in the fixed-length encoding of an element.
+        [[nodiscard]] inline std::size_t bytes() const noexcept {
+            return (_bits + 7) / 8;
+        }
+
+        // The number of limbs in the modulus.
+        [[nodiscard]] inline std::size_t limbs() const noexcept {
+            return _limbs;
+        }
+
+        // The capacity with which elements are created. GMP makes room for a carry whether or not there is one, so
+        // a sum, which may already have carried into a limb more than the modulus, needs another for its reduction.
+        [[nodiscard]] inline mp_bitcnt_t element_capacity() const noexcept {
+            return (_limbs + 2) * GMP_NUMB_BITS;
+        }
+
+        // The calling thread's scratch space, with room for this field's products.
+        [[nodiscard]] Scratch &scratch() const;
+
+        // (p + 1) / 4 if p ≡ 3 (mod 4), in which case a^{(p+1)/4} is a square root of a residue a.
+        [[nodiscard]] inline const std::optional<BigInt> &sqrt_exponent() const noexcept {
+            return _sqrt_exponent;
+        }
+
+        // (p - 5) / 8 if p ≡ 5 (mod 8), which Atkin's square root uses.
+        [[nodiscard]] inline const std::optional<BigInt> &atkin_exponent() const noexcept {
+            return _atkin_exponent;
+        }
+
+        // The Tonelli and Shanks decomposition of p - 1 and a non-residue, calculated on first use.
+        // If no non-residue can be found (i.e. the modulus is not an odd prime), std::domain_error is thrown.
+        [[nodiscard]] const TonelliShanks &tonelli_shanks() const;
+
+        // The tables for the windowed Tonelli and Shanks, calculated on first use, which pay for themselves when the
+        // 2-adic valuation e of p - 1 is large. This throws as tonelli_shanks does.
+        [[nodiscard]] const SqrtTables &sqrt_tables() const;
+
+        // The Montgomery arithmetic kernel for this field, created on first use.
+        // If the modulus is even, std::domain_error is thrown.
+        [[nodiscard]] const Montgomery &montgomery() const;
+
+    private:
+        BigInt _modulus;
+        std::size_t _bits;
+        std::size_t _limbs;
+        std::optional<BigInt> _sqrt_exponent;
+        std::optional<BigInt> _atkin_exponent;
+
+        mutable std::once_flag _tonelli_shanks_flag;
+        mutable std::unique_ptr<TonelliShanks> _tonelli_shanks;
+
+        mutable std::once_flag _sqrt_tables_flag;
+        mutable std::unique_ptr<SqrtTables> _sqrt_tables;
+
+        mutable std::once_flag _montgomery_flag;
+        mutable std::unique_ptr<Montgomery> _montgomery;
+
+        explicit PrimeField(BigInt);
+    };
+}
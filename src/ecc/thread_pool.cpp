@@ -0,0 +1,113 @@
+/**
+ * thread_pool.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "thread_pool.h"
+
+namespace ecc {
+    // The pool and queue index of a worker thread, so that its submissions go to its own queue.
+    static thread_local const ThreadPool *current_pool = nullptr;
+    static thread_local std::size_t current_index = 0;
+
+    // How long a thread waiting on a parallel_for sleeps before looking for tasks to steal again.
+    static constexpr std::chrono::microseconds wait_poll{200};
+
+    ThreadPool::ThreadPool(std::size_t threads) {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        _queues.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+            _queues.push_back(std::make_unique<Queue>());
+        _threads.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+            _threads.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock{_sleep_mutex};
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &thread: _threads)
+            thread.join();
+    }
+
+    ThreadPool &ThreadPool::global() {
+        // Leaked, so that it outlives any static objects that use it during shutdown.
+        static auto *pool = new ThreadPool{};
+        return *pool;
+    }
+
+    void ThreadPool::submit(std::function<void()> task) {
+        // Count the task before it is visible, so that _pending never undercounts what a thief can find.
+        {
+            std::lock_guard lock{_sleep_mutex};
+            ++_pending;
+        }
+        const auto index = current_pool == this ? current_index : _next_queue++ % _queues.size();
+        {
+            auto &queue = *_queues[index];
+            std::lock_guard lock{queue.mutex};
+            queue.tasks.push_back(std::move(task));
+        }
+        _wake.notify_one();
+    }
+
+    bool ThreadPool::run_one() {
+        // Start with our own queue, taking the newest task, and otherwise steal the oldest task from the others.
+        const auto self = current_pool == this ? current_index : 0;
+        std::optional<std::function<void()>> task;
+        for (std::size_t offset = 0; offset < _queues.size() && !task; ++offset) {
+            const auto index = (self + offset) % _queues.size();
+            auto &queue = *_queues[index];
+            std::lock_guard lock{queue.mutex};
+            if (queue.tasks.empty())
+                continue;
+            if (offset == 0 && current_pool == this) {
+                task.emplace(std::move(queue.tasks.back()));
+                queue.tasks.pop_back();
+            } else {
+                task.emplace(std::move(queue.tasks.front()));
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task)
+            return false;
+
+        --_pending;
+        (*task)();
+        return true;
+    }
+
+    void ThreadPool::worker_loop(std::size_t index) {
+        current_pool = this;
+        current_index = index;
+        for (;;) {
+            if (run_one())
+                continue;
+            std::unique_lock lock{_sleep_mutex};
+            _wake.wait(lock, [this] { return _stop || _pending > 0; });
+            if (_stop && _pending == 0)
+                return;
+        }
+    }
+
+    void ThreadPool::wait(TaskGroup &group) {
+        while (group.remaining > 0) {
+            if (run_one())
+                continue;
+            std::unique_lock lock{group.mutex};
+            group.done.wait_for(lock, wait_poll, [&group] { return group.remaining == 0; });
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * thread_pool.h
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ecc {
+    // A fixed-size pool of worker threads for the batch operations.
+    // Each worker has its own deque of tasks: it takes work from the back of its own deque, and when that is empty,
+    // steals from the front of the others, so that uneven tasks still keep every thread busy.
+    // Threads waiting on a parallel_for run queued tasks themselves, so parallel_for may be nested.
+    class ThreadPool final {
+    public:
+        // Create a pool with the given number of workers. If threads is 0, std::thread::hardware_concurrency()
+        // workers are created.
+        explicit ThreadPool(std::size_t threads = 0);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+
+        // Finish the queued tasks, and join the workers.
+        ~ThreadPool();
+
+        ThreadPool &operator=(const ThreadPool&) = delete;
+        ThreadPool &operator=(ThreadPool&&) = delete;
+
+        // A pool shared by the whole process, with one worker per hardware thread, created on first use.
+        [[nodiscard]] static ThreadPool &global();
+
+        [[nodiscard]] inline std::size_t size() const noexcept {
+            return _threads.size();
+        }
+
+        // Call f(begin, end) over subranges covering [0, count), with each subrange holding at least grain indices,
+        // and wait for all of them to finish. If any call throws, the first exception is rethrown here once the
+        // others have finished.
+        template <typename F>
+        void parallel_for(std::size_t count, std::size_t grain, F &&f) {
+            if (count == 0)
+                return;
+
+            // A few chunks per worker lets stealing even out the load. Spreading count evenly over them keeps every
+            // chunk at least as large as the grain.
+            grain = std::max<std::size_t>(grain, 1);
+            const auto chunks = std::max<std::size_t>(1, std::min(count / grain, 4 * size()));
+            if (chunks == 1) {
+                f(std::size_t{0}, count);
+                return;
+            }
+
+            auto group = std::make_shared<TaskGroup>();
+            group->remaining = chunks;
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                const auto begin = chunk * count / chunks;
+                const auto end = (chunk + 1) * count / chunks;
+                submit([group, &f, begin, end] {
+                    try {
+                        f(begin, end);
+                    } catch (...) {
+                        std::lock_guard lock{group->mutex};
+                        if (!group->error)
+                            group->error = std::current_exception();
+                    }
+                    if (--group->remaining == 0) {
+                        std::lock_guard lock{group->mutex};
+                        group->done.notify_all();
+                    }
+                });
+            }
+            wait(*group);
+            if (group->error)
+                std::rethrow_exception(group->error);
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        struct TaskGroup {
+            std::atomic<std::size_t> remaining{0};
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;
+        };
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::vector<std::thread> _threads;
+
+        // The number of queued tasks, and the means for idle workers to sleep until there are some.
+        std::atomic<std::size_t> _pending{0};
+        std::mutex _sleep_mutex;
+        std::condition_variable _wake;
+        bool _stop = false;
+
+        // Where submissions from outside the pool go next.
+        std::atomic<std::size_t> _next_queue{0};
+
+        void submit(std::function<void()>);
+
+        // Run one task, from this thread's own queue if it is a worker, or stolen from another queue.
+        // Returns false if there was nothing to run.
+        bool run_one();
+
+        void worker_loop(std::size_t index);
+        void wait(TaskGroup&);
+    };
+}
@@ -9,9 +9,13 @@
 #include <iostream>
 #endif
 
+#include <memory>
+#include <optional>
 #include <rapidcheck.h>
 #include <big_int.h>
+#include <elliptic_curve.h>
 #include <modular_int.h>
+#include <point.h>
 #include <vector>
 
 #include "gmp_gens.h"
@@ -51,6 +55,33 @@ namespace rc {
         });
     }
 
+    // Generate a probably prime gmp_mpz_t with the given number of random bits, for multi-limb moduli.
+    Gen<gmp_mpz_t> arbitraryPrimeGmp(mp_bitcnt_t bits) {
+        return gen::exec([bits]() {
+            mpz_t random_num;
+            mpz_init(random_num);
+            mpz_urandomb(random_num, Arbitrary<gmp_mpz_t>::state.state, bits);
+            mpz_setbit(random_num, bits - 1);
+            mpz_nextprime(random_num, random_num);
+            gmp_mpz_t v{random_num};
+            mpz_clear(random_num);
+            return v;
+        });
+    }
+
+    // Generate a ModularInt over a random prime with the given number of bits.
+    Gen<ecc::ModularInt> arbitraryModularInt(mp_bitcnt_t bits) {
+        return gen::exec([bits]() {
+            const ecc::BigInt mod{(*arbitraryPrimeGmp(bits)).value};
+            mpz_t random_num;
+            mpz_init(random_num);
+            mpz_urandomm(random_num, Arbitrary<gmp_mpz_t>::state.state, static_cast<const mpz_t&>(mod));
+            ecc::ModularInt m{ecc::BigInt{random_num}, mod};
+            mpz_clear(random_num);
+            return m;
+        });
+    }
+
     template<>
     struct Arbitrary<ecc::ModularInt> {
         static Gen<ecc::ModularInt> arbitrary() {
@@ -72,4 +103,47 @@ namespace rc {
     const auto residueModularInt = gen::suchThat<ecc::ModularInt>([](const ecc::ModularInt &mi) {
         return mi.legendre() == ecc::ModularInt::Legendre::RESIDUE;
     });
-}
\ No newline at end of file
+
+    // Generate a uniformly random element of the field.
+    ecc::ModularInt randomElement(const std::shared_ptr<const ecc::PrimeField> &field) {
+        mpz_t random_num;
+        mpz_init(random_num);
+        mpz_urandomm(random_num, Arbitrary<gmp_mpz_t>::state.state, static_cast<const mpz_t&>(field->modulus()));
+        ecc::ModularInt m{ecc::BigInt{random_num}, field};
+        mpz_clear(random_num);
+        return m;
+    }
+
+    // Generate a non-singular curve y^2 = x^3 + ax + b over a random prime with the given number of bits.
+    // If a is specified, it is used in place of a random coefficient.
+    Gen<std::shared_ptr<const ecc::EllipticCurve>> arbitraryCurve(mp_bitcnt_t bits = 64,
+                                                                   std::optional<ecc::BigInt> fixed_a = std::nullopt) {
+        return gen::exec([bits, fixed_a]() {
+            const ecc::BigInt p{(*arbitraryPrimeGmp(bits)).value};
+            const auto field = ecc::PrimeField::get(p);
+            for (;;) {
+                const auto a = fixed_a.has_value() ? ecc::ModularInt{*fixed_a, field} : randomElement(field);
+                const auto b = randomElement(field);
+                try {
+                    return ecc::EllipticCurve::create(a.get_value(), b.get_value(), p);
+                } catch (const std::domain_error&) {
+                    // Singular: try again.
+                }
+            }
+        });
+    }
+
+    // Generate a random affine point on the curve.
+    Gen<ecc::Point> arbitraryPoint(const std::shared_ptr<const ecc::EllipticCurve> &curve) {
+        return gen::exec([curve]() {
+            for (;;) {
+                const auto x = randomElement(curve->get_field());
+                const auto rhs = curve->rhs(x);
+                if (rhs.get_value().zero())
+                    return ecc::Point{curve, x, rhs};
+                if (const auto y = rhs.sqrt(); y.has_value())
+                    return ecc::Point{curve, x, *gen::arbitrary<bool>() ? *y : -*y};
+            }
+        });
+    }
+}
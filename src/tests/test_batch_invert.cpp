@@ -0,0 +1,92 @@
+/**
+ * test_batch_invert.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <vector>
+
+#include <rapidcheck.h>
+#include <batch_invert.h>
+#include <modular_int.h>
+#include <prime_field.h>
+#include <thread_pool.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Random elements of the field, with roughly one in eight of them zero.
+static std::vector<ModularInt> elements(const std::shared_ptr<const PrimeField> &field, std::size_t n) {
+    std::vector<ModularInt> result;
+    result.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        result.push_back(*rc::gen::inRange(0, 8) == 0 ? ModularInt{0, field} : rc::randomElement(field));
+    return result;
+}
+
+// Check that the batch is the elementwise inverse of the original, except at the zeros, which must be reported.
+static void check_inverted(const std::vector<ModularInt> &original,
+                           const std::vector<ModularInt> &inverted,
+                           const std::vector<std::size_t> &failures) {
+    std::vector<std::size_t> zeros;
+    for (std::size_t i = 0; i < original.size(); ++i) {
+        if (original[i].get_value().zero()) {
+            zeros.push_back(i);
+            RC_ASSERT(inverted[i] == original[i]);
+        } else {
+            RC_ASSERT(inverted[i] == *original[i].invert());
+        }
+    }
+    RC_ASSERT(failures == zeros);
+}
+
+int main() {
+    rc::check("test batch inversion agrees with elementwise inversion",
+              []() {
+        const auto field = (*rc::arbitraryModularInt(*rc::gen::element<mp_bitcnt_t>(64, 256))).get_field();
+        const auto original = elements(field, *rc::gen::inRange<std::size_t>(0, 100));
+        auto inverted = original;
+        const auto failures = batch_invert(inverted);
+        check_inverted(original, inverted, failures);
+    });
+
+    rc::check("test parallel batch inversion agrees with elementwise inversion",
+              []() {
+        const auto field = (*rc::arbitraryModularInt(64)).get_field();
+        const auto original = elements(field, *rc::gen::inRange<std::size_t>(0, 5000));
+        auto inverted = original;
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        const auto failures = batch_invert_parallel(inverted, pool);
+        check_inverted(original, inverted, failures);
+    });
+
+    rc::check("test batch inversion with a composite modulus",
+              []() {
+        // Modulo 15, the multiples of 3 and 5 have no inverses, but the rest of the batch does.
+        std::vector<ModularInt> original;
+        for (long i = 0; i < 30; ++i)
+            original.emplace_back(i, 15);
+        auto inverted = original;
+        const auto failures = batch_invert(inverted);
+
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < original.size(); ++i) {
+            if (const auto inverse = original[i].invert(); inverse.has_value()) {
+                RC_ASSERT(inverted[i] == *inverse);
+            } else {
+                expected.push_back(i);
+                RC_ASSERT(inverted[i] == original[i]);
+            }
+        }
+        RC_ASSERT(failures == expected);
+    });
+
+    rc::check("test batch inversion rejects mixed moduli",
+              [](const ModularInt &m1, const ModularInt &m2) {
+        RC_PRE(m1.get_mod() != m2.get_mod());
+        std::vector<ModularInt> batch{m1, m2};
+        RC_ASSERT_THROWS_AS((void)batch_invert(batch), std::domain_error);
+        RC_ASSERT(batch[0] == m1);
+    });
+
+    return 0;
+}
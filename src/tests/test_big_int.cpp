@@ -3,6 +3,10 @@
  * By Sebastian Raaphorst, 2023.
  */
 
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <gmp.h>
 #include <rapidcheck.h>
 #include <big_int.h>
 #include "ecc_gens.h"
@@ -31,5 +35,106 @@ int main() {
         RC_ASSERT(coeff1 * bi1 + coeff2 * bi2 == gcd);
     });
 
+    rc::check("test wNAF recoding",
+              [](const ecc::BigInt &bi, bool negate) {
+        const auto width = *rc::gen::inRange(2u, 9u);
+        const auto k = negate ? -bi : bi;
+        const auto digits = k.wnaf(width);
+
+        // The digits must sum back to k, be odd and small when nonzero, and be spread at least width apart.
+        BigInt sum;
+        BigInt power{1};
+        std::size_t last_nonzero = 0;
+        bool seen_nonzero = false;
+        for (std::size_t i = 0; i < digits.size(); ++i) {
+            const int digit = digits[i];
+            if (digit != 0) {
+                RC_ASSERT(digit % 2 != 0);
+                RC_ASSERT(std::abs(digit) < (1 << (width - 1)));
+                if (seen_nonzero)
+                    RC_ASSERT(i - last_nonzero >= width);
+                last_nonzero = i;
+                seen_nonzero = true;
+            }
+            sum += power * BigInt{digit};
+            power += power;
+        }
+        RC_ASSERT(sum == k);
+        RC_ASSERT(digits.empty() || digits.back() != 0);
+    });
+
+    rc::check("test wNAF rejects bad widths",
+              [](const ecc::BigInt &bi) {
+        RC_ASSERT_THROWS_AS((void)bi.wnaf(1), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)bi.wnaf(9), std::domain_error);
+    });
+
+    rc::check("test byte encodings round trip in both byte orders",
+              [](const ecc::BigInt &bi, bool little) {
+        const auto k = bi < 0 ? -bi : bi;
+        const auto endian = little ? BigInt::Endian::LITTLE : BigInt::Endian::BIG;
+        const auto padding = *rc::gen::inRange<std::size_t>(0, 8);
+        std::vector<std::uint8_t> bytes(k.byte_size() + padding, 0xff);
+        k.to_bytes(bytes, endian);
+        RC_ASSERT(BigInt::from_bytes(bytes, endian) == k);
+
+        // The padding is zeros, at the most significant end.
+        for (std::size_t i = 0; i < padding; ++i)
+            RC_ASSERT(bytes[little ? bytes.size() - 1 - i : i] == 0);
+
+        // The two byte orders are reverses of each other.
+        std::vector<std::uint8_t> other(bytes.size());
+        k.to_bytes(other, little ? BigInt::Endian::BIG : BigInt::Endian::LITTLE);
+        RC_ASSERT(std::equal(bytes.begin(), bytes.end(), other.rbegin()));
+    });
+
+    rc::check("test byte encodings reject negative numbers and short buffers",
+              [](const ecc::BigInt &bi) {
+        RC_PRE(!bi.zero());
+        const auto k = bi < 0 ? -bi : bi;
+        std::vector<std::uint8_t> bytes(k.byte_size());
+        RC_ASSERT_THROWS_AS((-k).to_bytes(bytes), std::domain_error);
+        RC_ASSERT_THROWS_AS(k.to_bytes(std::span{bytes}.first(bytes.size() - 1)), std::domain_error);
+    });
+
+    rc::check("test hex round trip agrees with GMP",
+              [](const ecc::BigInt &bi) {
+        const auto hex = bi.to_hex();
+        const auto gmp_hex = mpz_get_str(nullptr, 16, static_cast<const mpz_t&>(bi));
+        RC_ASSERT(hex == gmp_hex);
+        free(gmp_hex);
+        RC_ASSERT(BigInt::from_hex(hex) == bi);
+    });
+
+    rc::check("test invalid hex is rejected",
+              []() {
+        RC_ASSERT(BigInt::from_hex("-DeadBeef") == BigInt{-0xdeadbeefL});
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex(""), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex("-"), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex("0x12"), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex("12 34"), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex("g"), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex("12\xff"), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)BigInt::from_hex("\xc3\xa9"), std::domain_error);
+    });
+
+    rc::check("test capacity is reserved without changing the value",
+              [](const ecc::BigInt &bi) {
+        const auto bits = *rc::gen::inRange<mp_bitcnt_t>(1, 8192);
+        const auto empty = BigInt::with_capacity(bits);
+        RC_ASSERT(empty.zero());
+        RC_ASSERT(empty.capacity() >= bits);
+
+        auto copy = bi;
+        copy.reserve(bits);
+        RC_ASSERT(copy == bi);
+        RC_ASSERT(copy.capacity() >= bits);
+
+        // Reserving never shrinks.
+        const auto capacity = copy.capacity();
+        copy.reserve(1);
+        RC_ASSERT(copy.capacity() == capacity);
+    });
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+/**
+ * test_constant_time.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <memory>
+
+#include <rapidcheck.h>
+#include <big_int.h>
+#include <constant_time.h>
+#include <elliptic_curve.h>
+#include <modular_int.h>
+#include <named_curves.h>
+#include <point.h>
+#include <prime_field.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Moduli of one limb, and several limbs.
+static const auto bit_sizes = rc::gen::element<mp_bitcnt_t>(64, 127, 256, 521);
+
+static BigInt power_of_two(std::size_t bits) {
+    mpz_t value;
+    mpz_init(value);
+    mpz_setbit(value, bits);
+    BigInt result{value};
+    mpz_clear(value);
+    return result;
+}
+
+int main() {
+    rc::check("test constant-time pow agrees with pow",
+              []() {
+        const auto a = *rc::arbitraryModularInt(*bit_sizes);
+        const auto bits = *rc::gen::element<std::size_t>(1, 63, 64, 65, 256);
+        auto e = *rc::gen::arbitrary<BigInt>();
+        if (e < 0)
+            e = -e;
+        e %= power_of_two(bits);
+        RC_ASSERT(ct::pow(a, e, bits) == a.pow(e));
+        RC_ASSERT(ct::pow(a, BigInt{0}, 0) == ModularInt(1, a.get_field()));
+        RC_ASSERT(ct::pow(ModularInt{0, a.get_field()}, BigInt{1}, bits) == ModularInt(0, a.get_field()));
+        RC_ASSERT_THROWS_AS((void)ct::pow(a, BigInt{-1}, bits), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::pow(a, power_of_two(bits), bits), std::domain_error);
+    });
+
+    rc::check("test constant-time field arithmetic agrees with ModularInt",
+              []() {
+        const auto a = *rc::arbitraryModularInt(*bit_sizes);
+        const auto b = rc::randomElement(a.get_field());
+        RC_ASSERT(ct::add(a, b) == a + b);
+        RC_ASSERT(ct::mul(a, b) == a * b);
+        RC_ASSERT(ct::invert(a) == a.invert());
+        RC_ASSERT(!ct::invert(ModularInt{0, a.get_field()}).has_value());
+        RC_ASSERT_THROWS_AS((void)ct::mul(a, *rc::arbitraryModularInt(64)), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::invert(ModularInt(3, BigInt{1024})), std::domain_error);
+    });
+
+    rc::check("test constant-time elements are taken as they are",
+              []() {
+        const auto a = *rc::arbitraryModularInt(*bit_sizes);
+        const auto &field = a.get_field();
+        const auto &p = field->modulus();
+        RC_ASSERT(ct::element(a.get_value(), field) == a);
+        RC_ASSERT(ct::element(BigInt{0}, field) == ModularInt(0, field));
+        RC_ASSERT(ct::element(p - BigInt{1}, field) == ModularInt(p - BigInt{1}, field));
+        RC_ASSERT_THROWS_AS((void)ct::element(p, field), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::element(p + a.get_value(), field), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::element(BigInt{-1}, field), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::element(p * p, field), std::domain_error);
+    });
+
+    rc::check("test the Montgomery ladder agrees with scalar multiplication",
+              []() {
+        const auto curve = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256());
+        const auto p = curve->generator() * *rc::gen::arbitrary<BigInt>();
+        const auto &n = *curve->order();
+        auto k = *rc::gen::arbitrary<BigInt>();
+        if (k < 0)
+            k = -k;
+        k %= n;
+        RC_ASSERT(ct::multiply(p, k) == p * k);
+        RC_ASSERT(ct::multiply(p, n - BigInt{1}) == -p);
+        RC_ASSERT(ct::multiply(p, BigInt{0}).is_infinity());
+        RC_ASSERT(ct::multiply(curve->infinity(), k).is_infinity());
+
+        // The order itself needs one bit more than the default.
+        const auto bits = mpz_sizeinbase(static_cast<const mpz_t&>(n), 2);
+        RC_ASSERT(ct::multiply(p, n + k, bits + 1) == p * k);
+        RC_ASSERT_THROWS_AS((void)ct::multiply(p, power_of_two(bits)), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::multiply(p, BigInt{-1}), std::domain_error);
+    });
+
+    rc::check("test constant-time fixed-base multiplication agrees with scalar multiplication",
+              []() {
+        const auto curve = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256());
+        const auto p = curve->generator() * *rc::gen::arbitrary<BigInt>();
+        const auto width = *rc::gen::inRange(ct::FixedBaseTable::min_width, 7u);
+        const ct::FixedBaseTable table{p, 64, width};
+        RC_ASSERT(table.size() == (64 + width - 1) / width << width);
+
+        // Include the edge cases 0 and 2^64 - 1.
+        const auto k = *rc::gen::element<BigInt>(BigInt{0}, BigInt{"18446744073709551615"},
+                                                 *rc::gen::arbitrary<BigInt>() % BigInt{"18446744073709551616"});
+        RC_PRE(!(k < 0));
+        RC_ASSERT(table.multiply(k) == p * k);
+        RC_ASSERT_THROWS_AS((void)table.multiply(BigInt{"18446744073709551616"}), std::domain_error);
+        RC_ASSERT_THROWS_AS(ct::FixedBaseTable(p, 64, ct::FixedBaseTable::max_width + 1), std::domain_error);
+        RC_ASSERT_THROWS_AS(ct::FixedBaseTable(curve->infinity(), 64), std::domain_error);
+
+        const auto &n = *curve->order();
+        RC_ASSERT(curve->multiply_generator_constant_time(n - BigInt{1}) == -curve->generator());
+        RC_ASSERT(curve->multiply_generator_constant_time(n).is_infinity());
+        RC_ASSERT(curve->multiply_generator_constant_time(k) == curve->multiply_generator(k));
+    });
+
+    rc::check("test a curve's constant-time generator table does not keep the curve alive",
+              []() {
+        const auto named = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256());
+        const auto g = named->generator();
+        auto curve = EllipticCurve::create(named->a().get_value(), named->b().get_value(), named->get_mod(),
+                                           g.x().get_value(), g.y().get_value(), *named->order(), *named->cofactor());
+        const auto k = *rc::gen::arbitrary<BigInt>() % *curve->order();
+        RC_PRE(!(k < 0));
+        RC_ASSERT(curve->multiply_generator_constant_time(k) == curve->generator() * k);
+
+        const std::weak_ptr<const EllipticCurve> weak = curve;
+        curve.reset();
+        RC_ASSERT(weak.expired());
+    });
+
+    rc::check("test the Montgomery ladder requires a curve of known odd order",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        RC_ASSERT_THROWS_AS((void)ct::multiply(p, BigInt{1}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ct::multiply(p, BigInt{1}, 8), std::domain_error);
+        RC_ASSERT_THROWS_AS(ct::FixedBaseTable(p, 8), std::domain_error);
+    });
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+/**
+ * test_ecdsa.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <rapidcheck.h>
+#include <ecdsa.h>
+#include <multi_scalar_mul.h>
+#include <named_curves.h>
+#include <thread_pool.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+static BigInt from_hex(std::string_view hex) {
+    const std::string str{hex};
+    mpz_t value;
+    mpz_init_set_str(value, str.c_str(), 16);
+    BigInt result{value};
+    mpz_clear(value);
+    return result;
+}
+
+static std::vector<std::uint8_t> bytes_from_hex(std::string_view hex) {
+    std::vector<std::uint8_t> bytes;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2)
+        bytes.push_back(static_cast<std::uint8_t>(std::stoi(std::string{hex.substr(i, 2)}, nullptr, 16)));
+    return bytes;
+}
+
+// A random 32-byte digest.
+static std::vector<std::uint8_t> arbitrary_digest() {
+    std::vector<std::uint8_t> digest;
+    for (auto i = 0; i < 32; ++i)
+        digest.push_back(*rc::gen::inRange<std::uint8_t>(0, 255));
+    return digest;
+}
+
+// SEC 2's secp112r1, which is too small for real use, but makes tests with large batches cheap.
+static const std::shared_ptr<const EllipticCurve> &secp112r1() {
+    static const auto curve = EllipticCurve::create(
+            BigInt{-3},
+            BigInt{"2061118396808653202902996166388514"},
+            BigInt{"4451685225093714772084598273548427"},
+            BigInt{"188281465057972534892223778713752"},
+            BigInt{"3419875491033170827167861896082688"},
+            BigInt{"4451685225093714776491891542548933"},
+            BigInt{1});
+    return curve;
+}
+
+int main() {
+    rc::check("test joint sparse form",
+              [](const BigInt &b0, const BigInt &b1, bool negate0, bool negate1) {
+        const auto k0 = negate0 ? -b0 : b0;
+        const auto k1 = negate1 ? -b1 : b1;
+        const auto digits = BigInt::joint_sparse_form(k0, k1);
+
+        // The digits must sum back to the numbers, and of any three consecutive digit pairs, one must be zero.
+        BigInt sums[2];
+        BigInt power{1};
+        for (std::size_t i = 0; i < digits.size(); ++i) {
+            for (int j = 0; j < 2; ++j) {
+                RC_ASSERT(digits[i][j] >= -1 && digits[i][j] <= 1);
+                sums[j] += power * BigInt{digits[i][j]};
+            }
+            if (i >= 2) {
+                bool some_zero = false;
+                for (auto back = i - 2; back <= i; ++back)
+                    some_zero = some_zero || (digits[back][0] == 0 && digits[back][1] == 0);
+                RC_ASSERT(some_zero);
+            }
+            power += power;
+        }
+        RC_ASSERT(sums[0] == k0);
+        RC_ASSERT(sums[1] == k1);
+    });
+
+    rc::check("test RFC 6979 P-256 SHA-256 known answer",
+              []() {
+        const auto &curve = curves::p256();
+        const auto d = from_hex("C9AFA9D845BA75166B5C215767B1D6934E50C3DB36E89B127B8A622B120F6721");
+        const auto q = ecdsa::public_key(curve, d);
+        RC_ASSERT(q.x().get_value() == from_hex("60FED4BA255A9D31C961EB74C6356D68C049B8923B61FA6CE669622E60F29FB6"));
+        RC_ASSERT(q.y().get_value() == from_hex("7903FE1008B8BC99A41AE9E95628BC64F2F1B20C2D7E9F5177A3C294D4462299"));
+
+        // SHA-256("sample"), and the nonce RFC 6979 derives for it.
+        const auto digest = bytes_from_hex("AF2BDBE1AA9B6EC1E2ADE1D694F41FC71A831D0268E9891562113D8A62ADD1BF");
+        const auto k = from_hex("A6E3C57DD01ABE90086538398355DD4C3B17AA873382B0F24D6129493D8AAD60");
+        const auto signature = ecdsa::sign(curve, d, digest, k);
+        RC_ASSERT(signature.r == from_hex("EFD48B2AACB6A8FD1140DD9CD45E81D69D2C877B56AAF991C34D0EA84EAF3716"));
+        RC_ASSERT(signature.s == from_hex("F7CB1C942D657C41D436C7A1B6E29F65F3E900DBB9AFF4064DC4AB2F843ACDA8"));
+        RC_ASSERT(ecdsa::verify(q, digest, signature));
+    });
+
+    rc::check("test constant-time signing gives the same signatures",
+              []() {
+        const auto curve = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256(),
+                                                                                    secp112r1());
+        const auto [d, q] = ecdsa::generate_key(curve, ecdsa::Mode::CONSTANT_TIME);
+        RC_ASSERT(ecdsa::public_key(curve, d) == q);
+
+        const auto digest = arbitrary_digest();
+        const auto k = ecdsa::generate_key(curve).private_key;
+        const auto signature = ecdsa::sign(curve, d, digest, k, ecdsa::Mode::CONSTANT_TIME);
+        RC_ASSERT(signature == ecdsa::sign(curve, d, digest, k));
+        RC_ASSERT(ecdsa::verify(q, digest, ecdsa::sign(curve, d, digest, ecdsa::Mode::CONSTANT_TIME)));
+    });
+
+    rc::check("test signatures verify, and tampered signatures do not",
+              []() {
+        const auto curve = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256());
+        const auto [d, q] = ecdsa::generate_key(curve);
+        const auto digest = arbitrary_digest();
+        const auto signature = ecdsa::sign(curve, d, digest);
+        RC_ASSERT(ecdsa::verify(q, digest, signature));
+
+        // The parity is filled in, but it is not part of the signature proper.
+        RC_ASSERT(signature.odd_y.has_value());
+        RC_ASSERT((ecdsa::Signature{signature.r, signature.s} == signature));
+        RC_ASSERT(ecdsa::verify(q, digest, ecdsa::Signature{signature.r, signature.s}));
+
+        auto other_digest = digest;
+        other_digest[*rc::gen::inRange<std::size_t>(0, digest.size())] ^= 1;
+        RC_ASSERT(!ecdsa::verify(q, other_digest, signature));
+        RC_ASSERT(!ecdsa::verify(q, digest, ecdsa::Signature{signature.r, signature.s + BigInt{1}}));
+        RC_ASSERT(!ecdsa::verify(q, digest, ecdsa::Signature{BigInt{0}, signature.s}));
+        RC_ASSERT(!ecdsa::verify(q, digest, ecdsa::Signature{signature.r, *curve->order()}));
+        RC_ASSERT(!ecdsa::verify(ecdsa::generate_key(curve).public_key, digest, signature));
+    });
+
+    rc::check("test batch verification finds exactly the invalid signatures",
+              []() {
+        const auto curve = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256());
+        const auto n = *rc::gen::inRange<std::size_t>(0, 20);
+
+        std::vector<std::vector<std::uint8_t>> digests;
+        digests.reserve(n);
+        std::vector<ecdsa::BatchEntry> entries;
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto [d, q] = ecdsa::generate_key(curve);
+            const auto &digest = digests.emplace_back(arbitrary_digest());
+            auto signature = ecdsa::sign(curve, d, digest);
+
+            // Corrupt some signatures, and flip or drop the recovery parity of some valid ones, which must still pass.
+            switch (*rc::gen::inRange(0, 8)) {
+                case 0:
+                    signature.s += BigInt{1};
+                    expected.push_back(i);
+                    break;
+                case 1:
+                    signature.r = BigInt{0};
+                    expected.push_back(i);
+                    break;
+                case 2:
+                    signature.odd_y = !*signature.odd_y;
+                    break;
+                case 3:
+                    signature.odd_y.reset();
+                    break;
+                default:
+                    break;
+            }
+            entries.push_back(ecdsa::BatchEntry{digest, signature, q});
+        }
+        RC_ASSERT(ecdsa::verify_batch(entries) == expected);
+    });
+
+    rc::check("test parallel batch verification finds exactly the invalid signatures",
+              []() {
+        // Enough signatures to be split into sub-batches, signed once and then corrupted differently on
+        // each run.
+        static const auto signed_batch = [] {
+            const auto &curve = secp112r1();
+            const auto keys = ecdsa::generate_keys(curve, 8);
+            std::vector<std::vector<std::uint8_t>> digests;
+            std::vector<ecdsa::BatchEntry> entries;
+            for (std::size_t i = 0; i < 260; ++i)
+                digests.push_back(std::vector<std::uint8_t>(32, static_cast<std::uint8_t>(i)));
+            for (std::size_t i = 0; i < digests.size(); ++i) {
+                const auto &[d, q] = keys[i % keys.size()];
+                entries.push_back(ecdsa::BatchEntry{digests[i], ecdsa::sign(curve, d, digests[i]), q});
+            }
+            return std::make_pair(std::move(digests), std::move(entries));
+        }();
+
+        auto entries = signed_batch.second;
+        std::vector<std::size_t> expected;
+        for (auto bad = *rc::gen::inRange(0, 3); bad > 0; --bad)
+            expected.push_back(*rc::gen::inRange<std::size_t>(0, entries.size()));
+        std::sort(expected.begin(), expected.end());
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+        for (const auto i: expected)
+            entries[i].signature.s += BigInt{1};
+
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        RC_ASSERT(ecdsa::verify_batch_parallel(entries, pool) == expected);
+    });
+
+    rc::check("test generated keys are distinct and match their private keys",
+              []() {
+        const auto &curve = curves::p256();
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        const auto keys = ecdsa::generate_keys(curve, *rc::gen::inRange<std::size_t>(0, 40), pool);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            RC_ASSERT(ecdsa::public_key(curve, keys[i].private_key) == keys[i].public_key);
+            for (std::size_t j = 0; j < i; ++j)
+                RC_ASSERT(keys[i].private_key != keys[j].private_key);
+        }
+    });
+
+    rc::check("test Shamir's trick agrees with separate multiplications",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto q = *rc::gen::element<int>(0, 1, 2) == 0 ? -p : *rc::arbitraryPoint(curve);
+        const auto k0 = *rc::gen::arbitrary<BigInt>();
+        const auto k1 = *rc::gen::element<BigInt>(BigInt{0}, -k0, *rc::gen::arbitrary<BigInt>());
+        RC_ASSERT(msm::shamir(k0, p, k1, q).to_affine() == p * k0 + q * k1);
+    });
+
+    rc::check("test invalid keys and curves are rejected",
+              []() {
+        const auto &curve = curves::secp256k1();
+        const std::vector<std::uint8_t> digest(32, 0);
+        RC_ASSERT_THROWS_AS((void)ecdsa::public_key(curve, BigInt{0}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ecdsa::sign(curve, *curve->order(), digest), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ecdsa::sign(curve, BigInt{1}, digest, BigInt{0}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ecdsa::generate_key(*rc::arbitraryCurve()), std::domain_error);
+
+        // y^2 = x^3 + x + 1 mod 23 has 28 points, and (5, 4) has order 7, so the cofactor is 4. The curve does not
+        // qualify for constant time, which must fail once rather than have every nonce retried.
+        const auto even = EllipticCurve::create(BigInt{1}, BigInt{1}, BigInt{23}, BigInt{5}, BigInt{4}, BigInt{7},
+                                                BigInt{4});
+        RC_ASSERT_THROWS_AS((void)ecdsa::sign(even, BigInt{4}, digest, ecdsa::Mode::CONSTANT_TIME), std::domain_error);
+    });
+
+    return 0;
+}
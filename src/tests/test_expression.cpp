@@ -0,0 +1,72 @@
+/**
+ * test_expression.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <stdexcept>
+
+#include <rapidcheck.h>
+#include <big_int.h>
+#include <expression.h>
+#include <modular_int.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+using expr::lazy;
+
+int main() {
+    rc::check("test ModularInt expressions agree with the operators",
+              [](const ModularInt &x) {
+        const auto y = rc::randomElement(x.get_field());
+        const auto z = rc::randomElement(x.get_field());
+
+        const ModularInt sum = lazy(x) + y - z;
+        RC_ASSERT(sum == x + y - z);
+
+        const ModularInt product = lazy(x) * y * z;
+        RC_ASSERT(product == x * y * z);
+
+        // Products of sums and of products, which are reduced before they are multiplied again.
+        const ModularInt nested = (lazy(x) * y - z) * (lazy(y) + z) * (lazy(x) * x);
+        RC_ASSERT(nested == (x * y - z) * (y + z) * (x * x));
+
+        const ModularInt multiples = lazy(x) * 3 - 8 * (lazy(y) * z) + -lazy(z);
+        RC_ASSERT(multiples == x + x + x - (y * z + y * z + y * z + y * z + y * z + y * z + y * z + y * z) - z);
+
+        // The results are reduced, so they compare equal as values too.
+        RC_ASSERT(nested.get_value() < nested.get_mod());
+        RC_ASSERT(!(multiples.get_value() < 0));
+    });
+
+    rc::check("test an expression can be assigned into one of its operands",
+              [](const ModularInt &x) {
+        const auto y = rc::randomElement(x.get_field());
+        auto acc = x;
+        for (int i = 0; i < 5; ++i)
+            expr::assign(acc, lazy(acc) * acc - y * lazy(acc));
+
+        auto expected = x;
+        for (int i = 0; i < 5; ++i)
+            expected = expected * expected - y * expected;
+        RC_ASSERT(acc == expected);
+    });
+
+    rc::check("test ModularInt expressions reject mixed fields",
+              [](const ModularInt &x, const ModularInt &y) {
+        RC_PRE(x.get_field() != y.get_field());
+        RC_ASSERT_THROWS_AS((void)expr::evaluate(lazy(x) + y), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)expr::evaluate(lazy(x) * x * y), std::domain_error);
+    });
+
+    rc::check("test BigInt expressions agree with the operators",
+              [](const BigInt &a, const BigInt &b, const BigInt &c) {
+        const BigInt result = (lazy(a) * b - c) * (lazy(c) + a) * 5 + -lazy(b);
+        RC_ASSERT(result == (a * b - c) * (c + a) * BigInt{5} - b);
+
+        auto acc = a;
+        expr::assign(acc, lazy(b) - acc * lazy(acc));
+        RC_ASSERT(acc == b - a * a);
+    });
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * test_fixed_base_pow.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <rapidcheck.h>
+#include <big_int.h>
+#include <fixed_base_pow.h>
+#include <modular_int.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Moduli of one limb, and several limbs.
+static const auto bit_sizes = rc::gen::element<mp_bitcnt_t>(64, 127, 256, 521);
+
+int main() {
+    rc::check("test fixed-base exponentiation agrees with pow",
+              []() {
+        const auto b = *rc::arbitraryModularInt(*bit_sizes);
+        const auto width = *rc::gen::inRange(FixedBasePow::min_width, 9u);
+        const FixedBasePow table{b, 256, width};
+
+        // Include the edge cases 0 and 2^256 - 1, where every digit is used.
+        const BigInt all_ones{"115792089237316195423570985008687907853269984665640564039457584007913129639935"};
+        const auto e = *rc::gen::element<BigInt>(BigInt{0}, all_ones, *rc::gen::arbitrary<BigInt>());
+        RC_PRE(!(e < 0));
+        RC_ASSERT(table.pow(e) == b.pow(e));
+    });
+
+    rc::check("test fixed-base exponentiation of zero and one",
+              []() {
+        const auto b = *rc::arbitraryModularInt(*bit_sizes);
+        const auto e = *rc::gen::inRange(1, 1 << 16);
+        const FixedBasePow zero{ModularInt{0, b.get_field()}, 16};
+        const FixedBasePow one{ModularInt{1, b.get_field()}, 16};
+        RC_ASSERT(zero.pow(BigInt{e}).get_value().zero());
+        RC_ASSERT(zero.pow(BigInt{0}) == ModularInt(1, b.get_field()));
+        RC_ASSERT(one.pow(BigInt{e}) == ModularInt(1, b.get_field()));
+    });
+
+    rc::check("test fixed-base exponentiation rejects bad input",
+              []() {
+        const auto b = *rc::arbitraryModularInt(64);
+        RC_ASSERT_THROWS_AS(FixedBasePow(b, 64, FixedBasePow::min_width - 1), std::domain_error);
+        RC_ASSERT_THROWS_AS(FixedBasePow(b, 64, FixedBasePow::max_width + 1), std::domain_error);
+        RC_ASSERT_THROWS_AS(FixedBasePow(ModularInt(1, BigInt{1024}), 64), std::domain_error);
+
+        const FixedBasePow table{b, 16, 4};
+        RC_ASSERT(table.size() == 4 * 15);
+        RC_ASSERT_THROWS_AS((void)table.pow(BigInt{-1}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)table.pow(BigInt{1 << 16}), std::domain_error);
+
+        // A table for 0-bit exponents is empty, and only raises to 0.
+        const FixedBasePow empty{b, 0};
+        RC_ASSERT(empty.size() == 0);
+        RC_ASSERT(empty.pow(BigInt{0}) == ModularInt(1, b.get_field()));
+        RC_ASSERT_THROWS_AS((void)empty.pow(BigInt{1}), std::domain_error);
+    });
+
+    return 0;
+}
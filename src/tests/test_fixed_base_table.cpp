@@ -0,0 +1,83 @@
+/**
+ * test_fixed_base_table.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <memory>
+
+#include <rapidcheck.h>
+#include <elliptic_curve.h>
+#include <fixed_base_table.h>
+#include <jacobian_point.h>
+#include <named_curves.h>
+#include <point.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+int main() {
+    rc::check("test fixed-base multiplication agrees with variable-base multiplication",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        RC_PRE(!p.is_infinity());
+        const auto width = *rc::gen::inRange(FixedBaseTable::min_width, 9u);
+        const FixedBaseTable table{p, 64, width};
+
+        // Include the edge cases 0 and 2^64 - 1, where the final carry is used.
+        const auto k = *rc::gen::element<BigInt>(BigInt{0}, BigInt{"18446744073709551615"},
+                                                 *rc::gen::arbitrary<BigInt>());
+        RC_ASSERT(table.multiply(k).to_affine() == p * k);
+    });
+
+    rc::check("test fixed-base tables reject bad input",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        RC_PRE(!p.is_infinity());
+        RC_ASSERT_THROWS_AS(FixedBaseTable(p, 64, FixedBaseTable::min_width - 1), std::domain_error);
+        RC_ASSERT_THROWS_AS(FixedBaseTable(p, 64, FixedBaseTable::max_width + 1), std::domain_error);
+        RC_ASSERT_THROWS_AS(FixedBaseTable(curve->infinity(), 64), std::domain_error);
+
+        const FixedBaseTable table{p, 16, 4};
+        RC_ASSERT_THROWS_AS((void)table.multiply(BigInt{-1}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)table.multiply(BigInt{1 << 16}), std::domain_error);
+    });
+
+    rc::check("test generator multiplication on named curves",
+              []() {
+        for (const auto &curve: {curves::secp256k1(), curves::p256()}) {
+            const auto g = curve->generator();
+            const auto k = *rc::gen::arbitrary<BigInt>();
+            RC_ASSERT(curve->multiply_generator(k) == g * k);
+            RC_ASSERT(curve->multiply_generator(-k) == g * -k);
+            RC_ASSERT(curve->multiply_generator(*curve->order()).is_infinity());
+            RC_ASSERT(curve->multiply_generator(*curve->order() - BigInt{1}) == -g);
+            RC_ASSERT(&curve->precompute_generator(4) == &curve->precompute_generator(8));
+        }
+    });
+
+    rc::check("test a curve's generator table does not keep the curve alive",
+              []() {
+        const auto named = *rc::gen::element<std::shared_ptr<const EllipticCurve>>(curves::secp256k1(), curves::p256());
+        const auto g = named->generator();
+        auto curve = EllipticCurve::create(named->a().get_value(), named->b().get_value(), named->get_mod(),
+                                           g.x().get_value(), g.y().get_value(), *named->order(), *named->cofactor());
+        const auto k = *rc::gen::arbitrary<BigInt>();
+        RC_ASSERT(curve->multiply_generator(k) == curve->generator() * k);
+
+        const std::weak_ptr<const EllipticCurve> weak = curve;
+        curve.reset();
+        RC_ASSERT(weak.expired());
+    });
+
+    rc::check("test curves without generators have no generator table",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        RC_ASSERT(!curve->has_generator());
+        RC_ASSERT_THROWS_AS((void)curve->generator(), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)curve->multiply_generator(BigInt{1}), std::domain_error);
+    });
+
+    return 0;
+}
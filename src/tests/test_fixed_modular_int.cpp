@@ -0,0 +1,65 @@
+/**
+ * test_fixed_modular_int.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <rapidcheck.h>
+#include <fixed_modular_int.h>
+#include <modular_int.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// The arithmetic is usable at compile time.
+static constexpr FixedField<1> f13{{13}};
+static constexpr FixedModularInt<1> five{fixed::Limbs<1>{5}, f13};
+static_assert((five * five).limbs()[0] == 12);
+static_assert((five + five + five).limbs()[0] == 2);
+static_assert((five - five * five).limbs()[0] == 6);
+static_assert(five.pow(12).limbs()[0] == 1);
+
+// Check that FixedModularInt<N> agrees with ModularInt for primes of the given number of bits.
+template <std::size_t N>
+void check_agrees(mp_bitcnt_t bits) {
+    rc::check("test arithmetic agrees with ModularInt for " + std::to_string(bits) + " bits",
+              [bits]() {
+        const auto m1 = *rc::arbitraryModularInt(bits);
+        const ModularInt m2{*rc::gen::arbitrary<BigInt>() * *rc::gen::arbitrary<BigInt>(), m1.get_field()};
+        const FixedModularInt<N> f1{m1};
+        const FixedModularInt<N> f2{m2};
+
+        RC_ASSERT(f1.to_modular_int() == m1);
+        RC_ASSERT((f1 + f2).to_modular_int() == m1 + m2);
+        RC_ASSERT((f1 - f2).to_modular_int() == m1 - m2);
+        RC_ASSERT((f1 * f2).to_modular_int() == m1 * m2);
+        RC_ASSERT((-f1).to_modular_int() == -m1);
+        RC_ASSERT(f1.pow(m2.get_value()).to_modular_int() == m1.pow(m2.get_value()));
+
+        const auto inv = f1.invert();
+        RC_ASSERT(inv.has_value() == m1.invert().has_value());
+        if (inv.has_value())
+            RC_ASSERT((f1 * *inv).get_value() == 1);
+
+        const auto root = f1.sqrt();
+        RC_ASSERT(root.has_value() == m1.residue());
+        if (root.has_value())
+            RC_ASSERT(*root * *root == f1);
+    });
+}
+
+int main() {
+    check_agrees<1>(64);
+    check_agrees<2>(127);
+    check_agrees<4>(256);
+    check_agrees<6>(384);
+    check_agrees<9>(521);
+
+    rc::check("test string_view constructor",
+              [](const ModularInt &m) {
+        RC_PRE(m.get_mod().check_bit(0));
+        const FixedModularInt<1> f{m.to_string()};
+        RC_ASSERT(f.to_string() == m.to_string());
+    });
+
+    return 0;
+}
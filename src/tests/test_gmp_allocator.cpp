@@ -0,0 +1,246 @@
+/**
+ * test_gmp_allocator.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <rapidcheck.h>
+#include <big_int.h>
+#include <ecdsa.h>
+#include <expression.h>
+#include <gmp_allocator.h>
+#include <modular_int.h>
+#include <named_curves.h>
+#include <prime_field.h>
+
+// This must come before anything allocates through GMP, which includes the random state that the generators set up
+// during static initialization.
+static const bool installed = (ecc::install_gmp_allocator(), true);
+
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Run the operation in an ArenaScope on a new thread, whose per-thread storage has not grown yet, and then again
+// after handing the arena's memory out to others, and determine whether it wrote into that memory.
+static bool clobbers_freed_arena(const std::function<void()> &operation) {
+    bool clobbered = false;
+    std::thread worker{[&] {
+        {
+            ArenaScope arena;
+            operation();
+        }
+        std::vector<std::vector<std::uint8_t>> clutter;
+        for (int i = 0; i < 16; ++i)
+            clutter.emplace_back(64 * 1024, std::uint8_t{0xa5});
+        for (int i = 0; i < 10; ++i)
+            operation();
+        for (const auto &block: clutter)
+            clobbered = clobbered || std::any_of(block.begin(), block.end(), [](auto b) { return b != 0xa5; });
+    }};
+    worker.join();
+    return clobbered;
+}
+
+int main() {
+    if (!installed || !gmp_allocator_installed())
+        return 1;
+
+    rc::check("test arithmetic is unaffected by the pools",
+              [](const BigInt &a, const BigInt &b) {
+        // Products grow blocks from one size class to the next, and past the largest.
+        auto product = a;
+        for (int i = 0; i < 40; ++i)
+            product *= b + BigInt{i};
+        for (int i = 40; i-- > 0;)
+            product /= b + BigInt{i};
+        RC_PRE(!(b < 0) && !b.zero());
+        RC_ASSERT(product == a);
+        RC_ASSERT(BigInt{(a + b).to_string()} - b == a);
+    });
+
+    rc::check("test the hot path takes nothing from the system once the pools are warm",
+              [](const ModularInt &x) {
+        const auto y = rc::randomElement(x.get_field());
+        auto acc = x;
+        for (int i = 0; i < 10; ++i)
+            acc = acc * y + x;
+        const auto before = allocation_stats();
+        for (int i = 0; i < 100; ++i)
+            acc = acc * y + x;
+        const auto used = allocation_stats() - before;
+        RC_ASSERT(used.allocations > 0);
+        RC_ASSERT(used.frees > 0);
+        RC_ASSERT(used.system_allocations == 0);
+        // Growing a block past its size class takes another from the pools too.
+        RC_ASSERT(used.pool_hits >= used.allocations);
+    });
+
+    rc::check("test field arithmetic does not reallocate once warm",
+              []() {
+        const auto x = *rc::arbitraryModularInt(*rc::gen::inRange<mp_bitcnt_t>(8, 1024));
+        const auto y = rc::randomElement(x.get_field());
+        auto acc = x;
+        const auto run = [&] {
+            acc = acc * y + x;
+            acc -= y;
+            acc *= x;
+            acc += acc.pow(BigInt{65537});
+            if (const auto inverse = acc.invert(); inverse.has_value())
+                acc *= *inverse;
+            if (const auto root = (acc * acc).sqrt(); root.has_value())
+                acc = *root - y;
+        };
+        // Warming up includes the square root data that the field calculates on first use.
+        (void)ModularInt{1, x.get_field()}.sqrt();
+        run();
+        const auto before = allocation_stats();
+        for (int i = 0; i < 10; ++i)
+            run();
+        const auto used = allocation_stats() - before;
+        RC_ASSERT(used.reallocations == 0);
+    });
+
+    rc::check("test arenas hold temporaries and leave earlier values in place",
+              [](const BigInt &a, const BigInt &b) {
+        RC_PRE(!(b < 0) && !b.zero());
+        const auto a_abs = a < 0 ? -a : a;
+        BigInt expected = a_abs;
+        for (int i = 0; i < 20; ++i)
+            expected *= b;
+        std::vector<std::uint8_t> expected_bytes(expected.byte_size());
+        expected.to_bytes(expected_bytes);
+
+        const auto before = allocation_stats();
+        std::vector<std::uint8_t> result(expected.byte_size());
+        {
+            ArenaScope arena;
+            std::vector<BigInt> temporaries{a_abs};
+            for (int i = 0; i < 20; ++i)
+                temporaries.push_back(temporaries.back() * b);
+            {
+                ArenaScope inner;
+                const auto square = temporaries.back() * temporaries.back();
+                RC_ASSERT(square / temporaries.back() == temporaries.back());
+            }
+            temporaries.back().to_bytes(result);
+            RC_ASSERT(arena.reserved() > 0);
+        }
+        const auto used = allocation_stats() - before;
+        RC_ASSERT(used.arena_allocations > 0);
+        RC_ASSERT(result == expected_bytes);
+
+        // The values from before the scope are intact, and can still be used.
+        RC_ASSERT(expected / b == BigInt::from_bytes(expected_bytes) / b);
+        RC_ASSERT(a_abs * b * b == (a_abs * b) * b);
+    });
+
+    rc::check("test suspending an arena takes blocks from the pools",
+              [](const BigInt &a) {
+        RC_PRE(!a.zero());
+        ArenaScope arena;
+        const auto before = allocation_stats();
+        std::vector<BigInt> kept;
+        {
+            const ArenaSuspension suspension;
+            kept.push_back(a * a * a);
+        }
+        const auto suspended = allocation_stats() - before;
+        RC_ASSERT(suspended.allocations > 0);
+        RC_ASSERT(suspended.arena_allocations == 0);
+
+        // The scope resumes afterwards.
+        kept.push_back(a * a * a);
+        RC_ASSERT((allocation_stats() - before).arena_allocations > 0);
+    });
+
+    rc::check("test the library's caches built in an arena outlive it",
+              []() {
+        // P-224, for which p = 1 (mod 8), so square roots use the tables of the windowed Tonelli and Shanks. No other
+        // value refers to the field, so it and its tables are made afresh in the scope.
+        const BigInt p224{"26959946667150639794667015087019630673557916260026308143510066298881"};
+        const auto x = *rc::gen::inRange(2L, 1L << 30);
+        std::shared_ptr<const PrimeField> field;
+        {
+            ArenaScope arena;
+            field = PrimeField::get(p224);
+            const ModularInt y{x, field};
+            RC_ASSERT((y * y).sqrt().has_value());
+        }
+
+        // Hand the arena's memory out again, and fill it, before using the tables.
+        std::vector<std::vector<std::uint8_t>> clutter;
+        for (int i = 0; i < 16; ++i)
+            clutter.emplace_back(64 * 1024, std::uint8_t{0xa5});
+
+        const ModularInt y{x, field};
+        const auto root = (y * y).sqrt();
+        RC_ASSERT(root.has_value());
+        RC_ASSERT(*root * *root == y * y);
+        RC_ASSERT(PrimeField::get(p224) == field);
+    });
+
+    rc::check("test the per-thread scratch first grown in an arena outlives it",
+              [](const ModularInt &x) {
+        bool agrees = true;
+        RC_ASSERT(!clobbers_freed_arena([&] {
+            agrees = agrees && (x * x).get_value() == x.get_value() * x.get_value() % x.get_mod();
+        }));
+        RC_ASSERT(agrees);
+    });
+
+    rc::check("test the per-thread expression slots first grown in an arena outlive them",
+              [](const ModularInt &x, const BigInt &a) {
+        bool agrees = true;
+        RC_ASSERT(!clobbers_freed_arena([&] {
+            const ModularInt m = expr::lazy(x) * x + x;
+            const BigInt b = expr::lazy(a) * a - a;
+            agrees = agrees && m == x * x + x && b == a * a - a;
+        }));
+        RC_ASSERT(agrees);
+    });
+
+    rc::check("test the batch coefficient bound first made in an arena outlives it",
+              []() {
+        // The bound is made by the first batch in the process, which must be this one, inside the arena.
+        const auto &curve = curves::secp256k1();
+        const auto key = ecdsa::generate_key(curve);
+        std::vector<std::vector<std::uint8_t>> digests;
+        std::vector<ecdsa::BatchEntry> entries;
+        for (std::uint8_t i = 0; i < 4; ++i)
+            digests.push_back(std::vector<std::uint8_t>(32, i));
+        for (const auto &digest: digests)
+            entries.push_back({digest, ecdsa::sign(curve, key.private_key, digest), key.public_key});
+
+        bool valid = true;
+        RC_ASSERT(!clobbers_freed_arena([&] {
+            valid = valid && ecdsa::verify_batch(entries).empty();
+        }));
+        RC_ASSERT(valid);
+    });
+
+    rc::check("test values can be freed on another thread",
+              []() {
+        std::vector<BigInt> values;
+        for (auto n = *rc::gen::inRange(0, 100); n > 0; --n)
+            values.push_back(*rc::gen::arbitrary<BigInt>());
+        std::vector<BigInt> squares;
+        std::thread worker{[&] {
+            for (const auto &v: values)
+                squares.push_back(v * v);
+        }};
+        worker.join();
+        RC_ASSERT(squares.size() == values.size());
+        for (std::size_t i = 0; i < values.size(); ++i)
+            RC_ASSERT(squares[i] == values[i] * values[i]);
+        squares.clear();
+    });
+
+    return 0;
+}
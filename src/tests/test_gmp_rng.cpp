@@ -0,0 +1,65 @@
+/**
+ * test_gmp_rng.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <rapidcheck.h>
+#include <big_int.h>
+#include <gmp_rng.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+using namespace ecc::gmp;
+
+int main() {
+    rc::check("test bulk random residues are in range",
+              []() {
+        // Moduli from one bit up to several limbs, including exact powers of two, where the mask keeps every bit.
+        const auto bits = *rc::gen::inRange<unsigned long>(1, 600);
+        BigInt mod{1};
+        for (unsigned long i = 0; i < bits; ++i)
+            mod *= BigInt{2};
+        if (*rc::gen::arbitrary<bool>())
+            mod += *rc::gen::arbitrary<BigInt>();
+
+        const auto count = *rc::gen::inRange<std::size_t>(0, 300);
+        const auto residues = gmp_rng::local().random_mod(mod, count);
+        RC_ASSERT(residues.size() == count);
+        for (const auto &r: residues)
+            RC_ASSERT(!(r < BigInt{0}) && r < mod);
+    });
+
+    rc::check("test bulk random residues cover a small range",
+              []() {
+        const auto mod = *rc::gen::inRange<long>(1, 20);
+        std::vector<bool> seen(static_cast<std::size_t>(mod));
+        for (const auto &r: gmp_rng::local().random_mod(BigInt{mod}, 1000))
+            seen[static_cast<std::size_t>(mpz_get_si(static_cast<const mpz_t&>(r)))] = true;
+        for (const auto s: seen)
+            RC_ASSERT(s);
+    });
+
+    rc::check("test bulk random residues reject a non-positive modulus",
+              []() {
+        RC_ASSERT_THROWS_AS((void)gmp_rng::local().random_mod(BigInt{0}, 1), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)gmp_rng::local().random_mod(BigInt{-5}, 1), std::domain_error);
+    });
+
+    rc::check("test threads have independently seeded generators",
+              []() {
+        // Two 256-bit draws agree with probability 2^-256 unless the generators share a seed.
+        const BigInt mod{"115792089237316195423570985008687907853269984665640564039457584007913129639936"};
+        const auto here = gmp_rng::local().random_mod(mod);
+        BigInt there;
+        std::thread{[&] { there = gmp_rng::local().random_mod(mod); }}.join();
+        RC_ASSERT(here != there);
+        RC_ASSERT(gmp_rng{}.random_mod(mod) != gmp_rng{}.random_mod(mod));
+    });
+
+    return 0;
+}
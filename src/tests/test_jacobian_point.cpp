@@ -0,0 +1,143 @@
+/**
+ * test_jacobian_point.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <vector>
+
+#include <rapidcheck.h>
+#include <elliptic_curve.h>
+#include <jacobian_point.h>
+#include <named_curves.h>
+#include <point.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Curves with a random a, with a = 0, and with a = -3, to exercise each of the doubling formulas.
+static auto test_curves() {
+    return rc::gen::exec([]() {
+        switch (*rc::gen::inRange(0, 3)) {
+            case 0:
+                return *rc::arbitraryCurve();
+            case 1:
+                return *rc::arbitraryCurve(64, BigInt{0});
+            default:
+                return *rc::arbitraryCurve(64, BigInt{-3});
+        }
+    });
+}
+
+int main() {
+    rc::check("test curve coefficient classification",
+              []() {
+        RC_ASSERT((*rc::arbitraryCurve(64, BigInt{0}))->a_type() == EllipticCurve::CoefficientA::ZERO);
+        RC_ASSERT((*rc::arbitraryCurve(64, BigInt{-3}))->a_type() == EllipticCurve::CoefficientA::MINUS_THREE);
+    });
+
+    rc::check("test round trip through Jacobian coordinates",
+              []() {
+        const auto curve = *test_curves();
+        const auto p = *rc::arbitraryPoint(curve);
+        const JacobianPoint jp{p};
+        RC_ASSERT(jp.on_curve());
+        RC_ASSERT(jp.to_affine() == p);
+        RC_ASSERT(JacobianPoint{curve->infinity()}.is_infinity());
+        RC_ASSERT(JacobianPoint::infinity(curve).to_affine() == curve->infinity());
+    });
+
+    rc::check("test batch conversion to affine coordinates",
+              []() {
+        const auto curve = *test_curves();
+        const auto p = *rc::arbitraryPoint(curve);
+        std::vector<JacobianPoint> points{JacobianPoint::infinity(curve)};
+        for (auto i = 0; i < 20; ++i)
+            points.push_back(points.back() + p);
+        points.push_back(JacobianPoint::infinity(curve));
+
+        const auto affine = JacobianPoint::to_affine(points);
+        RC_ASSERT(affine.size() == points.size());
+        for (std::size_t i = 0; i < points.size(); ++i)
+            RC_ASSERT(affine[i] == points[i].to_affine());
+    });
+
+    rc::check("test Jacobian arithmetic agrees with affine arithmetic",
+              []() {
+        const auto curve = *test_curves();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto q = *rc::arbitraryPoint(curve);
+        const JacobianPoint jp{p};
+        const JacobianPoint jq{q};
+
+        // Move jq away from Z = 1 so that full additions see general inputs.
+        const auto jq2 = jq.doubled() - q;
+        RC_ASSERT(jq2 == jq);
+
+        RC_ASSERT(jp.doubled().on_curve());
+        RC_ASSERT(jp.doubled().to_affine() == p.doubled());
+        RC_ASSERT((jp + jq2).to_affine() == p + q);
+        RC_ASSERT((jp - jq2).to_affine() == p - q);
+        RC_ASSERT((jq2 + p).to_affine() == p + q);
+        RC_ASSERT((jp + p).to_affine() == p.doubled());
+        RC_ASSERT((jp + jq2.doubled()).to_affine() == p + q.doubled());
+        RC_ASSERT((jp - p).is_infinity());
+        RC_ASSERT((jq2 - jq).is_infinity());
+        RC_ASSERT(jq2 + jq == jq.doubled());
+        RC_ASSERT(jp + JacobianPoint::infinity(curve) == jp);
+
+        auto s = jp;
+        s += q;
+        s += jq2;
+        s -= p;
+        s -= jp;
+        RC_ASSERT(s.to_affine() == q.doubled() - p);
+    });
+
+    rc::check("test scalar multiplication agrees with repeated addition",
+              []() {
+        const auto curve = *test_curves();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto k = *rc::gen::inRange(0, 64);
+
+        auto expected = curve->infinity();
+        for (auto i = 0; i < k; ++i)
+            expected += p;
+        RC_ASSERT(p * BigInt{k} == expected);
+        RC_ASSERT((JacobianPoint{p} * BigInt{k}).to_affine() == expected);
+        RC_ASSERT(p * BigInt{-k} == -expected);
+    });
+
+    rc::check("test every wNAF width gives the same product",
+              []() {
+        const auto curve = *test_curves();
+        const JacobianPoint p{*rc::arbitraryPoint(curve)};
+        const auto k = *rc::gen::arbitrary<BigInt>();
+        const auto expected = p.multiply(k, 2);
+        for (unsigned width = 3; width <= 8; ++width)
+            RC_ASSERT(p.multiply(k, width) == expected);
+        RC_ASSERT(p.multiply(-k, 5) == -expected);
+        RC_ASSERT(JacobianPoint::infinity(curve).multiply(k, 4).is_infinity());
+    });
+
+    rc::check("test named curve generators have the stated order",
+              []() {
+        for (const auto &curve: {curves::secp256k1(), curves::p256()}) {
+            const auto g = curve->generator();
+            RC_ASSERT(g.on_curve());
+            RC_ASSERT((g * *curve->order()).is_infinity());
+            RC_ASSERT(g * (*curve->order() + BigInt{1}) == g);
+        }
+    });
+
+    rc::check("test scalar multiplication is linear",
+              []() {
+        const auto curve = *test_curves();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto m = *rc::gen::arbitrary<BigInt>();
+        const auto n = *rc::gen::arbitrary<BigInt>();
+        RC_ASSERT(p * (m + n) == p * m + p * n);
+        RC_ASSERT((p * m) * n == p * (m * n));
+    });
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * test_key_store.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <rapidcheck.h>
+#include <elliptic_curve.h>
+#include <key_store.h>
+#include <named_curves.h>
+#include <point.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// A file in the temporary directory, removed when it goes out of scope.
+struct TemporaryFile {
+    std::filesystem::path path;
+
+    TemporaryFile(): path{std::filesystem::temp_directory_path()
+                          / ("test_key_store_" + std::to_string(getpid()) + ".bin")} {}
+    ~TemporaryFile() {
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+};
+
+// Overwrite one byte of the file.
+static void corrupt(const std::filesystem::path &path, std::streamoff offset, char byte) {
+    std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+    file.seekp(offset);
+    file.put(byte);
+}
+
+int main() {
+    rc::check("test field elements round trip",
+              []() {
+        const auto curve = *rc::arbitraryCurve(*rc::gen::element<mp_bitcnt_t>(16, 64, 100, 256));
+        const auto &field = curve->get_field();
+        const auto n = *rc::gen::inRange<std::size_t>(0, 100);
+        std::vector<ModularInt> elements;
+        for (std::size_t i = 0; i < n; ++i)
+            elements.push_back(rc::randomElement(field));
+
+        const TemporaryFile file;
+        KeyStore::write(file.path, field, elements);
+        const auto store = KeyStore::open(file.path);
+        RC_ASSERT(store.kind() == KeyStore::Kind::FIELD_ELEMENTS);
+        RC_ASSERT(store.size() == n);
+        RC_ASSERT(store.get_field() == field);
+        for (std::size_t i = 0; i < n; ++i) {
+            RC_ASSERT(store.element(i) == elements[i]);
+            RC_ASSERT(mpz_cmp(store.element_view(i), static_cast<const mpz_t&>(elements[i].get_value())) == 0);
+        }
+        RC_ASSERT_THROWS_AS((void)store.element(n), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)store.curve(), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)KeyStore::open(file.path, curve), std::domain_error);
+    });
+
+    rc::check("test points round trip and are found in place",
+              []() {
+        const auto curve = *rc::arbitraryCurve(*rc::gen::element<mp_bitcnt_t>(16, 64, 100, 256));
+        const auto n = *rc::gen::inRange<std::size_t>(0, 100);
+        std::vector<Point> points;
+        for (std::size_t i = 0; i < n; ++i)
+            points.push_back(*rc::gen::inRange(0, 10) == 0 ? curve->infinity() : *rc::arbitraryPoint(curve));
+
+        const TemporaryFile file;
+        KeyStore::write(file.path, curve, points);
+        for (const auto &shared: {false, true}) {
+            const auto store = shared ? KeyStore::open(file.path, curve) : KeyStore::open(file.path);
+            RC_ASSERT(store.kind() == KeyStore::Kind::POINTS);
+            RC_ASSERT(store.size() == n);
+            RC_ASSERT(*store.curve() == *curve);
+            RC_ASSERT(!shared || store.curve() == curve);
+            for (std::size_t i = 0; i < n; ++i) {
+                RC_ASSERT(store.is_infinity(i) == points[i].is_infinity());
+                RC_ASSERT(store.point(i) == points[i]);
+                const auto found = store.find(points[i]);
+                RC_ASSERT(found.has_value());
+                RC_ASSERT(points[*found] == points[i]);
+                RC_ASSERT(*found <= i);
+            }
+            RC_ASSERT_THROWS_AS((void)store.element(0), std::domain_error);
+        }
+
+        const auto other = *rc::arbitraryCurve(*rc::gen::element<mp_bitcnt_t>(16, 64, 100, 256));
+        RC_ASSERT_THROWS_AS((void)KeyStore::open(file.path, other), std::domain_error);
+    });
+
+    rc::check("test points not in the store are not found",
+              []() {
+        const auto &curve = curves::secp256k1();
+        const std::vector<Point> points{curve->generator(), curve->generator().doubled()};
+        const TemporaryFile file;
+        KeyStore::write(file.path, curve, points);
+        const auto store = KeyStore::open(file.path, curve);
+        RC_ASSERT(store.find(points[1]) == std::optional<std::size_t>{1});
+        RC_ASSERT(!store.find(-points[1]).has_value());
+        RC_ASSERT(!store.find(curve->infinity()).has_value());
+    });
+
+    rc::check("test malformed stores are rejected",
+              []() {
+        const auto &curve = curves::secp256k1();
+        const std::vector<Point> points{curve->generator()};
+        const TemporaryFile file;
+        RC_ASSERT_THROWS_AS((void)KeyStore::open(file.path), std::system_error);
+
+        // A bad magic number, a bad kind, and a count that disagrees with the length of the file.
+        for (const auto offset: {0, 12, 24}) {
+            KeyStore::write(file.path, curve, points);
+            corrupt(file.path, offset, 'x');
+            RC_ASSERT_THROWS_AS((void)KeyStore::open(file.path), std::domain_error);
+        }
+
+        // A truncated file.
+        KeyStore::write(file.path, curve, points);
+        std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 8);
+        RC_ASSERT_THROWS_AS((void)KeyStore::open(file.path), std::domain_error);
+
+        // Points on a different curve.
+        RC_ASSERT_THROWS_AS(KeyStore::write(file.path, curves::p256(), points), std::domain_error);
+    });
+
+    rc::check("test a store that cannot be written is removed",
+              []() {
+        const auto &curve = curves::secp256k1();
+        const std::vector<Point> points(1000, curve->generator());
+        const TemporaryFile file;
+
+        // Cap the size of files this process may write, so that writing fails with EFBIG rather than SIGXFSZ.
+        const auto limit = *rc::gen::inRange<rlim_t>(0, 64 * 1000);
+        rlimit original{};
+        getrlimit(RLIMIT_FSIZE, &original);
+        const auto handler = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit capped{limit, original.rlim_max};
+        setrlimit(RLIMIT_FSIZE, &capped);
+        bool threw = false;
+        try {
+            KeyStore::write(file.path, curve, points);
+        } catch (const std::system_error&) {
+            threw = true;
+        }
+        setrlimit(RLIMIT_FSIZE, &original);
+        std::signal(SIGXFSZ, handler);
+
+        RC_ASSERT(threw);
+        RC_ASSERT(!std::filesystem::exists(file.path));
+    });
+
+    return 0;
+}
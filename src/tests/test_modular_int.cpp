@@ -9,6 +9,9 @@
 #include <printable.h>
 #endif
 
+#include <cstdint>
+#include <vector>
+
 #include <rapidcheck.h>
 #include <operations.h>
 #include <modular_int.h>
@@ -31,6 +34,35 @@ int main() {
         RC_ASSERT(m == m_s);
     });
 
+    rc::check("test a negative modulus gives the field of its absolute value",
+              [](const ModularInt &a) {
+        const auto b = rc::randomElement(a.get_field());
+        const auto &p = a.get_mod();
+        const ModularInt a_neg{a.get_value(), -p};
+        const ModularInt b_neg{b.get_value(), -p};
+        RC_ASSERT(a_neg.get_field() == a.get_field());
+        RC_ASSERT(a_neg + b_neg == a + b);
+        RC_ASSERT(a_neg - b_neg == a - b);
+        RC_ASSERT(a_neg * b_neg == a * b);
+        RC_ASSERT((ModularInt{5, BigInt{-7}} + ModularInt{4, BigInt{-7}}).get_value() == BigInt{2});
+    });
+
+    rc::check("test byte encodings round trip without the modulus",
+              [](const ModularInt &m, bool little) {
+        const auto endian = little ? BigInt::Endian::LITTLE : BigInt::Endian::BIG;
+        const auto &field = m.get_field();
+        std::vector<std::uint8_t> bytes(field->bytes());
+        m.to_bytes(bytes, endian);
+        RC_ASSERT(ModularInt::from_bytes(bytes, field, endian) == m);
+
+        // Wrong lengths and unreduced values are rejected.
+        std::vector<std::uint8_t> longer(field->bytes() + 1);
+        RC_ASSERT_THROWS_AS(m.to_bytes(longer, endian), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)ModularInt::from_bytes(longer, field, endian), std::domain_error);
+        m.get_mod().to_bytes(bytes, endian);
+        RC_ASSERT_THROWS_AS((void)ModularInt::from_bytes(bytes, field, endian), std::domain_error);
+    });
+
     rc::check("test inverse",
               [](const ModularInt &m) {
 #ifdef DEBUG
@@ -67,6 +99,65 @@ int main() {
 #endif
               });
 
+    rc::check("test sqrt for p ≡ 5 (mod 8) and highly 2-adic p",
+              []() {
+        // A prime p = c 2^e + 1 with c odd: e = 2 gives p ≡ 5 (mod 8), e below 8 plain Tonelli and Shanks, and
+        // larger e the field's tables.
+        const auto e = *rc::gen::inRange<int>(2, 90);
+        BigInt power{1};
+        for (auto i = 0; i < e; ++i)
+            power *= BigInt{2};
+        BigInt p;
+        do {
+            p = BigInt{2 * *rc::gen::inRange<long>(1, 1L << 40) + 1} * power + BigInt{1};
+        } while (!p.is_probably_prime(25));
+        const auto field = PrimeField::get(p);
+
+        const auto a = rc::randomElement(field);
+        if (a.get_value().zero()) {
+            RC_ASSERT(!a.sqrt().has_value());
+            return;
+        }
+        const auto root = (a * a).sqrt();
+        RC_ASSERT(root.has_value());
+        RC_ASSERT(*root * *root == a * a);
+        RC_ASSERT(a.sqrt().has_value() == a.residue());
+    });
+
+    rc::check("test compound operators agree with binary operators",
+              [](const ModularInt &m1, const BigInt &b) {
+        const ModularInt m2{b, m1.get_field()};
+        auto m = m1;
+        RC_ASSERT((m += m2) == m1 + m2);
+        RC_ASSERT((m -= m2) == m1);
+        RC_ASSERT((m *= m2) == m1 * m2);
+        RC_ASSERT(m1 + -m1 == ModularInt(0, m1.get_field()));
+        RC_ASSERT((m1 - m2) + m2 == m1);
+    });
+
+    rc::check("test pow by a long agrees with repeated multiplication and inversion",
+              [](const ModularInt &m) {
+        const auto n = *rc::gen::inRange<long>(0, 20);
+        auto expected = ModularInt{1, m.get_field()};
+        for (long i = 0; i < n; ++i)
+            expected *= m;
+        RC_ASSERT(m.pow(n) == expected);
+        RC_ASSERT(m.pow(BigInt{n}) == expected);
+
+        const auto inverse = m.invert();
+        if (inverse.has_value())
+            RC_ASSERT(m.pow(-n) == inverse->pow(n));
+        else
+            RC_ASSERT_THROWS_AS((void)m.pow(-1L), std::domain_error);
+    });
+
+    rc::check("test fields are interned",
+              [](const ModularInt &m) {
+        const ModularInt m2{m.get_value() + 1, BigInt{m.get_mod().to_string()}};
+        RC_ASSERT(m.get_field() == m2.get_field());
+        RC_ASSERT(m.get_field() == PrimeField::get(m.get_mod()));
+    });
+
     rc::check("non-compatible _mod test",
               [](const ModularInt &m1, const ModularInt &m2) {
        RC_PRE(m1.get_mod() != m2.get_mod());
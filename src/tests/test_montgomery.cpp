@@ -0,0 +1,102 @@
+/**
+ * test_montgomery.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <vector>
+
+#include <rapidcheck.h>
+#include <modular_int.h>
+#include <montgomery.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Moduli of one limb, and several limbs, including the curve sizes we care about.
+static const auto bit_sizes = rc::gen::element<mp_bitcnt_t>(64, 127, 256, 384, 521);
+
+int main() {
+    rc::check("test round trip",
+              [](const ModularInt &m) {
+        RC_PRE(m.get_mod().check_bit(0));
+        const MontgomeryInt mm{m};
+        RC_ASSERT(mm.to_modular_int() == m);
+    });
+
+    rc::check("test arithmetic agrees with ModularInt",
+              []() {
+        const auto bits = *bit_sizes;
+        const auto m1 = *rc::arbitraryModularInt(bits);
+        const ModularInt m2{*rc::gen::arbitrary<BigInt>(), m1.get_field()};
+        const MontgomeryInt mm1{m1};
+        const MontgomeryInt mm2{m2};
+
+        RC_ASSERT((mm1 + mm2).to_modular_int() == m1 + m2);
+        RC_ASSERT((mm1 - mm2).to_modular_int() == m1 - m2);
+        RC_ASSERT((mm1 * mm2).to_modular_int() == m1 * m2);
+        RC_ASSERT((-mm1).to_modular_int() == -m1);
+        RC_ASSERT(mm1.pow(m2.get_value()).to_modular_int() == m1.pow(m2.get_value()));
+        RC_ASSERT(mm1.pow(5).to_modular_int() == m1.pow(5));
+    });
+
+    rc::check("test constant-time arithmetic agrees with the variable-time arithmetic",
+              []() {
+        const auto m1 = *rc::arbitraryModularInt(*bit_sizes);
+        const auto m2 = rc::randomElement(m1.get_field());
+        const auto &engine = m1.get_field()->montgomery();
+        const auto n = engine.limbs();
+
+        std::vector<mp_limb_t> a(n), b(n), expected(n), actual(n), scratch(engine.sec_itch());
+        engine.to_montgomery(a.data(), m1.get_value());
+        engine.to_montgomery(b.data(), m2.get_value());
+        engine.add(expected.data(), a.data(), b.data());
+        engine.sec_add(actual.data(), a.data(), b.data());
+        RC_ASSERT(actual == expected);
+        engine.sub(expected.data(), a.data(), b.data());
+        engine.sec_sub(actual.data(), a.data(), b.data());
+        RC_ASSERT(actual == expected);
+        engine.mul(expected.data(), a.data(), b.data());
+        engine.sec_mul(actual.data(), a.data(), b.data(), scratch.data());
+        RC_ASSERT(actual == expected);
+        engine.sqr(expected.data(), a.data());
+        engine.sec_sqr(actual.data(), a.data(), scratch.data());
+        RC_ASSERT(actual == expected);
+
+        // Out of Montgomery form, and back in.
+        engine.sec_from_montgomery(actual.data(), a.data());
+        mpz_t value;
+        mpz_roinit_n(value, actual.data(), static_cast<mp_size_t>(n));
+        RC_ASSERT(BigInt{value} == m1.get_value());
+        engine.sec_to_montgomery(expected.data(), actual.data(), scratch.data());
+        RC_ASSERT(expected == a);
+    });
+
+    rc::check("test inverse",
+              []() {
+        const auto m = *rc::arbitraryModularInt(*bit_sizes);
+        const MontgomeryInt mm{m};
+        const auto inv_opt = mm.invert();
+        RC_PRE(inv_opt.has_value());
+        RC_ASSERT((mm * *inv_opt).get_value() == 1);
+        RC_ASSERT(inv_opt->to_modular_int() == *m.invert());
+    });
+
+    rc::check("test sqrt",
+              []() {
+        const auto m = *rc::arbitraryModularInt(*bit_sizes);
+        RC_PRE(m.residue());
+        const MontgomeryInt mm{m};
+        const auto sqrt_opt = mm.sqrt();
+        RC_ASSERT(sqrt_opt.has_value());
+        RC_ASSERT(*sqrt_opt * *sqrt_opt == mm);
+    });
+
+    rc::check("test non-residue has no sqrt",
+              []() {
+        const auto m = *rc::arbitraryModularInt(*bit_sizes);
+        RC_PRE(m.legendre() == ModularInt::Legendre::NOT_RESIDUE);
+        RC_ASSERT(!MontgomeryInt{m}.sqrt().has_value());
+    });
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * test_multi_pow.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <vector>
+
+#include <rapidcheck.h>
+#include <big_int.h>
+#include <modular_int.h>
+#include <multi_pow.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Random invertible bases over the field, with some zero and negative exponents.
+static auto terms(const ModularInt &first, std::size_t n) {
+    std::vector<ModularInt> bases;
+    std::vector<BigInt> exponents;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto b = i == 0 ? first : rc::randomElement(first.get_field());
+        if (b.get_value().zero())
+            b = ModularInt{1, first.get_field()};
+        bases.push_back(b);
+
+        const auto e = *rc::gen::arbitrary<BigInt>();
+        switch (*rc::gen::inRange(0, 8)) {
+            case 0:
+                exponents.emplace_back(0);
+                break;
+            case 1:
+                exponents.push_back(e < 0 ? e : -e);
+                break;
+            default:
+                exponents.push_back(e < 0 ? -e : e);
+        }
+    }
+    return std::make_pair(bases, exponents);
+}
+
+// The product of the b_i^e_i computed one term at a time.
+static ModularInt naive(const std::vector<ModularInt> &bases, const std::vector<BigInt> &exponents) {
+    ModularInt result{1, bases.front().get_field()};
+    for (std::size_t i = 0; i < bases.size(); ++i)
+        result *= exponents[i] < 0 ? bases[i].invert()->pow(-exponents[i]) : bases[i].pow(exponents[i]);
+    return result;
+}
+
+int main() {
+    rc::check("test multi_pow agrees with the product of the powers",
+              []() {
+        const auto first = *rc::arbitraryModularInt(*rc::gen::element<mp_bitcnt_t>(64, 127, 256, 521));
+        const auto [bases, exponents] = terms(first, *rc::gen::inRange(1, 20));
+        RC_ASSERT(multi_pow(bases, exponents) == naive(bases, exponents));
+    });
+
+    rc::check("test every Straus width agrees",
+              []() {
+        const auto first = *rc::arbitraryModularInt(128);
+        const auto [bases, exponents] = terms(first, *rc::gen::inRange(1, 6));
+        const auto width = *rc::gen::inRange(1u, 9u);
+        RC_ASSERT(multi_exp::straus(bases, exponents, width) == naive(bases, exponents));
+    });
+
+    rc::check("test multi_pow over an even modulus",
+              []() {
+        const ModularInt a{*rc::gen::arbitrary<BigInt>(), BigInt{*rc::gen::inRange(2, 1 << 20) * 2}};
+        const std::vector<ModularInt> bases{a, ModularInt{*rc::gen::arbitrary<BigInt>(), a.get_field()}};
+        const std::vector<BigInt> exponents{BigInt{*rc::gen::inRange(0, 1000)}, BigInt{*rc::gen::inRange(0, 1000)}};
+        RC_ASSERT(multi_pow(bases, exponents) == bases[0].pow(exponents[0]) * bases[1].pow(exponents[1]));
+    });
+
+    rc::check("test multi_pow rejects bad input",
+              []() {
+        const auto a = *rc::arbitraryModularInt(64);
+        const auto b = *rc::arbitraryModularInt(64);
+        const std::vector<BigInt> one{BigInt{1}};
+        const std::vector<BigInt> two{BigInt{1}, BigInt{2}};
+        RC_ASSERT_THROWS_AS((void)multi_pow(std::vector<ModularInt>{}, std::vector<BigInt>{}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)multi_pow(std::vector<ModularInt>{a}, two), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)multi_pow(std::vector<ModularInt>{a, b}, two), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)multi_exp::straus(std::vector<ModularInt>{a}, one, 9), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)multi_pow(std::vector<ModularInt>{ModularInt{0, a.get_field()}},
+                                            std::vector<BigInt>{BigInt{-1}}), std::domain_error);
+    });
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * test_multi_scalar_mul.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <vector>
+
+#include <rapidcheck.h>
+#include <elliptic_curve.h>
+#include <jacobian_point.h>
+#include <multi_scalar_mul.h>
+#include <point.h>
+#include <thread_pool.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+// Random terms, with some negative and zero scalars, and some points at infinity.
+static auto terms(const std::shared_ptr<const EllipticCurve> &curve, std::size_t n) {
+    std::vector<BigInt> scalars;
+    std::vector<Point> points;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto k = *rc::gen::arbitrary<BigInt>();
+        switch (*rc::gen::inRange(0, 8)) {
+            case 0:
+                scalars.emplace_back(0);
+                break;
+            case 1:
+                scalars.push_back(-k);
+                break;
+            default:
+                scalars.push_back(k);
+        }
+        points.push_back(*rc::gen::inRange(0, 10) == 0 ? curve->infinity() : *rc::arbitraryPoint(curve));
+    }
+    return std::make_pair(scalars, points);
+}
+
+// The sum of the k_i P_i computed one term at a time.
+static Point naive(const std::vector<BigInt> &scalars, const std::vector<Point> &points) {
+    auto result = points.front().curve()->infinity();
+    for (std::size_t i = 0; i < points.size(); ++i)
+        result += points[i] * scalars[i];
+    return result;
+}
+
+int main() {
+    rc::check("test multi-scalar multiplication agrees with separate multiplications",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto n = *rc::gen::inRange<std::size_t>(1, 40);
+        const auto [scalars, points] = terms(curve, n);
+        const auto expected = naive(scalars, points);
+
+        RC_ASSERT(multi_scalar_mul(scalars, points) == expected);
+        for (unsigned width = 2; width <= 8; ++width)
+            RC_ASSERT(msm::straus(scalars, points, width).to_affine() == expected);
+        for (unsigned window = 1; window <= 10; ++window)
+            RC_ASSERT(msm::pippenger(scalars, points, window).to_affine() == expected);
+    });
+
+    rc::check("test parallel multi-scalar multiplication agrees with serial multi-scalar multiplication",
+              []() {
+        // Enough terms to be split into chunks, with the points found by addition, which is cheaper than finding
+        // random points.
+        const auto curve = *rc::arbitraryCurve(32);
+        const auto n = *rc::gen::inRange<std::size_t>(1, 700);
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto q = *rc::arbitraryPoint(curve);
+        std::vector<BigInt> scalars;
+        std::vector<Point> points{p};
+        for (std::size_t i = 0; i < n; ++i) {
+            scalars.push_back(*rc::gen::arbitrary<BigInt>());
+            if (i > 0)
+                points.push_back(points.back() + q);
+        }
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        RC_ASSERT(multi_scalar_mul_parallel(scalars, points, pool) == multi_scalar_mul(scalars, points));
+    });
+
+    rc::check("test multi-scalar multiplication with repeated points",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto k = *rc::gen::arbitrary<BigInt>();
+
+        // kP + kP - kP + (-k)(-P) = 2kP exercises the doubling and cancellation cases in the buckets.
+        const std::vector<BigInt> scalars{k, k, k, -k};
+        const std::vector<Point> points{p, p, -p, -p};
+        const auto expected = p * (k + k);
+        RC_ASSERT(multi_scalar_mul(scalars, points) == expected);
+        RC_ASSERT(msm::straus(scalars, points, 4).to_affine() == expected);
+        RC_ASSERT(msm::pippenger(scalars, points, 3).to_affine() == expected);
+    });
+
+    rc::check("test multi-scalar multiplication rejects bad input",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto other = *rc::arbitraryCurve();
+        RC_PRE(!(*curve == *other));
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto q = *rc::arbitraryPoint(other);
+        const std::vector<BigInt> one{BigInt{1}};
+        const std::vector<BigInt> two{BigInt{1}, BigInt{2}};
+
+        RC_ASSERT_THROWS_AS((void)multi_scalar_mul({}, {}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)multi_scalar_mul(two, std::vector<Point>{p}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)multi_scalar_mul(two, std::vector<Point>{p, q}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)msm::straus(one, std::vector<Point>{p}, 1), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)msm::pippenger(one, std::vector<Point>{p}, 0), std::domain_error);
+    });
+
+    rc::check("test the cost model prefers Straus for few terms and Pippenger for many",
+              []() {
+        RC_ASSERT(msm::straus_cost(2, 256, msm::straus_width(2, 256))
+                  < msm::pippenger_cost(2, 256, msm::pippenger_window(2, 256)));
+        RC_ASSERT(msm::straus_cost(1 << 20, 256, msm::straus_width(1 << 20, 256))
+                  > msm::pippenger_cost(1 << 20, 256, msm::pippenger_window(1 << 20, 256)));
+        RC_ASSERT(msm::pippenger_window(1 << 10, 256) < msm::pippenger_window(1 << 20, 256));
+    });
+
+    return 0;
+}
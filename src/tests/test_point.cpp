@@ -0,0 +1,169 @@
+/**
+ * test_point.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <rapidcheck.h>
+#include <elliptic_curve.h>
+#include <named_curves.h>
+#include <point.h>
+#include <thread_pool.h>
+#include "ecc_gens.h"
+
+using namespace ecc;
+
+int main() {
+    rc::check("test known doubling on secp256k1",
+              []() {
+        const BigInt p{"115792089237316195423570985008687907853269984665640564039457584007908834671663"};
+        const auto curve = EllipticCurve::create(0, 7, p);
+        const auto g = curve->point(
+                BigInt{"55066263022277343669578718895168534326250603453777594175500187360389116729240"},
+                BigInt{"32670510020758816978083085130507043184471273380659243275938904335757337482424"});
+        const auto g2 = curve->point(
+                BigInt{"89565891926547004231252920425935692360644145829622209833684329913297188986597"},
+                BigInt{"12158399299693830322967808612713398636155367887041628176798871954788371653930"});
+        RC_ASSERT(g.doubled() == g2);
+        RC_ASSERT(g + g == g2);
+        RC_ASSERT(g2 - g == g);
+    });
+
+    rc::check("test off-curve points are rejected",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        RC_ASSERT_THROWS_AS((void)Point(curve, p.x(), p.y() + ModularInt{1, curve->get_field()}), std::domain_error);
+    });
+
+    rc::check("test identity and inverse",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto o = curve->infinity();
+        RC_ASSERT(p.on_curve());
+        RC_ASSERT(p + o == p);
+        RC_ASSERT(o + p == p);
+        RC_ASSERT(p - p == o);
+        RC_ASSERT((p + -p).is_infinity());
+        RC_ASSERT(-(-p) == p);
+        RC_ASSERT(o.doubled() == o);
+    });
+
+    rc::check("test group laws",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto p = *rc::arbitraryPoint(curve);
+        const auto q = *rc::arbitraryPoint(curve);
+        const auto r = *rc::arbitraryPoint(curve);
+
+        RC_ASSERT((p + q).on_curve());
+        RC_ASSERT(p.doubled().on_curve());
+        RC_ASSERT(p + q == q + p);
+        RC_ASSERT((p + q) + r == p + (q + r));
+        RC_ASSERT(p.doubled() == p + p);
+        RC_ASSERT((p + q) - q == p);
+
+        auto s = p;
+        s += q;
+        s -= p;
+        RC_ASSERT(s == q);
+    });
+
+    rc::check("test points on different curves are incompatible",
+              []() {
+        const auto c1 = *rc::arbitraryCurve();
+        const auto c2 = *rc::arbitraryCurve();
+        RC_PRE(!(*c1 == *c2));
+        RC_ASSERT_THROWS_AS((void)(*rc::arbitraryPoint(c1) + *rc::arbitraryPoint(c2)), std::domain_error);
+    });
+
+    rc::check("test SEC 1 encodings round trip",
+              []() {
+        // Random curves cover both p ≡ 3 (mod 4) and p ≡ 1 (mod 4), which take different square root paths.
+        const auto curve = *rc::arbitraryCurve(*rc::gen::element<mp_bitcnt_t>(16, 64, 100));
+        const auto p = *rc::gen::inRange(0, 10) == 0 ? curve->infinity() : *rc::arbitraryPoint(curve);
+        for (const auto compressed: {true, false}) {
+            const auto bytes = p.encode(compressed);
+            RC_ASSERT(bytes.size() == (p.is_infinity() ? 1 : Point::encoded_size(curve->get_field()->bits(),
+                                                                                 compressed)));
+            RC_ASSERT(Point::decode(curve, bytes) == p);
+        }
+    });
+
+    rc::check("test SEC 1 encodings into a shared buffer agree with encode",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto compressed = *rc::gen::arbitrary<bool>();
+        const auto n = *rc::gen::inRange<std::size_t>(1, 20);
+        std::vector<std::uint8_t> buffer(n * Point::encoded_size(curve->get_field()->bits(), compressed));
+        std::vector<std::uint8_t> expected;
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto p = *rc::arbitraryPoint(curve);
+            offset += p.encode(std::span{buffer}.subspan(offset), compressed);
+            const auto encoding = p.encode(compressed);
+            expected.insert(expected.end(), encoding.begin(), encoding.end());
+        }
+        RC_ASSERT(offset == buffer.size());
+        RC_ASSERT(buffer == expected);
+
+        std::vector<std::uint8_t> shorter(Point::encoded_size(curve->get_field()->bits(), compressed) - 1);
+        RC_ASSERT_THROWS_AS((void)(*rc::arbitraryPoint(curve)).encode(shorter, compressed), std::domain_error);
+    });
+
+    rc::check("test SEC 1 encoding of the secp256k1 generator",
+              []() {
+        const auto &curve = curves::secp256k1();
+        const auto bytes = curve->generator().encode();
+        const std::vector<std::uint8_t> expected{
+            0x02, 0x79, 0xbe, 0x66, 0x7e, 0xf9, 0xdc, 0xbb, 0xac, 0x55, 0xa0, 0x62, 0x95, 0xce, 0x87, 0x0b, 0x07,
+            0x02, 0x9b, 0xfc, 0xdb, 0x2d, 0xce, 0x28, 0xd9, 0x59, 0xf2, 0x81, 0x5b, 0x16, 0xf8, 0x17, 0x98};
+        RC_ASSERT(bytes == expected);
+        RC_ASSERT(Point::decode(curve, bytes) == curve->generator());
+    });
+
+    rc::check("test malformed SEC 1 encodings are rejected",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        auto bytes = (*rc::arbitraryPoint(curve)).encode();
+        RC_ASSERT_THROWS_AS((void)Point::decode(curve, {}), std::domain_error);
+        RC_ASSERT_THROWS_AS((void)Point::decode(curve, std::span{bytes}.first(bytes.size() - 1)), std::domain_error);
+
+        // An uncompressed tag on a compressed length, and an x of all ones, which is not reduced.
+        bytes.front() = 0x04;
+        RC_ASSERT_THROWS_AS((void)Point::decode(curve, bytes), std::domain_error);
+        bytes.front() = 0x02;
+        std::fill(bytes.begin() + 1, bytes.end(), std::uint8_t{0xff});
+        RC_ASSERT_THROWS_AS((void)Point::decode(curve, bytes), std::domain_error);
+
+        // An uncompressed point that is off the curve.
+        auto uncompressed = (*rc::arbitraryPoint(curve)).encode(false);
+        uncompressed.back() ^= 1;
+        RC_ASSERT_THROWS_AS((void)Point::decode(curve, uncompressed), std::domain_error);
+    });
+
+    rc::check("test batch decompression agrees with decoding one at a time",
+              []() {
+        const auto curve = *rc::arbitraryCurve();
+        const auto n = *rc::gen::inRange<std::size_t>(0, 300);
+        std::vector<Point> points;
+        std::vector<std::uint8_t> bytes;
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto &p = points.emplace_back(*rc::arbitraryPoint(curve));
+            const auto encoding = p.encode();
+            bytes.insert(bytes.end(), encoding.begin(), encoding.end());
+        }
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        RC_ASSERT(Point::decompress_batch(curve, bytes, pool) == points);
+
+        if (!bytes.empty()) {
+            bytes.pop_back();
+            RC_ASSERT_THROWS_AS((void)Point::decompress_batch(curve, bytes, pool), std::domain_error);
+        }
+    });
+
+    return 0;
+}
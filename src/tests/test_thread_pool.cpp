@@ -0,0 +1,77 @@
+/**
+ * test_thread_pool.cpp
+ * By Sebastian Raaphorst, 2023.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <rapidcheck.h>
+#include <thread_pool.h>
+
+using namespace ecc;
+
+int main() {
+    rc::check("test parallel_for visits every index exactly once",
+              []() {
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        const auto count = *rc::gen::inRange<std::size_t>(0, 5000);
+        const auto grain = *rc::gen::inRange<std::size_t>(0, 100);
+
+        std::vector<std::atomic<int>> visits(count);
+        pool.parallel_for(count, grain, [&](std::size_t begin, std::size_t end) {
+            RC_ASSERT(begin < end);
+            RC_ASSERT(end <= count);
+            RC_ASSERT(end - begin >= std::min(std::max<std::size_t>(grain, 1), count));
+            for (auto i = begin; i < end; ++i)
+                ++visits[i];
+        });
+        for (const auto &v: visits)
+            RC_ASSERT(v == 1);
+    });
+
+    rc::check("test nested parallel_for does not deadlock",
+              []() {
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 4)};
+        const auto outer = *rc::gen::inRange<std::size_t>(1, 50);
+        const auto inner = *rc::gen::inRange<std::size_t>(1, 50);
+
+        std::atomic<std::size_t> total{0};
+        pool.parallel_for(outer, 1, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i)
+                pool.parallel_for(inner, 1, [&](std::size_t b, std::size_t e) { total += e - b; });
+        });
+        RC_ASSERT(total == outer * inner);
+    });
+
+    rc::check("test parallel_for rethrows an exception after the other tasks finish",
+              []() {
+        ThreadPool pool{*rc::gen::inRange<std::size_t>(1, 8)};
+        const auto count = *rc::gen::inRange<std::size_t>(1, 1000);
+        const auto bad = *rc::gen::inRange<std::size_t>(0, count);
+
+        std::atomic<std::size_t> visited{0};
+        RC_ASSERT_THROWS_AS(pool.parallel_for(count, 1, [&](std::size_t begin, std::size_t end) {
+            visited += end - begin;
+            if (begin <= bad && bad < end)
+                throw std::domain_error("bad index");
+        }), std::domain_error);
+        RC_ASSERT(visited == count);
+
+        // The pool is still usable afterwards.
+        std::atomic<std::size_t> after{0};
+        pool.parallel_for(count, 1, [&](std::size_t begin, std::size_t end) { after += end - begin; });
+        RC_ASSERT(after == count);
+    });
+
+    rc::check("test pool sizes",
+              []() {
+        const auto threads = *rc::gen::inRange<std::size_t>(1, 8);
+        RC_ASSERT(ThreadPool{threads}.size() == threads);
+        RC_ASSERT(ThreadPool::global().size() >= 1);
+    });
+
+    return 0;
+}